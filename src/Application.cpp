@@ -2,11 +2,17 @@
 #include "SimpleRenderSystem.h"
 #include "Camera.h"
 #include "KeyboardInput.h"
-#include "Buffer.h"
+#include "FrameAllocator.h"
+#include "HeightmapCache.h"
+#include "Uploader.h"
 
 // std
+#include <algorithm>
 #include <stdexcept>
 #include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <thread>
 
 //library
 #define GLM_FORCE_RADIANS
@@ -14,6 +20,7 @@
 #include <glm/glm.hpp>
 
 #include "RenderSystem2D.h"
+#include "HeightfieldRenderSystem.h"
 
 namespace lve
 {
@@ -23,6 +30,22 @@ namespace lve
 		glm::vec3 lightDirection = glm::normalize(glm::vec3{1.f, -3.f, -1.f});
 	};
 
+	// the terrain and its flat perlin preview next to it
+	static const glm::vec3 TERRAIN_POSITION{ -5.f, 5.f, 10.f };
+	static const glm::vec3 PREVIEW_POSITION{ -15.f, 5.f, 10.f };
+	// per frame uniform and storage data, handed out by the frame allocator
+	static constexpr VkDeviceSize FRAME_DATA_SIZE{ 1024 * 1024 };
+	static constexpr std::chrono::seconds MEMORY_LOG_INTERVAL{ 10 };
+
+	static ScatterParams CreatePropScatterParams()
+	{
+		ScatterParams params{};
+		params.maxSlope = glm::radians(35.f);
+		// +y points down, this keeps the props off the peaks
+		params.minY = TERRAIN_POSITION.y - 0.2f;
+		return params;
+	}
+
 	Application::Application()
 	{
 		LoadGameObjects();
@@ -34,25 +57,11 @@ namespace lve
 
 	void Application::Run()
 	{
-		std::vector<std::unique_ptr<Buffer>> uboBuffers(SwapChain::MAX_FRAMES_IN_FLIGHT);
-
-		for(int index{}; index < uboBuffers.size(); ++index)
-		{
-			uboBuffers[index] = std::make_unique<Buffer>
-			(
-				m_Device,
-				sizeof(GlobalUbo),
-				1,
-				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-				// VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, automatically flush memory
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-			);
-
-			uboBuffers[index]->Map();
-		}
+		FrameAllocator frameAllocator{ m_Device, FRAME_DATA_SIZE };
 
 		SimpleRenderSystem simpleRenderSystem{m_Device, m_Renderer.GetSwapChainRenderPass()};
 		RenderSystem2D renderSystem2D{m_Device, m_Renderer.GetSwapChainRenderPass()};
+		HeightfieldRenderSystem heightfieldRenderSystem{m_Device, m_Renderer.GetSwapChainRenderPass()};
         Camera camera{};
 
         camera.SetViewTarget(glm::vec3(1.0f, 3.0f, 0.0f), glm::vec3(0.f, 0.f, 2.5f));
@@ -64,13 +73,16 @@ namespace lve
 
         auto currentTime = std::chrono::high_resolution_clock::now();
 
+		bool isFirstFrame{ true };
+		auto lastMemoryLog = Clock::now();
 		while(!m_Window.ShouldClose())
 		{
 			glfwPollEvents();
+			m_Scheduler.RunMainThreadTasks();
+
 			if(inputManager.ShouldRandomize())
 			{
-				vkDeviceWaitIdle(m_Device.GetDevice());
-				RandomizeTerrain();
+				RandomizeTerrain().Detach();
 				inputManager.ShouldRandomizeFalse();
 			}
 
@@ -80,6 +92,9 @@ namespace lve
 
             //cameraController.MoveInPlaneXYZ(m_Window.GetGLFWwindow(), frameTime, viewerObject);
 			inputManager.Update(viewerObject, frameTime);
+			m_TerrainStreamer.Update(viewerObject.transform.translation);
+			// everything uploaded so far goes out in one submission ahead of the frame that draws it
+			m_Device.GetUploader().Submit();
             camera.SetViewYXZ(viewerObject.transform.translation, viewerObject.transform.rotation);
 
             float aspect = m_Renderer.GetAspectRatio();
@@ -89,108 +104,387 @@ namespace lve
 			if(auto commandBuffer = m_Renderer.BeginFrame())
 			{
 				int frameIndex = m_Renderer.GetFrameIndex();
+				// BeginFrame waited for the frame that last used this index
+				frameAllocator.BeginFrame(frameIndex);
 				FrameInfo frameInfo
 				{
 					frameIndex,
 					frameTime,
 					commandBuffer,
-					camera
+					camera,
+					frameAllocator
 				};
 
 				// Update
 				GlobalUbo ubo{};
 				ubo.projectionView = camera.GetProjectionMatrix() * camera.GetViewMatrix();
-				uboBuffers[frameIndex]->WriteToBuffer(&ubo);
-				uboBuffers[frameIndex]->Flush();
+				frameAllocator.Push(ubo);
 
 				// Render
 				m_Renderer.BeginSwapChainRenderPass(commandBuffer);
+				simpleRenderSystem.BeginFrame(frameIndex);
 				simpleRenderSystem.RenderGameObjects(frameInfo, m_GameObjects);
+				simpleRenderSystem.RenderGameObjects(frameInfo, m_TerrainStreamer.GetGameObjects());
+				if(m_pPropMesh)
+				{
+					simpleRenderSystem.RenderInstances(frameInfo, *m_pPropMesh, *m_pPropScatter);
+				}
+				if(m_pHeightfield)
+				{
+					heightfieldRenderSystem.RenderHeightfield(frameInfo, *m_pHeightfield, m_HeightfieldTransform, HeightfieldView::Terrain);
+					heightfieldRenderSystem.RenderHeightfield(frameInfo, *m_pHeightfield, m_HeightfieldPreviewTransform, HeightfieldView::Preview);
+				}
 				renderSystem2D.RenderGameObjects(frameInfo, m_GameObjects2D);
 				m_Renderer.EndSwapChainRenderPass(commandBuffer);
+				frameAllocator.Flush();
 				m_Renderer.EndFrame();
+
+				if(isFirstFrame)
+				{
+					std::cout << "First frame " << std::chrono::duration<float, std::milli>(Clock::now() - m_StartTime).count() << " ms after startup" << std::endl;
+					isFirstFrame = false;
+				}
+			}
+
+			if(Clock::now() - lastMemoryLog >= MEMORY_LOG_INTERVAL)
+			{
+				LogMemoryUsage();
+				lastMemoryLog = Clock::now();
 			}
 		}
 
+		// tasks waiting for frames to finish go on once nothing is running anymore
+		m_Renderer.WaitIdle();
+
+		// loads still in flight resume on this thread and reference the application
+		while(m_PendingLoads > 0 || m_IsTerrainUpdating || m_IsScattering || m_TerrainStreamer.GetPendingNodeCount() > 0)
+		{
+			m_Scheduler.RunMainThreadTasks();
+			// no frames go out anymore, uploads recorded by the tasks have to be submitted here
+			m_Device.GetUploader().Submit();
+			std::this_thread::yield();
+		}
+
+		m_Device.GetUploader().WaitIdle();
 		vkDeviceWaitIdle(m_Device.GetDevice());
 	}
 
 	void Application::LoadGameObjects()
 	{
-		int rows{ 128 };
-		int columns{ 128 };
-		float height{ 10 };
-		float width{ 10 };
-		float frequency{ 0.08f };
-
-		std::shared_ptr<Mesh> mesh = Mesh::CreateModelFromFile(m_Device, "\\Models\\flatVase.obj");
-		auto flatVase{ GameObject::CreateGameObject() };
-        flatVase.mesh = mesh;
-        flatVase.transform.translation = { -0.5f, 0.5f, 2.5f };
-		flatVase.transform.scale = glm::vec3{ 3.f };
-        m_GameObjects.push_back(std::move(flatVase));
-
-		mesh = Mesh::CreateModelFromFile(m_Device, "\\Models\\smoothVase.obj");
-		auto smoothVase{ GameObject::CreateGameObject() };
-		smoothVase.mesh = mesh;
-		smoothVase.transform.translation = { 0.5f, 0.5f, 2.5f };
-		smoothVase.transform.scale = glm::vec3{ 3.f };
-		m_GameObjects.push_back(std::move(smoothVase));
-
-		std::pair<Device&, Mesh::Data> temp = Mesh::GeneratePerlinNoiseMap(m_Device, rows, columns, height, width, frequency);
-		std::shared_ptr<Mesh> perlinMap = std::make_unique<Mesh>(temp.first, temp.second);
-		auto perlinNoise{ GameObject::CreateGameObject() };
-		perlinNoise.mesh = perlinMap;
-		perlinNoise.transform.translation = { -15.f, 5.0f, 10.0f };
-		perlinNoise.transform.scale = glm::vec3{ 1.f };
-		m_GameObjects.push_back(std::move(perlinNoise));
+		MeshLoadOptions denseModelOptions{};
+		denseModelOptions.optimize = true;
+		denseModelOptions.vertexFormat = VertexFormat::Packed;
+		denseModelOptions.lodCount = 4;
+		denseModelOptions.buildMeshlets = true;
+
+		TransformComponent transform{};
+		transform.translation = { -0.5f, 0.5f, 2.5f };
+		transform.scale = glm::vec3{ 3.f };
+		LoadModel("\\Models\\flatVase.obj", denseModelOptions, transform, m_GameObjects).Detach();
+
+		transform.translation = { 0.5f, 0.5f, 2.5f };
+		transform.scale = glm::vec3{ 3.f };
+		LoadModel("\\Models\\smoothVase.obj", denseModelOptions, transform, m_GameObjects).Detach();
+
+		LoadTerrain(m_TerrainParams).Detach();
+		LoadProps("\\Models\\smoothVase.obj").Detach();
+
+		transform.translation = { 0.8f, 0.8f, .5f };
+		transform.scale = { 1.5f, 1.5f, 1.5f };
+		LoadModel("\\Models\\smoothVase.obj", {}, transform, m_GameObjects2D).Detach();
+
+		transform.translation = { -0.7f, 0.5f, 0.2f };
+		transform.scale = { 0.2f, 0.2f, 0.2f };
+		LoadModel("\\Models\\cube.obj", {}, transform, m_GameObjects2D).Detach();
+	}
 
-		std::shared_ptr<Mesh> mountainTerrain = Mesh::CreateTerrain(m_Device, rows, columns, temp.second);
-		auto terrain{ GameObject::CreateGameObject() };
-		terrain.mesh = mountainTerrain;
-		terrain.transform.translation = { -5.f, 5.0f, 10.0f };
-		terrain.transform.scale = glm::vec3{ 1.f };
-		m_GameObjects.push_back(std::move(terrain));
+	Task<> Application::LoadModel(std::string filePath, MeshLoadOptions options, TransformComponent transform, std::vector<GameObject>& gameObjects)
+	{
+		++m_PendingLoads;
+		const auto start = Clock::now();
+
+		co_await m_Scheduler.SwitchToWorker();
+
+		Mesh::Data data{};
+		std::string error{};
+		try
+		{
+			data.LoadModel(filePath, options);
+		}
+		catch (const std::exception& exception)
+		{
+			error = exception.what();
+		}
+
+		// uploads go through the Uploader, which belongs to the main thread
+		co_await m_Scheduler.SwitchToMainThread();
 
-		mesh = Mesh::CreateModelFromFile(m_Device, "\\Models\\smoothVase.obj");
-		GameObject gameObject{ GameObject::CreateGameObject() };
-		gameObject.mesh = mesh;
-		gameObject.transform.translation = { 0.8f, 0.8f, .5f };
-		gameObject.transform.scale = { 1.5f, 1.5f, 1.5f };
-		m_GameObjects2D.push_back(std::move(gameObject));
-
-		mesh = Mesh::CreateModelFromFile(m_Device, "\\Models\\cube.obj");
-		GameObject cube{ GameObject::CreateGameObject() };
-		cube.mesh = mesh;
-		cube.transform.translation = { -0.7f, 0.5f, 0.2f };
-		cube.transform.scale = { 0.2f, 0.2f, 0.2f };
-		m_GameObjects2D.push_back(std::move(cube));
+		uint32_t indexBytesSaved{};
+		if (!error.empty())
+		{
+			std::cerr << "Failed to load " << filePath << ": " << error << std::endl;
+		}
+		else
+		{
+			auto object{ GameObject::CreateGameObject() };
+			object.mesh = std::make_shared<Mesh>(m_Device, m_GeometryPool, data, options.vertexFormat);
+			object.transform = transform;
+			indexBytesSaved = object.mesh->GetIndexBytesSaved();
+			gameObjects.push_back(std::move(object));
+		}
+
+		FinishLoad(filePath, start, indexBytesSaved);
 	}
 
-	void Application::RandomizeTerrain()
+	Task<> Application::LoadTerrain(TerrainParams params)
 	{
-		int rows{ 128 };
-		int columns{ 128 };
-		float height{ 10 };
-		float width{ 10 };
-		float frequency{ 0.05f };
+		++m_PendingLoads;
+		const auto start = Clock::now();
 
-		m_GameObjects.pop_back();
-		m_GameObjects.pop_back();
+		co_await m_Scheduler.SwitchToWorker();
+
+		HeightmapCache heightmap{};
+		heightmap.Load(params);
+		std::unique_ptr<TerrainQuery> pTerrainQuery = CreateTerrainQuery(params, heightmap.GetHeights());
+
+		if constexpr (m_HEIGHTFIELD_TERRAIN)
+		{
+			co_await m_Scheduler.SwitchToMainThread();
+
+			m_pHeightfield = std::make_unique<Heightfield>(m_Device, params.rows, params.columns, GetTerrainSpacing(params));
+			m_pHeightfield->Upload(heightmap.GetHeights());
+			m_HeightfieldPreviewTransform.translation = PREVIEW_POSITION;
+			m_HeightfieldTransform.translation = TERRAIN_POSITION;
+
+			m_pTerrainQuery = std::move(pTerrainQuery);
+			m_IsTerrainLoaded = true;
+			FinishLoad("terrain", start, 0);
+			ScatterProps().Detach();
+			co_return;
+		}
+
+		const Mesh::TerrainBuild build = Mesh::BuildTerrain(m_Device, params);
+
+		co_await m_Scheduler.SwitchToMainThread();
+
+		Mesh::TerrainMeshes meshes = Mesh::CreateTerrain(m_Device, m_GeometryPool, build);
 
-		std::pair<Device&, Mesh::Data> temp = Mesh::GeneratePerlinNoiseMap(m_Device, rows, columns, height, width, frequency);
-		std::shared_ptr<Mesh> perlinMap = std::make_unique<Mesh>(temp.first, temp.second);
 		auto perlinNoise{ GameObject::CreateGameObject() };
-		perlinNoise.mesh = perlinMap;
-		perlinNoise.transform.translation = { -15.f, 5.0f, 10.0f };
+		perlinNoise.mesh = std::move(meshes.pPerlinNoise);
+		perlinNoise.transform.translation = PREVIEW_POSITION;
 		perlinNoise.transform.scale = glm::vec3{ 1.f };
+		m_PerlinNoiseId = perlinNoise.GetId();
 		m_GameObjects.push_back(std::move(perlinNoise));
 
-		std::shared_ptr<Mesh> mountainTerrain = Mesh::CreateTerrain(m_Device, rows, columns, temp.second);
 		auto terrain{ GameObject::CreateGameObject() };
-		terrain.mesh = mountainTerrain;
-		terrain.transform.translation = { -5.f, 5.0f, 10.0f };
+		terrain.mesh = std::move(meshes.pTerrain);
+		terrain.transform.translation = TERRAIN_POSITION;
 		terrain.transform.scale = glm::vec3{ 1.f };
+		m_TerrainId = terrain.GetId();
 		m_GameObjects.push_back(std::move(terrain));
+
+		const uint32_t indexBytesSaved = FindGameObject(m_PerlinNoiseId)->mesh->GetIndexBytesSaved() + FindGameObject(m_TerrainId)->mesh->GetIndexBytesSaved();
+		m_pTerrainQuery = std::move(pTerrainQuery);
+		m_IsTerrainLoaded = true;
+		FinishLoad("terrain", start, indexBytesSaved);
+		ScatterProps().Detach();
+	}
+
+	Task<> Application::LoadProps(std::string filePath)
+	{
+		++m_PendingLoads;
+		const auto start = Clock::now();
+
+		// thousands of instances share one mesh, so coarse LODs pay off quickly
+		MeshLoadOptions options{};
+		options.optimize = true;
+		options.lodCount = 4;
+
+		co_await m_Scheduler.SwitchToWorker();
+
+		Mesh::Data data{};
+		std::string error{};
+		try
+		{
+			data.LoadModel(filePath, options);
+		}
+		catch (const std::exception& exception)
+		{
+			error = exception.what();
+		}
+
+		co_await m_Scheduler.SwitchToMainThread();
+
+		if (!error.empty())
+		{
+			std::cerr << "Failed to load " << filePath << ": " << error << std::endl;
+			FinishLoad(filePath, start, 0);
+			co_return;
+		}
+
+		m_pPropScatter = std::make_unique<PropScatter>(CreatePropScatterParams());
+		m_pPropMesh = std::make_shared<Mesh>(m_Device, m_GeometryPool, data, options.vertexFormat);
+		FinishLoad(filePath, start, m_pPropMesh->GetIndexBytesSaved());
+		ScatterProps().Detach();
+	}
+
+	void Application::FinishLoad(const std::string& name, Clock::time_point start, uint32_t indexBytesSaved)
+	{
+		const auto end = Clock::now();
+		std::cout << "Loaded " << name << " in " << std::chrono::duration<float, std::milli>(end - start).count() << " ms, "
+			<< indexBytesSaved << " index bytes saved over 32 bit triangle lists" << std::endl;
+
+		if (--m_PendingLoads == 0)
+		{
+			const MemoryAllocator::Stats memory = m_Device.GetAllocator().GetStats();
+			std::cout << "All assets loaded " << std::chrono::duration<float, std::milli>(end - m_StartTime).count() << " ms after startup, "
+				<< memory.allocationCount << " memory allocations in " << memory.deviceMemoryCount << " device memory objects, "
+				<< m_Device.GetUploader().GetSubmitCount() << " upload submits" << std::endl;
+		}
+	}
+
+	void Application::LogMemoryUsage()
+	{
+		constexpr float mebibyte{ 1024.f * 1024.f };
+		const MemoryAllocator& allocator = m_Device.GetAllocator();
+
+		std::cout << std::fixed << std::setprecision(1) << "Memory" << (allocator.IsBudgetSupported() ? "" : " (estimated budget)");
+		const std::vector<MemoryAllocator::HeapStats> heaps = allocator.GetHeapStats();
+		for (size_t heapIndex{}; heapIndex < heaps.size(); ++heapIndex)
+		{
+			const MemoryAllocator::HeapStats& heap = heaps[heapIndex];
+			std::cout << (heapIndex == 0 ? ": " : ", ") << "heap " << heapIndex << (heap.isDeviceLocal ? " device " : " host ")
+				<< heap.usage / mebibyte << " of " << heap.budget / mebibyte << " MiB, ours " << heap.allocatedSize / mebibyte
+				<< " peak " << heap.peakAllocatedSize / mebibyte;
+		}
+
+		for (uint32_t category{}; category < static_cast<uint32_t>(MemoryCategory::Count); ++category)
+		{
+			const MemoryAllocator::CategoryStats stats = allocator.GetCategoryStats(static_cast<MemoryCategory>(category));
+			std::cout << (category == 0 ? " | " : ", ") << MemoryAllocator::GetCategoryName(static_cast<MemoryCategory>(category))
+				<< " " << stats.usedSize / mebibyte << " peak " << stats.peakUsedSize / mebibyte;
+		}
+		std::cout << " MiB" << std::defaultfloat << std::endl;
+	}
+
+	GameObject* Application::FindGameObject(GameObject::IdT id)
+	{
+		auto it = std::find_if(m_GameObjects.begin(), m_GameObjects.end(), [id](const GameObject& object) { return object.GetId() == id; });
+		return it != m_GameObjects.end() ? &*it : nullptr;
+	}
+
+	Task<> Application::RandomizeTerrain()
+	{
+		// pressing the key before the first terrain is in has nothing to replace, and one update runs at a time
+		if (!m_IsTerrainLoaded || m_IsTerrainUpdating)
+		{
+			co_return;
+		}
+		m_IsTerrainUpdating = true;
+
+		++m_TerrainParams.seed;
+		const TerrainParams params = m_TerrainParams;
+
+		co_await m_Scheduler.SwitchToWorker();
+
+		HeightmapCache heightmap{};
+		heightmap.Load(params);
+		std::unique_ptr<TerrainQuery> pTerrainQuery = CreateTerrainQuery(params, heightmap.GetHeights());
+
+		Mesh::TerrainBuild build{};
+		if constexpr (!m_HEIGHTFIELD_TERRAIN)
+		{
+			build = Mesh::BuildTerrain(m_Device, params);
+		}
+
+		co_await m_Scheduler.SwitchToMainThread();
+
+		// the copy that is not drawn was drawn until the last swap, frames submitted before it may still be in flight
+		while (m_Renderer.GetCompletedFrameCount() < m_TerrainSwapFrame)
+		{
+			co_await m_Scheduler.SwitchToMainThread();
+		}
+
+		Uploader& uploader = m_Device.GetUploader();
+		Uploader::Ticket ticket{};
+		if constexpr (m_HEIGHTFIELD_TERRAIN)
+		{
+			ticket = m_pHeightfield->UploadBack(heightmap.GetHeights());
+		}
+		else
+		{
+			ticket = uploader.Record([this, &build](VkCommandBuffer commandBuffer)
+			{
+				Mesh::RecordTerrainUpdate(commandBuffer, build, *FindGameObject(m_PerlinNoiseId)->mesh, *FindGameObject(m_TerrainId)->mesh);
+			});
+		}
+
+		// goes out with the next frame's upload batch, frames keep drawing the current copy while it runs
+		while (!uploader.IsComplete(ticket))
+		{
+			co_await m_Scheduler.SwitchToMainThread();
+		}
+
+		if constexpr (m_HEIGHTFIELD_TERRAIN)
+		{
+			m_pHeightfield->SwapBuffers();
+		}
+		else
+		{
+			// loads finishing meanwhile may have moved the game objects
+			Mesh::SwapTerrain(build, *FindGameObject(m_PerlinNoiseId)->mesh, *FindGameObject(m_TerrainId)->mesh);
+		}
+		m_pTerrainQuery = std::move(pTerrainQuery);
+		m_TerrainSwapFrame = m_Renderer.GetSubmittedFrameCount();
+		m_IsTerrainUpdating = false;
+		ScatterProps().Detach();
+	}
+
+	Task<> Application::ScatterProps()
+	{
+		// needs both the props and the terrain, whichever arrives last starts it
+		if (!m_pPropScatter || !m_pTerrainQuery)
+		{
+			co_return;
+		}
+
+		if (m_IsScattering)
+		{
+			m_IsScatterQueued = true;
+			co_return;
+		}
+		m_IsScattering = true;
+
+		do
+		{
+			m_IsScatterQueued = false;
+			const std::shared_ptr<const TerrainQuery> pTerrainQuery = m_pTerrainQuery;
+			const auto start = Clock::now();
+
+			co_await m_Scheduler.SwitchToWorker();
+
+			// only tiles whose ground changed are scattered again
+			const uint32_t scatteredTileCount = m_pPropScatter->Update(*pTerrainQuery);
+
+			co_await m_Scheduler.SwitchToMainThread();
+
+			m_pPropScatter->Publish();
+			std::cout << "Scattered " << scatteredTileCount << " of " << m_pPropScatter->GetTileCount() << " tiles in "
+				<< std::chrono::duration<float, std::milli>(Clock::now() - start).count() << " ms, "
+				<< m_pPropScatter->GetInstances().size() << " props" << std::endl;
+		} while (m_IsScatterQueued);
+
+		m_IsScattering = false;
+	}
+
+	glm::vec2 Application::GetTerrainSpacing(const TerrainParams& params)
+	{
+		// the mesh terrain spaces its vertices like this, so the heightfield and queries follow it
+		return { params.size.x / params.rows, params.size.y / params.columns };
+	}
+
+	std::unique_ptr<TerrainQuery> Application::CreateTerrainQuery(const TerrainParams& params, const float* pHeights)
+	{
+		return std::make_unique<TerrainQuery>(pHeights, params.rows, params.columns, GetTerrainSpacing(params), TERRAIN_POSITION);
 	}
 }
@@ -3,9 +3,18 @@
 #include "Device.h"
 #include "GameObject.h"
 #include "Renderer.h"
+#include "GeometryPool.h"
+#include "Heightfield.h"
+#include "PropScatter.h"
+#include "Task.h"
+#include "TaskScheduler.h"
+#include "TerrainQuery.h"
+#include "TerrainStreamer.h"
 
 // std includes
+#include <chrono>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace lve
@@ -15,6 +24,8 @@ namespace lve
 	public:
 		static constexpr int m_WIDTH{ 800 };
 		static constexpr int m_HEIGHT{ 600 };
+		// draws the terrain and its perlin preview from one height texture instead of two meshes
+		static constexpr bool m_HEIGHTFIELD_TERRAIN{ true };
 
 		Application();
 		~Application();
@@ -27,13 +38,60 @@ namespace lve
 		void Run();
 
 	private:
+		using Clock = std::chrono::high_resolution_clock;
+
+		// Starts every asset load, objects appear once their mesh is uploaded
 		void LoadGameObjects();
-		void RandomizeTerrain();
+		Task<> LoadModel(std::string filePath, MeshLoadOptions options, TransformComponent transform, std::vector<GameObject>& gameObjects);
+		Task<> LoadTerrain(TerrainParams params);
+		Task<> LoadProps(std::string filePath);
+		void FinishLoad(const std::string& name, Clock::time_point start, uint32_t indexBytesSaved);
+		// One line with the heap budgets and the memory of every category, with their high water marks
+		void LogMemoryUsage();
+
+		// Generates a new map on a worker and swaps it in at a frame boundary, the old one is drawn until then
+		Task<> RandomizeTerrain();
+		static glm::vec2 GetTerrainSpacing(const TerrainParams& params);
+		// Builds the query pyramid, safe to run on a worker thread
+		static std::unique_ptr<TerrainQuery> CreateTerrainQuery(const TerrainParams& params, const float* pHeights);
+		// Rescatters the props over the current terrain on a worker, a call while one runs makes it run once more
+		Task<> ScatterProps();
+		GameObject* FindGameObject(GameObject::IdT id);
+
+		// first member, so the startup time includes creating the window and device
+		Clock::time_point m_StartTime{ Clock::now() };
+		uint32_t m_PendingLoads{};
 
 		Window m_Window{ m_WIDTH, m_HEIGHT, "Hello Vulkan!" };
 		Device m_Device{ m_Window };
 		Renderer m_Renderer{ m_Window, m_Device };
+		// declared before the game objects, their meshes return ranges to it
+		GeometryPool m_GeometryPool{ m_Device };
 		std::vector<GameObject> m_GameObjects;
 		std::vector<GameObject> m_GameObjects2D;
+
+		TaskScheduler m_Scheduler{ ThreadPool::GetShared() };
+		TerrainStreamer m_TerrainStreamer{ m_Device, m_GeometryPool, m_Scheduler };
+		std::unique_ptr<Heightfield> m_pHeightfield;
+		TransformComponent m_HeightfieldTransform{};
+		TransformComponent m_HeightfieldPreviewTransform{};
+		// height, normal and ray queries on the terrain that is drawn, replaced together with it
+		// shared, so a scatter on a worker keeps the terrain it started on alive
+		std::shared_ptr<const TerrainQuery> m_pTerrainQuery;
+		GameObject::IdT m_PerlinNoiseId{};
+		GameObject::IdT m_TerrainId{};
+		// every re-randomization moves on to the next seed, so a run always shows the same sequence of maps
+		TerrainParams m_TerrainParams{};
+		bool m_IsTerrainLoaded{ false };
+		bool m_IsTerrainUpdating{ false };
+		// submitted frame count of the renderer at the last swap, the copy the terrain stopped drawing is free once
+		// that many frames completed
+		uint64_t m_TerrainSwapFrame{};
+
+		// vases scattered over the terrain, drawn as instances of one mesh
+		std::shared_ptr<Mesh> m_pPropMesh;
+		std::unique_ptr<PropScatter> m_pPropScatter;
+		bool m_IsScattering{ false };
+		bool m_IsScatterQueued{ false };
 	};
 }
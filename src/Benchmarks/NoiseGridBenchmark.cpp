@@ -0,0 +1,95 @@
+#include "NoiseGrid.h"
+
+//libs
+#include "3rdParty/FastNoiseLite.h"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+// Compares the batched noise kernels against per sample FastNoiseLite calls, the way the terrain generator used to sample,
+// and checks that every kernel produces the same bits.
+// The speedups it prints depend on the machine.
+// Usage: NoiseGridBenchmark
+namespace
+{
+	constexpr int RUN_COUNT{ 3 };
+	constexpr int SEED{ 1337 };
+	constexpr float FREQUENCY{ 0.08f };
+
+	template<typename Function>
+	double BestOfRuns(Function function)
+	{
+		double best{ 1e30 };
+		for (int run{}; run < RUN_COUNT; ++run)
+		{
+			const auto start = std::chrono::high_resolution_clock::now();
+			function();
+			const auto end = std::chrono::high_resolution_clock::now();
+			best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+		}
+		return best;
+	}
+
+	void GenerateReference(int size, std::vector<float>& heights)
+	{
+		FastNoiseLite noise(SEED);
+		noise.SetFrequency(FREQUENCY);
+		noise.SetNoiseType(FastNoiseLite::NoiseType_Perlin);
+		noise.SetRotationType3D(FastNoiseLite::RotationType3D_None);
+		noise.SetFractalType(FastNoiseLite::FractalType_None);
+
+		for (int y{}; y < size; ++y)
+		{
+			for (int x{}; x < size; ++x)
+			{
+				heights[static_cast<size_t>(y) * size + x] =
+					1 * noise.GetNoise(static_cast<float>(x), static_cast<float>(y))
+					+ 0.5f * noise.GetNoise(static_cast<float>(x) * 2, static_cast<float>(y) * 2)
+					+ 0.25f * noise.GetNoise(static_cast<float>(x) * 4, static_cast<float>(y) * 4);
+			}
+		}
+	}
+}
+
+int main()
+{
+	const std::vector<lve::NoiseGrid::Octave> octaves{ { 1.f, 1.f }, { 2.f, 0.5f }, { 4.f, 0.25f } };
+	const lve::NoiseGrid::Isa bestIsa = lve::NoiseGrid::GetBestIsa();
+	std::cout << "best instruction set: " << lve::NoiseGrid::GetIsaName(bestIsa) << '\n';
+
+	bool isIdentical{ true };
+	for (int size : { 128, 1024, 4096 })
+	{
+		const size_t sampleCount = static_cast<size_t>(size) * size;
+		std::vector<float> reference(sampleCount);
+		const double referenceTime = BestOfRuns([&]() { GenerateReference(size, reference); });
+		std::cout << size << "x" << size << " FastNoiseLite: " << referenceTime << " ms\n";
+
+		for (lve::NoiseGrid::Isa isa : { lve::NoiseGrid::Isa::Scalar, lve::NoiseGrid::Isa::Sse41, lve::NoiseGrid::Isa::Avx2 })
+		{
+			if (isa > bestIsa)
+			{
+				continue;
+			}
+
+			std::vector<float> heights(sampleCount);
+			const double time = BestOfRuns([&]()
+			{
+				lve::NoiseGrid::GeneratePerlin(SEED, FREQUENCY, octaves, 0, size, 0, size, heights.data(), isa);
+			});
+
+			const bool isMatching = std::memcmp(heights.data(), reference.data(), sampleCount * sizeof(float)) == 0;
+			isIdentical = isIdentical && isMatching;
+
+			std::cout << size << "x" << size << " " << lve::NoiseGrid::GetIsaName(isa) << ": " << time << " ms, "
+				<< referenceTime / time << "x, " << (isMatching ? "bit identical" : "MISMATCH") << '\n';
+		}
+	}
+
+	return isIdentical ? EXIT_SUCCESS : EXIT_FAILURE;
+}
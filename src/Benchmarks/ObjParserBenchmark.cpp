@@ -0,0 +1,121 @@
+#include "ObjParser.h"
+#include "ThreadPool.h"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+// Measures how ObjParser scales with the number of worker threads.
+// Usage: ObjParserBenchmark [file.obj]; without a file a 512x512 grid is written to the temp directory.
+namespace
+{
+	constexpr int RUN_COUNT{ 5 };
+
+	std::string WriteGridObj(int size)
+	{
+		const std::string path = (std::filesystem::temp_directory_path() / "lve_benchmark_grid.obj").string();
+		std::ofstream file(path);
+
+		for (int y{}; y < size; ++y)
+		{
+			for (int x{}; x < size; ++x)
+			{
+				const float height = static_cast<float>((x * 7 + y * 13) % 17) * 0.01f;
+				file << "v " << x * 0.1f << ' ' << height << ' ' << y * 0.1f << '\n';
+				file << "vt " << static_cast<float>(x) / size << ' ' << static_cast<float>(y) / size << '\n';
+				file << "vn 0 1 0\n";
+			}
+		}
+
+		for (int y{}; y < size - 1; ++y)
+		{
+			for (int x{}; x < size - 1; ++x)
+			{
+				const int topLeft = y * size + x + 1;
+				const int bottomLeft = topLeft + size;
+				file << "f " << topLeft << '/' << topLeft << '/' << topLeft << ' '
+					<< bottomLeft << '/' << bottomLeft << '/' << bottomLeft << ' '
+					<< bottomLeft + 1 << '/' << bottomLeft + 1 << '/' << bottomLeft + 1 << ' '
+					<< topLeft + 1 << '/' << topLeft + 1 << '/' << topLeft + 1 << '\n';
+			}
+		}
+
+		return path;
+	}
+
+	template<typename Function>
+	double BestOfRuns(Function function)
+	{
+		double best{ 1e30 };
+		for (int run{}; run < RUN_COUNT; ++run)
+		{
+			const auto start = std::chrono::high_resolution_clock::now();
+			function();
+			const auto end = std::chrono::high_resolution_clock::now();
+			best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+		}
+		return best;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const std::string path = argc > 1 ? argv[1] : WriteGridObj(512);
+	std::cout << "file: " << path << " (" << std::filesystem::file_size(path) / (1024 * 1024) << " MiB)\n";
+
+	const double tinyObjTime = BestOfRuns([&path]()
+	{
+		lve::ObjParser::Geometry geometry{};
+		lve::ObjParser::ParseWithTinyObj(path, geometry);
+	});
+	std::cout << "tinyobj: " << tinyObjTime << " ms\n";
+
+	double singleThreadTime{};
+	const uint32_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+	for (uint32_t threadCount{ 1 }; ; threadCount = std::min(threadCount * 2, maxThreads))
+	{
+		lve::ThreadPool threadPool{ threadCount };
+		bool isSupported{ true };
+
+		const double time = BestOfRuns([&]()
+		{
+			lve::ObjParser::Geometry geometry{};
+			isSupported = lve::ObjParser::Parse(path, geometry, threadPool);
+		});
+
+		if (!isSupported)
+		{
+			std::cout << "file uses features the native parser hands to tinyobj\n";
+			return EXIT_SUCCESS;
+		}
+
+		if (threadCount == 1)
+		{
+			singleThreadTime = time;
+		}
+
+		std::cout << "native, " << threadCount << " threads: " << time << " ms, "
+			<< singleThreadTime / time << "x vs 1 thread, " << tinyObjTime / time << "x vs tinyobj\n";
+
+		if (threadCount == maxThreads)
+		{
+			break;
+		}
+	}
+
+	lve::ObjParser::Geometry geometry{};
+	lve::ObjParser::Parse(path, geometry, lve::ThreadPool::GetShared());
+	const double buildTime = BestOfRuns([&geometry]()
+	{
+		lve::Mesh::Data data{};
+		lve::ObjParser::BuildMeshData(geometry, data);
+	});
+	std::cout << "vertex dedupe: " << buildTime << " ms\n";
+
+	return EXIT_SUCCESS;
+}
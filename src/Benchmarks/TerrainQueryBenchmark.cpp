@@ -0,0 +1,128 @@
+#include "NoiseGrid.h"
+#include "TerrainQuery.h"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Times batched height, normal and ray queries on a generated map, checks that the SSE4.1 path matches the scalar
+// single queries bit for bit and that rays agree with marching along them in small steps.
+// Usage: TerrainQueryBenchmark
+namespace
+{
+	constexpr int RUN_COUNT{ 3 };
+	constexpr int SIZE{ 1024 };
+	constexpr size_t QUERY_COUNT{ 100000 };
+	constexpr size_t RAY_COUNT{ 10000 };
+	constexpr size_t MARCHED_RAY_COUNT{ 500 };
+
+	template<typename Function>
+	double BestOfRuns(Function function)
+	{
+		double best{ 1e30 };
+		for (int run{}; run < RUN_COUNT; ++run)
+		{
+			const auto start = std::chrono::high_resolution_clock::now();
+			function();
+			const auto end = std::chrono::high_resolution_clock::now();
+			best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+		}
+		return best;
+	}
+
+	// first marched point below the ground, negative when there is none
+	float MarchRay(const lve::TerrainQuery& query, const lve::TerrainQuery::Ray& ray)
+	{
+		const glm::vec2 low{ query.GetOrigin().x, query.GetOrigin().z };
+		const glm::vec2 high = low + query.GetSize();
+		for (float distance{}; distance <= ray.maxDistance; distance += 0.002f)
+		{
+			const glm::vec3 position = ray.origin + ray.direction * distance;
+			const glm::vec2 position2D{ position.x, position.z };
+			const bool isOverGrid = position2D.x >= low.x && position2D.y >= low.y && position2D.x <= high.x && position2D.y <= high.y;
+			if (isOverGrid && position.y >= query.GetHeight(position2D))
+			{
+				return distance;
+			}
+		}
+		return -1.f;
+	}
+}
+
+int main()
+{
+	std::vector<float> heights(static_cast<size_t>(SIZE) * SIZE);
+	lve::NoiseGrid::GeneratePerlin(1337, 0.02f, { { 1.f, 1.f }, { 2.f, 0.5f }, { 4.f, 0.25f } }, 0, SIZE, 0, SIZE, heights.data());
+	for (float& height : heights)
+	{
+		height *= 20.f;
+	}
+
+	const glm::vec2 spacing{ 0.5f, 0.25f };
+	const glm::vec3 origin{ -5.f, 5.f, 10.f };
+	const auto buildStart = std::chrono::high_resolution_clock::now();
+	const lve::TerrainQuery query{ heights.data(), SIZE, SIZE, spacing, origin };
+	std::cout << SIZE << "x" << SIZE << " pyramid: "
+		<< std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - buildStart).count() << " ms\n";
+
+	std::mt19937 random{ 7 };
+	std::uniform_real_distribution<float> randomX{ origin.x - 10.f, origin.x + query.GetSize().x + 10.f };
+	std::uniform_real_distribution<float> randomZ{ origin.z - 10.f, origin.z + query.GetSize().y + 10.f };
+	std::uniform_real_distribution<float> randomUnit{ -1.f, 1.f };
+
+	std::vector<glm::vec2> positions(QUERY_COUNT);
+	for (glm::vec2& position : positions)
+	{
+		position = { randomX(random), randomZ(random) };
+	}
+
+	std::vector<float> batchHeights(QUERY_COUNT);
+	std::vector<glm::vec3> batchNormals(QUERY_COUNT);
+	const double batchTime = BestOfRuns([&]() { query.GetHeights(positions, batchHeights, batchNormals); });
+
+	std::vector<float> singleHeights(QUERY_COUNT);
+	std::vector<glm::vec3> singleNormals(QUERY_COUNT);
+	const double singleTime = BestOfRuns([&]()
+	{
+		for (size_t index{}; index < QUERY_COUNT; ++index)
+		{
+			singleHeights[index] = query.GetHeight(positions[index]);
+			singleNormals[index] = query.GetNormal(positions[index]);
+		}
+	});
+
+	const bool isMatching = std::memcmp(batchHeights.data(), singleHeights.data(), QUERY_COUNT * sizeof(float)) == 0
+		&& std::memcmp(batchNormals.data(), singleNormals.data(), QUERY_COUNT * sizeof(glm::vec3)) == 0;
+	std::cout << QUERY_COUNT << " heights and normals: batched " << batchTime << " ms, one by one " << singleTime << " ms, "
+		<< (isMatching ? "bit identical" : "MISMATCH") << '\n';
+
+	std::vector<lve::TerrainQuery::Ray> rays(RAY_COUNT);
+	for (lve::TerrainQuery::Ray& ray : rays)
+	{
+		ray.origin = { randomX(random), origin.y - 30.f, randomZ(random) };
+		ray.direction = glm::normalize(glm::vec3{ randomUnit(random), 0.5f + 0.5f * std::abs(randomUnit(random)), randomUnit(random) });
+		ray.maxDistance = 200.f;
+	}
+
+	std::vector<lve::TerrainQuery::RayHit> hits(RAY_COUNT);
+	const double rayTime = BestOfRuns([&]() { query.IntersectRays(rays, hits); });
+
+	size_t mismatchCount{};
+	for (size_t index{}; index < MARCHED_RAY_COUNT; ++index)
+	{
+		const float distance = MarchRay(query, rays[index]);
+		if ((distance >= 0.f) != hits[index].isHit || (hits[index].isHit && std::abs(distance - hits[index].distance) > 0.01f))
+		{
+			++mismatchCount;
+		}
+	}
+	std::cout << RAY_COUNT << " rays: " << rayTime << " ms, " << mismatchCount << " of " << MARCHED_RAY_COUNT << " marched rays disagree\n";
+
+	return isMatching && mismatchCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
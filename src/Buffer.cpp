@@ -42,13 +42,13 @@ namespace lve {
         m_MemoryPropertyFlags{ memoryPropertyFlags } {
         m_AlignmentSize = GetAlignment(instanceSize, minOffsetAlignment);
         m_BufferSize = m_AlignmentSize * instanceCount;
-        device.CreateBuffer(m_BufferSize, usageFlags, memoryPropertyFlags, m_Buffer, m_Memory);
+        device.CreateBuffer(m_BufferSize, usageFlags, memoryPropertyFlags, m_Buffer, m_Allocation);
     }
 
     Buffer::~Buffer() {
         Unmap();
         vkDestroyBuffer(m_Device.GetDevice(), m_Buffer, nullptr);
-        vkFreeMemory(m_Device.GetDevice(), m_Memory, nullptr);
+        m_Device.GetAllocator().Free(m_Allocation);
     }
 
     /**
@@ -58,23 +58,26 @@ namespace lve {
      * buffer range.
      * @param offset (Optional) Byte offset from beginning
      *
+     * @note Host visible memory blocks stay mapped, so this only hands out a pointer into them
+     *
      * @return VkResult of the buffer mapping call
      */
     VkResult Buffer::Map(VkDeviceSize size, VkDeviceSize offset) {
-        assert(m_Buffer && m_Memory && "Called map on buffer before create");
-        return vkMapMemory(m_Device.GetDevice(), m_Memory, offset, size, 0, &m_pMapped);
+        assert(m_Buffer && m_Allocation.memory && "Called map on buffer before create");
+        if (!m_Allocation.pMapped) {
+            return VK_ERROR_MEMORY_MAP_FAILED;
+        }
+        m_pMapped = static_cast<char*>(m_Allocation.pMapped) + offset;
+        return VK_SUCCESS;
     }
 
     /**
      * Unmap a mapped memory range
      *
-     * @note Does not return a result as vkUnmapMemory can't fail
+     * @note The memory block stays mapped for the other resources in it
      */
     void Buffer::Unmap() {
-        if (m_pMapped) {
-            vkUnmapMemory(m_Device.GetDevice(), m_Memory);
-            m_pMapped = nullptr;
-        }
+        m_pMapped = nullptr;
     }
 
     /**
@@ -111,12 +114,7 @@ namespace lve {
      * @return VkResult of the flush call
      */
     VkResult Buffer::Flush(VkDeviceSize size, VkDeviceSize offset) {
-        VkMappedMemoryRange mappedRange = {};
-        mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = m_Memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
-        return vkFlushMappedMemoryRanges(m_Device.GetDevice(), 1, &mappedRange);
+        return m_Device.GetAllocator().Flush(m_Allocation, size, offset);
     }
 
     /**
@@ -131,12 +129,7 @@ namespace lve {
      * @return VkResult of the invalidate call
      */
     VkResult Buffer::Invalidate(VkDeviceSize size, VkDeviceSize offset) {
-        VkMappedMemoryRange mappedRange = {};
-        mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = m_Memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
-        return vkInvalidateMappedMemoryRanges(m_Device.GetDevice(), 1, &mappedRange);
+        return m_Device.GetAllocator().Invalidate(m_Allocation, size, offset);
     }
 
     /**
@@ -46,7 +46,7 @@ namespace lve {
         Device& m_Device;
         void* m_pMapped = nullptr;
         VkBuffer m_Buffer = VK_NULL_HANDLE;
-        VkDeviceMemory m_Memory = VK_NULL_HANDLE;
+        MemoryAllocation m_Allocation{};
 
         VkDeviceSize m_BufferSize;
         uint32_t m_InstanceCount;
@@ -1,6 +1,9 @@
 #include "Device.h"
+#include "Uploader.h"
 
 // std headers
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <set>
@@ -63,6 +66,41 @@ namespace lve {
         }
     }
 
+    // the statistics category follows from what a resource is used for
+    static MemoryCategory GetBufferCategory(VkBufferUsageFlags usage)
+    {
+        if (usage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT)
+        {
+            return MemoryCategory::MeshIndex;
+        }
+        if (usage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)
+        {
+            return MemoryCategory::MeshVertex;
+        }
+        if (usage & (VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT))
+        {
+            return MemoryCategory::Uniform;
+        }
+        if (usage & VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+        {
+            return MemoryCategory::Staging;
+        }
+        return MemoryCategory::Other;
+    }
+
+    static MemoryCategory GetImageCategory(VkImageUsageFlags usage)
+    {
+        if (usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT))
+        {
+            return MemoryCategory::Attachment;
+        }
+        if (usage & VK_IMAGE_USAGE_SAMPLED_BIT)
+        {
+            return MemoryCategory::Texture;
+        }
+        return MemoryCategory::Other;
+    }
+
     // class member functions
     Device::Device(Window& window)
 		: m_Window( window )
@@ -72,11 +110,15 @@ namespace lve {
         CreateSurface();
         PickPhysicalDevice();
         CreateLogicalDevice();
+        m_pAllocator = std::make_unique<MemoryAllocator>(m_PhysicalDevice, m_Device, m_SupportsMemoryBudget);
         CreateCommandPool();
+        m_pUploader = std::make_unique<Uploader>(*this);
     }
 
     Device::~Device()
 	{
+        m_pUploader.reset();
+        m_pAllocator.reset();
         vkDestroyCommandPool(m_Device, m_CommandPool, nullptr);
         vkDestroyDevice(m_Device, nullptr);
 
@@ -102,7 +144,8 @@ namespace lve {
         appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
         appInfo.pEngineName = "No Engine";
         appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-        appInfo.apiVersion = VK_API_VERSION_1_0;
+        // 1.1 for vkGetPhysicalDeviceMemoryProperties2, which reads the memory budget
+        appInfo.apiVersion = VK_API_VERSION_1_1;
 
         VkInstanceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -168,8 +211,13 @@ namespace lve {
 	{
         QueueFamilyIndices indices = FindQueueFamilies(m_PhysicalDevice);
 
+        // LVE_NO_TRANSFER_QUEUE forces the graphics queue fallback, which software drivers with one family always take
+        m_HasDedicatedTransferQueue = indices.transferFamilyHasValue && std::getenv("LVE_NO_TRANSFER_QUEUE") == nullptr;
+        m_TransferFamily = m_HasDedicatedTransferQueue ? indices.transferFamily : indices.graphicsFamily;
+        std::cout << "upload queue family: " << m_TransferFamily << (m_HasDedicatedTransferQueue ? " (dedicated transfer)" : " (graphics)") << std::endl;
+
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-        std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily, indices.presentFamily };
+        std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily, indices.presentFamily, m_TransferFamily };
 
         float queuePriority = 1.0f;
         for (uint32_t queueFamily : uniqueQueueFamilies) 
@@ -182,8 +230,13 @@ namespace lve {
             queueCreateInfos.push_back(queueCreateInfo);
         }
 
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(m_PhysicalDevice, &supportedFeatures);
+        m_SupportsMultiDrawIndirect = supportedFeatures.multiDrawIndirect == VK_TRUE;
+
         VkPhysicalDeviceFeatures deviceFeatures = {};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
+        deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
 
         VkDeviceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -191,9 +244,18 @@ namespace lve {
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
+        // the budget query is core 1.1, a 1.0 device with the extension still cannot answer it
+        std::vector<const char*> extensions = m_pDeviceExtensions;
+        m_SupportsMemoryBudget = properties.apiVersion >= VK_API_VERSION_1_1
+            && HasDeviceExtension(m_PhysicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        if (m_SupportsMemoryBudget)
+        {
+            extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        }
+
         createInfo.pEnabledFeatures = &deviceFeatures;
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(m_pDeviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = m_pDeviceExtensions.data();
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+        createInfo.ppEnabledExtensionNames = extensions.data();
 
         // might not really be necessary anymore because device specific validation layers
         // have been deprecated
@@ -214,6 +276,7 @@ namespace lve {
 
         vkGetDeviceQueue(m_Device, indices.graphicsFamily, 0, &m_GraphicsQueue);
         vkGetDeviceQueue(m_Device, indices.presentFamily, 0, &m_PresentQueue);
+        vkGetDeviceQueue(m_Device, m_TransferFamily, 0, &m_TransferQueue);
     }
 
     void Device::CreateCommandPool()
@@ -371,6 +434,18 @@ namespace lve {
         return requiredExtensions.empty();
     }
 
+    bool Device::HasDeviceExtension(VkPhysicalDevice device, const char* pName)
+	{
+        uint32_t extensionCount;
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+        return std::any_of(availableExtensions.begin(), availableExtensions.end(),
+            [pName](const VkExtensionProperties& extension) { return std::strcmp(extension.extensionName, pName) == 0; });
+    }
+
     QueueFamilyIndices Device::FindQueueFamilies(VkPhysicalDevice device)
 	{
         QueueFamilyIndices indices;
@@ -384,14 +459,14 @@ namespace lve {
         int index = 0;
         for (const auto& queueFamily : queueFamilies) 
         {
-            if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) 
+            if (!indices.graphicsFamilyHasValue && queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) 
             {
                 indices.graphicsFamily = index;
                 indices.graphicsFamilyHasValue = true;
             }
             VkBool32 presentSupport = false;
             vkGetPhysicalDeviceSurfaceSupportKHR(device, index, m_Surface, &presentSupport);
-            if (queueFamily.queueCount > 0 && presentSupport) {
+            if (!indices.presentFamilyHasValue && queueFamily.queueCount > 0 && presentSupport) {
                 indices.presentFamily = index;
                 indices.presentFamilyHasValue = true;
             }
@@ -402,6 +477,19 @@ namespace lve {
             index++;
         }
 
+        // a family that only does transfers, the copy engine of discrete GPUs
+        const VkQueueFlags otherWork = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT;
+        for (uint32_t transferIndex = 0; transferIndex < queueFamilyCount; ++transferIndex)
+        {
+            const VkQueueFamilyProperties& queueFamily = queueFamilies[transferIndex];
+            if (queueFamily.queueCount > 0 && (queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queueFamily.queueFlags & otherWork))
+            {
+                indices.transferFamily = transferIndex;
+                indices.transferFamilyHasValue = true;
+                break;
+            }
+        }
+
         return indices;
     }
 
@@ -474,7 +562,7 @@ namespace lve {
         VkBufferUsageFlags usage,
         VkMemoryPropertyFlags properties,
         VkBuffer& buffer,
-        VkDeviceMemory& bufferMemory
+        MemoryAllocation& bufferMemory
     )
 	{
         VkBufferCreateInfo bufferInfo{};
@@ -491,17 +579,8 @@ namespace lve {
         VkMemoryRequirements memRequirements;
         vkGetBufferMemoryRequirements(m_Device, buffer, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits, properties);
-
-        if (vkAllocateMemory(m_Device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) 
-        {
-            throw std::runtime_error("failed to allocate vertex buffer memory!");
-        }
-
-        vkBindBufferMemory(m_Device, buffer, bufferMemory, 0);
+        bufferMemory = m_pAllocator->Allocate(memRequirements, properties, false, GetBufferCategory(usage));
+        vkBindBufferMemory(m_Device, buffer, bufferMemory.memory, bufferMemory.offset);
     }
 
     VkCommandBuffer Device::BeginSingleTimeCommands()
@@ -538,13 +617,13 @@ namespace lve {
         vkFreeCommandBuffers(m_Device, m_CommandPool, 1, &commandBuffer);
     }
 
-    void Device::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
+    void Device::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset, VkDeviceSize srcOffset)
 	{
         VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
 
         VkBufferCopy copyRegion{};
-        copyRegion.srcOffset = 0;  // Optional
-        copyRegion.dstOffset = 0;  // Optional
+        copyRegion.srcOffset = srcOffset;
+        copyRegion.dstOffset = dstOffset;
         copyRegion.size = size;
         vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
@@ -586,7 +665,7 @@ namespace lve {
         const VkImageCreateInfo& imageInfo,
         VkMemoryPropertyFlags properties,
         VkImage& image,
-        VkDeviceMemory& imageMemory
+        MemoryAllocation& imageMemory
     )
 	{
         if (vkCreateImage(m_Device, &imageInfo, nullptr, &image) != VK_SUCCESS) 
@@ -597,17 +676,9 @@ namespace lve {
         VkMemoryRequirements memRequirements;
         vkGetImageMemoryRequirements(m_Device, image, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits, properties);
-
-        if (vkAllocateMemory(m_Device, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) 
-        {
-            throw std::runtime_error("failed to allocate image memory!");
-        }
+        imageMemory = m_pAllocator->Allocate(memRequirements, properties, imageInfo.tiling == VK_IMAGE_TILING_OPTIMAL, GetImageCategory(imageInfo.usage));
 
-        if (vkBindImageMemory(m_Device, image, imageMemory, 0) != VK_SUCCESS) 
+        if (vkBindImageMemory(m_Device, image, imageMemory.memory, imageMemory.offset) != VK_SUCCESS) 
         {
             throw std::runtime_error("failed to bind image memory!");
         }
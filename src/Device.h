@@ -1,12 +1,16 @@
 #pragma once
 #include "Window.h"
+#include "MemoryAllocator.h"
 
 // std lib headers
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace lve {
 
+    class Uploader;
+
     struct SwapChainSupportDetails {
         VkSurfaceCapabilitiesKHR capabilities;
         std::vector<VkSurfaceFormatKHR> formats;
@@ -16,8 +20,11 @@ namespace lve {
     struct QueueFamilyIndices {
         uint32_t graphicsFamily;
         uint32_t presentFamily;
+        // transfer without graphics or compute, usually a copy engine that runs next to rendering
+        uint32_t transferFamily;
         bool graphicsFamilyHasValue = false;
         bool presentFamilyHasValue = false;
+        bool transferFamilyHasValue = false;
         bool IsComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
     };
 
@@ -44,6 +51,10 @@ namespace lve {
         VkSurfaceKHR Surface() { return m_Surface; }
         VkQueue GraphicsQueue() { return m_GraphicsQueue; }
         VkQueue PresentQueue() { return m_PresentQueue; }
+        // the queue of the dedicated transfer family, or the graphics queue when there is none
+        VkQueue TransferQueue() { return m_TransferQueue; }
+        uint32_t GetTransferFamily() const { return m_TransferFamily; }
+        bool HasDedicatedTransferQueue() const { return m_HasDedicatedTransferQueue; }
 
         SwapChainSupportDetails GetSwapChainSupport() { return QuerySwapChainSupport(m_PhysicalDevice); }
         uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -51,16 +62,16 @@ namespace lve {
         VkFormat FindSupportedFormat(
             const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
-        // Buffer Helper Functions
+        // Buffer Helper Functions, memory comes from the allocator and goes back with GetAllocator().Free
         void CreateBuffer(
             VkDeviceSize size,
             VkBufferUsageFlags usage,
             VkMemoryPropertyFlags properties,
             VkBuffer& buffer,
-            VkDeviceMemory& bufferMemory);
+            MemoryAllocation& bufferMemory);
         VkCommandBuffer BeginSingleTimeCommands();
         void EndSingleTimeCommands(VkCommandBuffer commandBuffer);
-        void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+        void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset = 0, VkDeviceSize srcOffset = 0);
         void CopyBufferToImage(
             VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
 
@@ -68,7 +79,13 @@ namespace lve {
             const VkImageCreateInfo& imageInfo,
             VkMemoryPropertyFlags properties,
             VkImage& image,
-            VkDeviceMemory& imageMemory);
+            MemoryAllocation& imageMemory);
+
+        // also has the memory statistics, per heap and per category
+        MemoryAllocator& GetAllocator() { return *m_pAllocator; }
+        // batched staging uploads, main thread only
+        Uploader& GetUploader() { return *m_pUploader; }
+        bool SupportsMultiDrawIndirect() const { return m_SupportsMultiDrawIndirect; }
 
         VkPhysicalDeviceProperties properties;
 
@@ -88,6 +105,7 @@ namespace lve {
         void PopulateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
         void HasGlfwRequiredInstanceExtensions();
         bool CheckDeviceExtensionSupport(VkPhysicalDevice device);
+        bool HasDeviceExtension(VkPhysicalDevice device, const char* pName);
         SwapChainSupportDetails QuerySwapChainSupport(VkPhysicalDevice device);
 
         VkInstance m_Instance;
@@ -100,6 +118,13 @@ namespace lve {
         VkSurfaceKHR m_Surface;
         VkQueue m_GraphicsQueue;
         VkQueue m_PresentQueue;
+        VkQueue m_TransferQueue;
+        uint32_t m_TransferFamily;
+        bool m_HasDedicatedTransferQueue = false;
+        bool m_SupportsMultiDrawIndirect = false;
+        bool m_SupportsMemoryBudget = false;
+        std::unique_ptr<MemoryAllocator> m_pAllocator;
+        std::unique_ptr<Uploader> m_pUploader;
 
         const std::vector<const char*> m_pValidationLayers = { "VK_LAYER_KHRONOS_validation" };
         const std::vector<const char*> m_pDeviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
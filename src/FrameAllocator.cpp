@@ -0,0 +1,59 @@
+#include "FrameAllocator.h"
+#include "SwapChain.h"
+
+// std
+#include <algorithm>
+#include <stdexcept>
+
+namespace lve
+{
+	static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	FrameAllocator::FrameAllocator(Device& device, VkDeviceSize frameSize)
+	{
+		const VkPhysicalDeviceLimits& limits = device.properties.limits;
+		m_Alignment = std::max<VkDeviceSize>(limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment);
+
+		// parts start on whole atoms, so flushing one frame never touches the memory of another
+		m_FrameSize = AlignUp(frameSize, std::max<VkDeviceSize>(m_Alignment, limits.nonCoherentAtomSize));
+
+		m_pBuffer = std::make_unique<Buffer>
+		(
+			device,
+			m_FrameSize,
+			SwapChain::MAX_FRAMES_IN_FLIGHT,
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+		);
+		m_pBuffer->Map();
+	}
+
+	void FrameAllocator::BeginFrame(int frameIndex)
+	{
+		m_FrameStart = m_FrameSize * frameIndex;
+		m_Head = m_FrameStart;
+	}
+
+	FrameAllocator::Allocation FrameAllocator::Allocate(VkDeviceSize size)
+	{
+		const VkDeviceSize offset = AlignUp(m_Head, m_Alignment);
+		if (offset + size > m_FrameStart + m_FrameSize)
+		{
+			throw std::runtime_error("frame allocator is out of memory!");
+		}
+		m_Head = offset + size;
+
+		return { static_cast<char*>(m_pBuffer->GetMappedMemory()) + offset, static_cast<uint32_t>(offset), size };
+	}
+
+	void FrameAllocator::Flush()
+	{
+		if (m_Head > m_FrameStart)
+		{
+			m_pBuffer->Flush(m_Head - m_FrameStart, m_FrameStart);
+		}
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "Device.h"
+#include "Buffer.h"
+
+//libs
+#include <vulkan/vulkan.h>
+
+// std includes
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace lve
+{
+	// Bump allocator for data that lives one frame, uniform and storage blocks bound with dynamic offsets.
+	// One persistently mapped buffer is split into a part per frame in flight, BeginFrame rewinds the part of the frame
+	// being recorded and Flush makes everything written to it visible with a single flush. Offsets are aligned for
+	// uniform and storage buffer bindings. Main thread only.
+	class FrameAllocator final
+	{
+	public:
+		struct Allocation
+		{
+			void* pData;
+			// from the start of the buffer, the dynamic offset when the descriptor starts at 0
+			uint32_t offset;
+			VkDeviceSize size;
+		};
+
+		FrameAllocator(Device& device, VkDeviceSize frameSize);
+		~FrameAllocator() = default;
+
+		FrameAllocator(const FrameAllocator&) = delete;
+		FrameAllocator(FrameAllocator&&) = delete;
+		FrameAllocator& operator=(const FrameAllocator&) = delete;
+		FrameAllocator& operator=(FrameAllocator&&) = delete;
+
+		// The frame in flight with this index finished on the GPU, its part is handed out again
+		void BeginFrame(int frameIndex);
+		// Throws when the part of the frame is full
+		Allocation Allocate(VkDeviceSize size);
+		template<typename T>
+		Allocation Push(const T& value);
+		// Once per frame, after the last write and before submitting
+		void Flush();
+
+		VkBuffer GetBuffer() const { return m_pBuffer->GetBuffer(); }
+		// For a dynamic uniform or storage descriptor, range is the largest block read through it
+		VkDescriptorBufferInfo DescriptorInfo(VkDeviceSize range) const { return { m_pBuffer->GetBuffer(), 0, range }; }
+		VkDeviceSize GetFrameSize() const { return m_FrameSize; }
+		VkDeviceSize GetUsedSize() const { return m_Head - m_FrameStart; }
+
+	private:
+		std::unique_ptr<Buffer> m_pBuffer;
+		VkDeviceSize m_Alignment;
+		VkDeviceSize m_FrameSize;
+		VkDeviceSize m_FrameStart{};
+		VkDeviceSize m_Head{};
+	};
+
+	template<typename T>
+	FrameAllocator::Allocation FrameAllocator::Push(const T& value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Frame data is copied byte by byte");
+		const Allocation allocation = Allocate(sizeof(T));
+		std::memcpy(allocation.pData, &value, sizeof(T));
+		return allocation;
+	}
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "Camera.h"
+#include "FrameAllocator.h"
 
 //libs
 #include <vulkan/vulkan.h>
@@ -12,5 +13,7 @@ namespace lve
 		float frameTime{};
 		VkCommandBuffer commandBuffer{};
 		Camera& camera;
+		// uniform and storage data that only this frame reads
+		FrameAllocator& frameAllocator;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,199 @@
+#include "GeometryPool.h"
+#include "Mesh.h"
+#include "Uploader.h"
+
+// std
+#include <algorithm>
+#include <stdexcept>
+
+namespace lve
+{
+	GeometryPool::GeometryPool(Device& device)
+		: m_Device{ device }
+	{
+	}
+
+	GeometryPool::~GeometryPool()
+	{
+	}
+
+	GeometryPool::Allocation GeometryPool::Allocate(Heap heap, const void* data, uint32_t count)
+	{
+		if(count == 0)
+		{
+			return { heap, 0, 0, count };
+		}
+
+		// goes out with the next upload batch, draws recorded this frame are submitted after it
+		const Allocation allocation = Reserve(heap, count);
+		const VkDeviceSize elementSize = GetElementSize(heap);
+		m_Device.GetUploader().UploadBuffer(GetBuffer(allocation), elementSize * allocation.offset, data, elementSize * count);
+		return allocation;
+	}
+
+	GeometryPool::Allocation GeometryPool::Allocate(Heap heap, VkBuffer stagingBuffer, VkDeviceSize stagingOffset, uint32_t count)
+	{
+		const Allocation allocation = Reserve(heap, count);
+		if(count > 0)
+		{
+			// the caller owns the staging buffer, so this one waits for the copy
+			Uploader& uploader = m_Device.GetUploader();
+			uploader.Wait(uploader.Record([&](VkCommandBuffer commandBuffer)
+			{
+				RecordUpload(commandBuffer, stagingBuffer, stagingOffset, allocation);
+			}));
+		}
+
+		return allocation;
+	}
+
+	GeometryPool::Allocation GeometryPool::Reserve(Heap heap, uint32_t count)
+	{
+		Allocation allocation{ heap, 0, 0, count };
+		if(count == 0)
+		{
+			return allocation;
+		}
+
+		auto& blocks = m_Heaps[static_cast<size_t>(heap)];
+		const uint32_t elementSize = GetElementSize(heap);
+
+		bool isAllocated{ false };
+		for(uint32_t blockIndex{}; blockIndex < blocks.size() && !isAllocated; ++blockIndex)
+		{
+			isAllocated = TryAllocate(blocks[blockIndex], count, allocation.offset);
+			allocation.block = blockIndex;
+		}
+
+		if(!isAllocated)
+		{
+			Block block{};
+			block.capacity = std::max(static_cast<uint32_t>(BLOCK_SIZE / elementSize), count);
+			block.buffer = std::make_unique<Buffer>
+			(
+				m_Device,
+				elementSize,
+				block.capacity,
+				GetUsage(heap) | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+			);
+			block.freeRanges.emplace(0, block.capacity);
+			m_Capacity += block.buffer->GetBufferSize();
+
+			blocks.push_back(std::move(block));
+			allocation.block = static_cast<uint32_t>(blocks.size() - 1);
+			TryAllocate(blocks.back(), count, allocation.offset);
+		}
+
+		m_UsedSize += static_cast<VkDeviceSize>(elementSize) * count;
+		return allocation;
+	}
+
+	void GeometryPool::RecordUpload(VkCommandBuffer commandBuffer, VkBuffer stagingBuffer, VkDeviceSize stagingOffset, const Allocation& allocation) const
+	{
+		if(allocation.count == 0)
+		{
+			return;
+		}
+
+		const VkDeviceSize elementSize = GetElementSize(allocation.heap);
+		VkBufferCopy copyRegion{};
+		copyRegion.srcOffset = stagingOffset;
+		copyRegion.dstOffset = elementSize * allocation.offset;
+		copyRegion.size = elementSize * allocation.count;
+		vkCmdCopyBuffer(commandBuffer, stagingBuffer, GetBuffer(allocation), 1, &copyRegion);
+
+		// draws submitted after the batch read the new contents
+		m_Device.GetUploader().ReleaseBuffer(GetBuffer(allocation), copyRegion.dstOffset, copyRegion.size);
+	}
+
+	void GeometryPool::Free(const Allocation& allocation)
+	{
+		if(allocation.count == 0)
+		{
+			return;
+		}
+
+		Block& block = m_Heaps[static_cast<size_t>(allocation.heap)][allocation.block];
+		m_UsedSize -= GetSize(allocation);
+
+		auto it = block.freeRanges.emplace(allocation.offset, allocation.count).first;
+
+		auto next = std::next(it);
+		if(next != block.freeRanges.end() && it->first + it->second == next->first)
+		{
+			it->second += next->second;
+			block.freeRanges.erase(next);
+		}
+
+		if(it != block.freeRanges.begin())
+		{
+			auto previous = std::prev(it);
+			if(previous->first + previous->second == it->first)
+			{
+				previous->second += it->second;
+				block.freeRanges.erase(it);
+			}
+		}
+	}
+
+	VkBuffer GeometryPool::GetBuffer(const Allocation& allocation) const
+	{
+		if(allocation.count == 0)
+		{
+			return VK_NULL_HANDLE;
+		}
+
+		return m_Heaps[static_cast<size_t>(allocation.heap)][allocation.block].buffer->GetBuffer();
+	}
+
+	VkDeviceSize GeometryPool::GetSize(const Allocation& allocation)
+	{
+		return allocation.count == 0 ? 0 : static_cast<VkDeviceSize>(GetElementSize(allocation.heap)) * allocation.count;
+	}
+
+	uint32_t GeometryPool::GetElementSize(Heap heap)
+	{
+		switch(heap)
+		{
+		case Heap::Vertices:
+			return sizeof(Mesh::Vertex);
+		case Heap::PackedVertices:
+			return sizeof(Mesh::PackedVertex);
+		case Heap::Indices:
+			return sizeof(uint32_t);
+		case Heap::Indices16:
+			return sizeof(uint16_t);
+		default:
+			throw std::runtime_error("invalid geometry heap");
+		}
+	}
+
+	VkBufferUsageFlags GeometryPool::GetUsage(Heap heap)
+	{
+		return heap == Heap::Indices || heap == Heap::Indices16 ? VK_BUFFER_USAGE_INDEX_BUFFER_BIT : VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+	}
+
+	bool GeometryPool::TryAllocate(Block& block, uint32_t count, uint32_t& offset)
+	{
+		// first fit keeps the low end of each block dense
+		for(auto it = block.freeRanges.begin(); it != block.freeRanges.end(); ++it)
+		{
+			if(it->second < count)
+			{
+				continue;
+			}
+
+			offset = it->first;
+			const uint32_t remaining = it->second - count;
+			block.freeRanges.erase(it);
+			if(remaining > 0)
+			{
+				block.freeRanges.emplace(offset + count, remaining);
+			}
+			return true;
+		}
+
+		return false;
+	}
+}
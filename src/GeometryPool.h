@@ -0,0 +1,88 @@
+#pragma once
+#include "Device.h"
+#include "Buffer.h"
+
+// std includes
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace lve
+{
+	// Large device local vertex and index buffers that meshes get ranges of, so meshes of one vertex format
+	// share their buffers and only differ in vertexOffset and firstIndex.
+	// Meshes are created and destroyed on the main thread, so it is not thread safe.
+	class GeometryPool final
+	{
+	public:
+		enum class Heap : uint32_t
+		{
+			// Mesh::Vertex
+			Vertices,
+			// Mesh::PackedVertex
+			PackedVertices,
+			// uint32_t
+			Indices,
+			// uint16_t
+			Indices16,
+			Count
+		};
+
+		// offset and count are in elements of the heap, so they go straight into vertexOffset and firstIndex
+		struct Allocation
+		{
+			Heap heap{ Heap::Count };
+			uint32_t block{};
+			uint32_t offset{};
+			uint32_t count{};
+		};
+
+		// blocks only grow past this for a single larger mesh
+		static constexpr VkDeviceSize BLOCK_SIZE{ 16 * 1024 * 1024 };
+
+		explicit GeometryPool(Device& device);
+		~GeometryPool();
+
+		GeometryPool(const GeometryPool&) = delete;
+		GeometryPool(GeometryPool&&) = delete;
+		GeometryPool& operator=(const GeometryPool&) = delete;
+		GeometryPool& operator=(GeometryPool&&) = delete;
+
+		// Uploads count elements into a free range of the heap, adding a block when none fits.
+		// The copy goes out with the next upload batch, data can go away right after the call.
+		Allocation Allocate(Heap heap, const void* data, uint32_t count);
+		// Same, copying from a staging buffer that already holds the elements at stagingOffset bytes, waits for the copy
+		Allocation Allocate(Heap heap, VkBuffer stagingBuffer, VkDeviceSize stagingOffset, uint32_t count);
+		// Takes a free range without filling it
+		Allocation Reserve(Heap heap, uint32_t count);
+		// Records copying a whole range from a staging buffer into an Uploader batch, for ranges the GPU is not reading while it runs
+		void RecordUpload(VkCommandBuffer commandBuffer, VkBuffer stagingBuffer, VkDeviceSize stagingOffset, const Allocation& allocation) const;
+		// Returns the range to its block, the GPU has to be done with it
+		void Free(const Allocation& allocation);
+
+		VkBuffer GetBuffer(const Allocation& allocation) const;
+		static VkDeviceSize GetSize(const Allocation& allocation);
+		VkDeviceSize GetUsedSize() const { return m_UsedSize; }
+		VkDeviceSize GetCapacity() const { return m_Capacity; }
+
+	private:
+		struct Block
+		{
+			std::unique_ptr<Buffer> buffer;
+			uint32_t capacity{};
+			// offset to count of every free range, neighbours merge when freed
+			std::map<uint32_t, uint32_t> freeRanges;
+		};
+
+		static uint32_t GetElementSize(Heap heap);
+		static VkBufferUsageFlags GetUsage(Heap heap);
+		static bool TryAllocate(Block& block, uint32_t count, uint32_t& offset);
+
+		Device& m_Device;
+		std::array<std::vector<Block>, static_cast<size_t>(Heap::Count)> m_Heaps;
+		VkDeviceSize m_UsedSize{};
+		VkDeviceSize m_Capacity{};
+	};
+}
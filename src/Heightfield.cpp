@@ -0,0 +1,171 @@
+#include "Heightfield.h"
+
+// std
+#include <stdexcept>
+
+namespace lve
+{
+	Heightfield::Heightfield(Device& device, int rows, int columns, glm::vec2 spacing)
+		: m_Device{ device }
+		, m_Rows{ rows }
+		, m_Columns{ columns }
+		, m_Spacing{ spacing }
+	{
+		for (int index{}; index < BUFFER_COUNT; ++index)
+		{
+			CreateImage(index);
+		}
+		CreateSampler();
+		CreateDescriptorSets();
+	}
+
+	Heightfield::~Heightfield()
+	{
+		vkDestroyDescriptorPool(m_Device.GetDevice(), m_DescriptorPool, nullptr);
+		vkDestroyDescriptorSetLayout(m_Device.GetDevice(), m_DescriptorSetLayout, nullptr);
+		vkDestroySampler(m_Device.GetDevice(), m_Sampler, nullptr);
+		for (int index{}; index < BUFFER_COUNT; ++index)
+		{
+			vkDestroyImageView(m_Device.GetDevice(), m_ImageViews[index], nullptr);
+			vkDestroyImage(m_Device.GetDevice(), m_Images[index], nullptr);
+			m_Device.GetAllocator().Free(m_ImageMemories[index]);
+		}
+	}
+
+	void Heightfield::Upload(const float* pHeights)
+	{
+		UploadImage(pHeights, m_FrontIndex);
+	}
+
+	Uploader::Ticket Heightfield::UploadBack(const float* pHeights)
+	{
+		return UploadImage(pHeights, 1 - m_FrontIndex);
+	}
+
+	Uploader::Ticket Heightfield::UploadImage(const float* pHeights, int index)
+	{
+		const VkDeviceSize size = static_cast<VkDeviceSize>(m_Rows) * m_Columns * sizeof(float);
+		const VkExtent3D extent{ static_cast<uint32_t>(m_Columns), static_cast<uint32_t>(m_Rows), 1 };
+		return m_Device.GetUploader().UploadImage(m_Images[index], extent, pHeights, size);
+	}
+
+	VkDescriptorSetLayout Heightfield::CreateDescriptorSetLayout(Device& device)
+	{
+		VkDescriptorSetLayoutBinding binding{};
+		binding.binding = 0;
+		binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		binding.descriptorCount = 1;
+		binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+		binding.pImmutableSamplers = nullptr;
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.bindingCount = 1;
+		layoutInfo.pBindings = &binding;
+
+		VkDescriptorSetLayout descriptorSetLayout{};
+		if (vkCreateDescriptorSetLayout(device.GetDevice(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create heightfield descriptor set layout!");
+		}
+		return descriptorSetLayout;
+	}
+
+	void Heightfield::CreateImage(int index)
+	{
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		// sampled R32_SFLOAT images are supported everywhere, the shader only fetches texels so it needs no filtering
+		imageInfo.format = VK_FORMAT_R32_SFLOAT;
+		imageInfo.extent = { static_cast<uint32_t>(m_Columns), static_cast<uint32_t>(m_Rows), 1 };
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		m_Device.CreateImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_Images[index], m_ImageMemories[index]);
+
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = m_Images[index];
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = VK_FORMAT_R32_SFLOAT;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseMipLevel = 0;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+		if (vkCreateImageView(m_Device.GetDevice(), &viewInfo, nullptr, &m_ImageViews[index]) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create heightfield image view!");
+		}
+	}
+
+	void Heightfield::CreateSampler()
+	{
+		VkSamplerCreateInfo samplerInfo{};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_NEAREST;
+		samplerInfo.minFilter = VK_FILTER_NEAREST;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.maxLod = 0.f;
+		if (vkCreateSampler(m_Device.GetDevice(), &samplerInfo, nullptr, &m_Sampler) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create heightfield sampler!");
+		}
+	}
+
+	void Heightfield::CreateDescriptorSets()
+	{
+		m_DescriptorSetLayout = CreateDescriptorSetLayout(m_Device);
+
+		VkDescriptorPoolSize poolSize{};
+		poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		poolSize.descriptorCount = BUFFER_COUNT;
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.maxSets = BUFFER_COUNT;
+		poolInfo.poolSizeCount = 1;
+		poolInfo.pPoolSizes = &poolSize;
+		if (vkCreateDescriptorPool(m_Device.GetDevice(), &poolInfo, nullptr, &m_DescriptorPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create heightfield descriptor pool!");
+		}
+
+		const std::array<VkDescriptorSetLayout, BUFFER_COUNT> layouts{ m_DescriptorSetLayout, m_DescriptorSetLayout };
+		VkDescriptorSetAllocateInfo allocateInfo{};
+		allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocateInfo.descriptorPool = m_DescriptorPool;
+		allocateInfo.descriptorSetCount = BUFFER_COUNT;
+		allocateInfo.pSetLayouts = layouts.data();
+		if (vkAllocateDescriptorSets(m_Device.GetDevice(), &allocateInfo, m_DescriptorSets.data()) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to allocate heightfield descriptor set!");
+		}
+
+		for (int index{}; index < BUFFER_COUNT; ++index)
+		{
+			VkDescriptorImageInfo imageInfo{};
+			imageInfo.sampler = m_Sampler;
+			imageInfo.imageView = m_ImageViews[index];
+			imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+			VkWriteDescriptorSet write{};
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.dstSet = m_DescriptorSets[index];
+			write.dstBinding = 0;
+			write.dstArrayElement = 0;
+			write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			write.descriptorCount = 1;
+			write.pImageInfo = &imageInfo;
+			vkUpdateDescriptorSets(m_Device.GetDevice(), 1, &write, 0, nullptr);
+		}
+	}
+}
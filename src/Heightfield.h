@@ -0,0 +1,71 @@
+#pragma once
+#include "Device.h"
+#include "Uploader.h"
+
+//libs
+#include <glm/glm.hpp>
+
+// std includes
+#include <array>
+#include <cstdint>
+
+namespace lve
+{
+	// Terrain stored as one height per grid sample in an R32_SFLOAT texture instead of a mesh. HeightfieldRenderSystem
+	// draws it with an index buffer shared by every heightfield of the same size and displaces the grid in the vertex
+	// shader, so replacing the terrain is a single texture upload. There are two textures, new heights go into the one
+	// that is not drawn and SwapBuffers shows them, so frames keep drawing while an update is in flight.
+	class Heightfield final
+	{
+	public:
+		// spacing is the world distance between neighbouring samples along x and z
+		Heightfield(Device& device, int rows, int columns, glm::vec2 spacing);
+		~Heightfield();
+
+		Heightfield(const Heightfield&) = delete;
+		Heightfield(Heightfield&&) = delete;
+		Heightfield& operator=(const Heightfield&) = delete;
+		Heightfield& operator=(Heightfield&&) = delete;
+
+		// Replaces every height of the drawn texture, rows * columns values stored row by row, with the next upload batch.
+		// Must run once before the first draw.
+		void Upload(const float* pHeights);
+		// Replaces every height of the texture that is not drawn, laid out like Upload's heights. No frame in flight may
+		// still draw that texture.
+		Uploader::Ticket UploadBack(const float* pHeights);
+		// Draws the texture UploadBack wrote once its ticket completed
+		void SwapBuffers() { m_FrontIndex = 1 - m_FrontIndex; }
+
+		int GetRows() const { return m_Rows; }
+		int GetColumns() const { return m_Columns; }
+		glm::vec2 GetSpacing() const { return m_Spacing; }
+		VkDescriptorSet GetDescriptorSet() const { return m_DescriptorSets[m_FrontIndex]; }
+		VkDeviceSize GetMemorySize() const { return static_cast<VkDeviceSize>(m_Rows) * m_Columns * sizeof(float) * BUFFER_COUNT; }
+
+		// A single texture read by the vertex shader at binding 0. Pipeline layouts create their own identical copy.
+		static VkDescriptorSetLayout CreateDescriptorSetLayout(Device& device);
+
+	private:
+		static constexpr int BUFFER_COUNT{ 2 };
+
+		void CreateImage(int index);
+		void CreateSampler();
+		void CreateDescriptorSets();
+		Uploader::Ticket UploadImage(const float* pHeights, int index);
+
+		Device& m_Device;
+		const int m_Rows;
+		const int m_Columns;
+		const glm::vec2 m_Spacing;
+
+		// the drawn texture, the other one receives updates
+		int m_FrontIndex{};
+		std::array<VkImage, BUFFER_COUNT> m_Images{};
+		std::array<MemoryAllocation, BUFFER_COUNT> m_ImageMemories{};
+		std::array<VkImageView, BUFFER_COUNT> m_ImageViews{};
+		VkSampler m_Sampler{ VK_NULL_HANDLE };
+		VkDescriptorSetLayout m_DescriptorSetLayout{ VK_NULL_HANDLE };
+		VkDescriptorPool m_DescriptorPool{ VK_NULL_HANDLE };
+		std::array<VkDescriptorSet, BUFFER_COUNT> m_DescriptorSets{};
+	};
+}
@@ -0,0 +1,152 @@
+#include "HeightfieldRenderSystem.h"
+#include "Uploader.h"
+
+// std
+#include <stdexcept>
+#include <cassert>
+#include <vector>
+
+//library
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace lve
+{
+	struct HeightfieldPushConstantData
+	{
+		glm::mat4 transform{ 1.f };
+		// the shader only reads the upper 3x3, the last column holds the grid columns and the view
+		glm::mat4 normalMatrix{ 1.f };
+	};
+
+	HeightfieldRenderSystem::HeightfieldRenderSystem(Device& device, VkRenderPass renderPass)
+		: m_Device(device)
+	{
+		CreatePipelineLayout();
+		CreatePipeline(renderPass);
+	}
+
+	HeightfieldRenderSystem::~HeightfieldRenderSystem()
+	{
+		vkDestroyPipelineLayout(m_Device.GetDevice(), m_PipelineLayout, nullptr);
+		vkDestroyDescriptorSetLayout(m_Device.GetDevice(), m_DescriptorSetLayout, nullptr);
+	}
+
+	void HeightfieldRenderSystem::CreatePipelineLayout()
+	{
+		m_DescriptorSetLayout = Heightfield::CreateDescriptorSetLayout(m_Device);
+
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = sizeof(HeightfieldPushConstantData);
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = 1;
+		pipelineLayoutInfo.pSetLayouts = &m_DescriptorSetLayout;
+		pipelineLayoutInfo.pushConstantRangeCount = 1;
+		pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+		if (vkCreatePipelineLayout(m_Device.GetDevice(), &pipelineLayoutInfo, nullptr, &m_PipelineLayout) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create pipeline layout!");
+		}
+	}
+
+	void HeightfieldRenderSystem::CreatePipeline(VkRenderPass renderPass)
+	{
+		assert(m_PipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
+
+		PipelineConfigInfo pipelineConfig{};
+		Pipeline::DefaultPipelineConfigInfo(pipelineConfig);
+		pipelineConfig.renderPass = renderPass;
+		pipelineConfig.pipelineLayout = m_PipelineLayout;
+		// no vertex buffer, positions come from the index and the height texture
+		pipelineConfig.bindingDescriptions.clear();
+		pipelineConfig.attributeDescriptions.clear();
+		pipelineConfig.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+		pipelineConfig.inputAssemblyInfo.primitiveRestartEnable = VK_TRUE;
+		m_Pipeline = std::make_unique<Pipeline>(m_Device, "Shaders/HeightfieldShader.vert.spv", "Shaders/SimpleShader.frag.spv", pipelineConfig);
+	}
+
+	void HeightfieldRenderSystem::RenderHeightfield(FrameInfo& frameInfo, const Heightfield& heightfield, TransformComponent& transform, HeightfieldView view)
+	{
+		const Grid& grid = GetGrid(heightfield.GetRows(), heightfield.GetColumns());
+
+		m_Pipeline->Bind(frameInfo.commandBuffer);
+		VkDescriptorSet descriptorSet = heightfield.GetDescriptorSet();
+		vkCmdBindDescriptorSets(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+
+		// grid space has one unit between samples and the heights as stored
+		const glm::vec2 spacing = heightfield.GetSpacing();
+		const glm::mat4 gridTransform = glm::scale(glm::mat4{ 1.f }, glm::vec3{ spacing.x, 1.f, spacing.y });
+
+		HeightfieldPushConstantData push{};
+		push.transform = frameInfo.camera.GetProjectionMatrix() * frameInfo.camera.GetViewMatrix() * transform.Mat4() * gridTransform;
+		// the inverse transpose of the grid scale is its reciprocal
+		push.normalMatrix = glm::mat4{ transform.NormalMatrix() * glm::mat3{ glm::scale(glm::mat4{ 1.f }, glm::vec3{ 1.f / spacing.x, 1.f, 1.f / spacing.y }) } };
+		push.normalMatrix[3] = glm::vec4{ static_cast<float>(heightfield.GetColumns()), view == HeightfieldView::Preview ? 1.f : 0.f, 0.f, 1.f };
+
+		vkCmdPushConstants
+		(
+			frameInfo.commandBuffer,
+			m_PipelineLayout,
+			VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+			0,
+			sizeof(HeightfieldPushConstantData),
+			&push
+		);
+
+		vkCmdBindIndexBuffer(frameInfo.commandBuffer, grid.indexBuffer->GetBuffer(), 0, grid.indexType);
+		vkCmdDrawIndexed(frameInfo.commandBuffer, grid.indexCount, 1, 0, 0, 0);
+	}
+
+	const HeightfieldRenderSystem::Grid& HeightfieldRenderSystem::GetGrid(int rows, int columns)
+	{
+		auto it = m_Grids.find({ rows, columns });
+		if (it != m_Grids.end())
+		{
+			return it->second;
+		}
+
+		Mesh::Data data{};
+		Mesh::GenerateGridIndices(rows, columns, data);
+
+		// 16 bit indices whenever every vertex index stays below the 16 bit restart index
+		const bool isShort = static_cast<int64_t>(rows) * columns <= 0xffff;
+		std::vector<uint16_t> shortIndices{};
+		if (isShort)
+		{
+			shortIndices.reserve(data.indices.size());
+			for (uint32_t index : data.indices)
+			{
+				shortIndices.push_back(index == Mesh::RESTART_INDEX ? static_cast<uint16_t>(0xffff) : static_cast<uint16_t>(index));
+			}
+		}
+
+		Grid grid{};
+		grid.indexCount = static_cast<uint32_t>(data.indices.size());
+		grid.indexType = isShort ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+		const VkDeviceSize indexSize = isShort ? sizeof(uint16_t) : sizeof(uint32_t);
+		void* pIndices = isShort ? static_cast<void*>(shortIndices.data()) : static_cast<void*>(data.indices.data());
+
+		grid.indexBuffer = std::make_unique<Buffer>
+		(
+			m_Device,
+			indexSize,
+			grid.indexCount,
+			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+		);
+
+		// grids are made while recording a frame, the batch has to go out before that frame does
+		Uploader& uploader = m_Device.GetUploader();
+		uploader.UploadBuffer(grid.indexBuffer->GetBuffer(), 0, pIndices, indexSize * grid.indexCount);
+		uploader.Submit();
+
+		return m_Grids.emplace(std::make_pair(rows, columns), std::move(grid)).first->second;
+	}
+}
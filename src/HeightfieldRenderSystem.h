@@ -0,0 +1,57 @@
+#pragma once
+#include "Pipeline.h"
+#include "Device.h"
+#include "GameObject.h"
+#include "FrameInfo.h"
+#include "Buffer.h"
+#include "Heightfield.h"
+
+// std includes
+#include <map>
+#include <memory>
+#include <utility>
+
+namespace lve
+{
+	enum class HeightfieldView
+	{
+		// displaced and shaded like the mesh terrain
+		Terrain,
+		// flat grid colored by height, like the perlin noise map
+		Preview
+	};
+
+	class HeightfieldRenderSystem final
+	{
+	public:
+		HeightfieldRenderSystem(Device& device, VkRenderPass renderPass);
+		~HeightfieldRenderSystem();
+
+		void RenderHeightfield(FrameInfo& frameInfo, const Heightfield& heightfield, TransformComponent& transform, HeightfieldView view);
+
+		HeightfieldRenderSystem(const HeightfieldRenderSystem&) = delete;
+		HeightfieldRenderSystem(HeightfieldRenderSystem&&) = delete;
+		HeightfieldRenderSystem& operator=(const HeightfieldRenderSystem&) = delete;
+		HeightfieldRenderSystem& operator=(HeightfieldRenderSystem&&) = delete;
+
+	private:
+		// triangle strips over a grid, the vertex shader derives each vertex from its index
+		struct Grid
+		{
+			std::unique_ptr<Buffer> indexBuffer;
+			uint32_t indexCount;
+			VkIndexType indexType;
+		};
+
+		void CreatePipelineLayout();
+		void CreatePipeline(VkRenderPass renderPass);
+		// built on first use and shared by every heightfield with the same rows and columns
+		const Grid& GetGrid(int rows, int columns);
+
+		Device& m_Device;
+		std::unique_ptr<Pipeline> m_Pipeline;
+		VkDescriptorSetLayout m_DescriptorSetLayout;
+		VkPipelineLayout m_PipelineLayout;
+		std::map<std::pair<int, int>, Grid> m_Grids;
+	};
+}
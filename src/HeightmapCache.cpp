@@ -0,0 +1,164 @@
+#include "HeightmapCache.h"
+#include "Utils.h"
+
+// std
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace lve
+{
+	static constexpr char HEIGHTMAP_CACHE_MAGIC[4]{ 'L', 'V', 'E', 'H' };
+
+	bool HeightmapCache::Load(const TerrainParams& params)
+	{
+		if (Open(params))
+		{
+			return true;
+		}
+
+		m_GeneratedHeights = Mesh::GeneratePerlinHeights(params);
+		if (!Write(params, m_GeneratedHeights.data()) || !Open(params))
+		{
+			return false;
+		}
+
+		// the mapping holds the same heights now
+		m_GeneratedHeights = {};
+		return false;
+	}
+
+	bool HeightmapCache::Open(const TerrainParams& params)
+	{
+		m_pHeader = nullptr;
+
+		if (!m_File.Open(GetCachePath(params)) || m_File.GetSize() < sizeof(Header))
+		{
+			m_File.Close();
+			return false;
+		}
+
+		// the name is only a hash, the header tells whether the file really belongs to params
+		const auto* header = reinterpret_cast<const Header*>(m_File.GetData());
+		const uint64_t expectedSize = sizeof(Header) + static_cast<uint64_t>(params.rows) * params.columns * sizeof(float);
+		if (std::memcmp(header->magic, HEIGHTMAP_CACHE_MAGIC, sizeof(HEIGHTMAP_CACHE_MAGIC)) != 0
+			|| !(header->key == GetKey(params))
+			|| m_File.GetSize() != expectedSize)
+		{
+			m_File.Close();
+			return false;
+		}
+
+		m_pHeader = header;
+		m_GeneratedHeights = {};
+		return true;
+	}
+
+	bool HeightmapCache::Write(const TerrainParams& params, const float* pHeights)
+	{
+		Header header{};
+		std::memcpy(header.magic, HEIGHTMAP_CACHE_MAGIC, sizeof(HEIGHTMAP_CACHE_MAGIC));
+		header.key = GetKey(params);
+
+		std::error_code error{};
+		std::filesystem::create_directories(DIRECTORY, error);
+
+		// same as the mesh cache, write next to the final file and rename
+		const std::string cachePath = GetCachePath(params);
+		const std::string tempPath = cachePath + "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			if (!file.is_open())
+			{
+				std::cerr << "Failed to write heightmap cache: " << cachePath << std::endl;
+				return false;
+			}
+
+			file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+			file.write(reinterpret_cast<const char*>(pHeights), static_cast<std::streamsize>(params.rows) * params.columns * sizeof(float));
+
+			if (!file.good())
+			{
+				file.close();
+				std::filesystem::remove(tempPath, error);
+				std::cerr << "Failed to write heightmap cache: " << cachePath << std::endl;
+				return false;
+			}
+		}
+
+		std::filesystem::rename(tempPath, cachePath, error);
+		if (error)
+		{
+			std::filesystem::remove(tempPath, error);
+			std::cerr << "Failed to write heightmap cache: " << cachePath << std::endl;
+			return false;
+		}
+
+		Evict();
+		return true;
+	}
+
+	void HeightmapCache::Evict()
+	{
+		std::error_code error{};
+		std::vector<std::filesystem::directory_entry> files{};
+		// other threads may write meanwhile, nothing here throws
+		for (std::filesystem::directory_iterator it{ DIRECTORY, error }; !error && it != std::filesystem::directory_iterator{}; it.increment(error))
+		{
+			if (it->is_regular_file(error) && it->path().extension() == ".heightmap")
+			{
+				files.push_back(*it);
+			}
+		}
+		if (files.size() <= MAX_FILE_COUNT)
+		{
+			return;
+		}
+
+		// newest first, the file just written stays
+		std::sort(files.begin(), files.end(), [](const auto& lhs, const auto& rhs)
+		{
+			std::error_code timeError{};
+			return lhs.last_write_time(timeError) > rhs.last_write_time(timeError);
+		});
+		for (size_t index{ MAX_FILE_COUNT }; index < files.size(); ++index)
+		{
+			// a file still mapped by a load on another thread may refuse, it goes on a later write
+			std::filesystem::remove(files[index].path(), error);
+		}
+	}
+
+	std::string HeightmapCache::GetCachePath(const TerrainParams& params)
+	{
+		const Key key = GetKey(params);
+		char name[17]{};
+		std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(HashBytes(&key, sizeof(Key))));
+		return std::string(DIRECTORY) + "/" + name + ".heightmap";
+	}
+
+	const float* HeightmapCache::GetHeights() const
+	{
+		if (!m_pHeader)
+		{
+			return m_GeneratedHeights.empty() ? nullptr : m_GeneratedHeights.data();
+		}
+		return reinterpret_cast<const float*>(m_File.GetData() + sizeof(Header));
+	}
+
+	HeightmapCache::Key HeightmapCache::GetKey(const TerrainParams& params)
+	{
+		Key key{};
+		key.version = VERSION;
+		key.seed = params.seed;
+		key.frequency = params.frequency;
+		key.octaves = params.octaves;
+		key.gain = params.gain;
+		key.rows = params.rows;
+		key.columns = params.columns;
+		return key;
+	}
+}
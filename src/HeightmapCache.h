@@ -0,0 +1,73 @@
+#pragma once
+#include "Mesh.h"
+#include "MappedFile.h"
+
+// std includes
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lve
+{
+	// Perlin height grids on disk, in files named after the hash of the parameters that produced them.
+	// A map generated once is mapped on every later load instead of sampled again.
+	class HeightmapCache final
+	{
+	public:
+		// bump whenever the noise or its normalization changes, older files are then regenerated
+		static constexpr uint32_t VERSION{ 1 };
+		static constexpr const char* DIRECTORY{ "HeightmapCache" };
+		// every re-randomization writes a map of a new seed, only the most recently written ones are kept
+		static constexpr size_t MAX_FILE_COUNT{ 16 };
+
+		HeightmapCache() = default;
+		~HeightmapCache() = default;
+
+		HeightmapCache(const HeightmapCache&) = delete;
+		HeightmapCache(HeightmapCache&&) = delete;
+		HeightmapCache& operator=(const HeightmapCache&) = delete;
+		HeightmapCache& operator=(HeightmapCache&&) = delete;
+
+		// Maps the heights of params, generating and writing them first when no valid file exists.
+		// Returns whether they came from the cache. Safe to run on a worker thread.
+		bool Load(const TerrainParams& params);
+		// Maps the file of params, fails when it is missing, from another version or built with other parameters
+		bool Open(const TerrainParams& params);
+		static bool Write(const TerrainParams& params, const float* pHeights);
+		static std::string GetCachePath(const TerrainParams& params);
+
+		// rows * columns heights stored row by row, valid until the next Load or Open
+		const float* GetHeights() const;
+
+	private:
+		// everything that changes the heights, size only spaces the samples so maps of every size share a file
+		struct Key
+		{
+			uint32_t version;
+			int32_t seed;
+			float frequency;
+			int32_t octaves;
+			float gain;
+			int32_t rows;
+			int32_t columns;
+
+			bool operator==(const Key& other) const = default;
+		};
+
+		struct Header
+		{
+			char magic[4];
+			Key key;
+		};
+
+		static Key GetKey(const TerrainParams& params);
+		// removes the oldest files once there are more than MAX_FILE_COUNT
+		static void Evict();
+
+		MappedFile m_File;
+		const Header* m_pHeader{ nullptr };
+		// filled instead of the mapping when the file could not be written
+		std::vector<float> m_GeneratedHeights;
+	};
+}
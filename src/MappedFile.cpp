@@ -0,0 +1,169 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// std includes
+#include <utility>
+
+namespace lve
+{
+	MappedFile::MappedFile(const std::string& filePath)
+	{
+		Open(filePath);
+	}
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	MappedFile::MappedFile(MappedFile&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Close();
+			std::swap(m_IsOpen, other.m_IsOpen);
+			std::swap(m_pData, other.m_pData);
+			std::swap(m_Size, other.m_Size);
+#ifdef _WIN32
+			std::swap(m_FileHandle, other.m_FileHandle);
+			std::swap(m_MappingHandle, other.m_MappingHandle);
+#else
+			std::swap(m_FileDescriptor, other.m_FileDescriptor);
+#endif
+		}
+		return *this;
+	}
+
+#ifdef _WIN32
+	bool MappedFile::Open(const std::string& filePath)
+	{
+		Close();
+
+		HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		m_FileHandle = file;
+
+		LARGE_INTEGER size{};
+		if (!GetFileSizeEx(file, &size))
+		{
+			Close();
+			return false;
+		}
+		m_Size = static_cast<size_t>(size.QuadPart);
+
+		// empty files cannot be mapped, but they are still valid files
+		if (m_Size > 0)
+		{
+			m_MappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (m_MappingHandle == nullptr)
+			{
+				Close();
+				return false;
+			}
+
+			m_pData = static_cast<const uint8_t*>(MapViewOfFile(m_MappingHandle, FILE_MAP_READ, 0, 0, 0));
+			if (m_pData == nullptr)
+			{
+				Close();
+				return false;
+			}
+		}
+
+		m_IsOpen = true;
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (m_pData)
+		{
+			UnmapViewOfFile(m_pData);
+		}
+		if (m_MappingHandle)
+		{
+			CloseHandle(m_MappingHandle);
+		}
+		if (m_FileHandle)
+		{
+			CloseHandle(m_FileHandle);
+		}
+
+		m_pData = nullptr;
+		m_MappingHandle = nullptr;
+		m_FileHandle = nullptr;
+		m_Size = 0;
+		m_IsOpen = false;
+	}
+#else
+	bool MappedFile::Open(const std::string& filePath)
+	{
+		Close();
+
+		m_FileDescriptor = open(filePath.c_str(), O_RDONLY);
+		if (m_FileDescriptor < 0)
+		{
+			return false;
+		}
+
+		struct stat fileInfo{};
+		if (fstat(m_FileDescriptor, &fileInfo) != 0)
+		{
+			Close();
+			return false;
+		}
+		m_Size = static_cast<size_t>(fileInfo.st_size);
+
+		// empty files cannot be mapped, but they are still valid files
+		if (m_Size > 0)
+		{
+			void* mapping = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, m_FileDescriptor, 0);
+			if (mapping == MAP_FAILED)
+			{
+				Close();
+				return false;
+			}
+
+			m_pData = static_cast<const uint8_t*>(mapping);
+			madvise(mapping, m_Size, MADV_SEQUENTIAL);
+		}
+
+		m_IsOpen = true;
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (m_pData)
+		{
+			munmap(const_cast<uint8_t*>(m_pData), m_Size);
+		}
+		if (m_FileDescriptor >= 0)
+		{
+			close(m_FileDescriptor);
+		}
+
+		m_pData = nullptr;
+		m_FileDescriptor = -1;
+		m_Size = 0;
+		m_IsOpen = false;
+	}
+#endif
+}
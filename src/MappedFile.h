@@ -0,0 +1,42 @@
+#pragma once
+
+// std includes
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace lve
+{
+	// Read-only memory mapping of a whole file
+	class MappedFile final
+	{
+	public:
+		MappedFile() = default;
+		explicit MappedFile(const std::string& filePath);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+
+		bool Open(const std::string& filePath);
+		void Close();
+
+		bool IsOpen() const { return m_IsOpen; }
+		const uint8_t* GetData() const { return m_pData; }
+		size_t GetSize() const { return m_Size; }
+
+	private:
+		bool m_IsOpen{ false };
+		const uint8_t* m_pData{ nullptr };
+		size_t m_Size{ 0 };
+
+#ifdef _WIN32
+		void* m_FileHandle{ nullptr };
+		void* m_MappingHandle{ nullptr };
+#else
+		int m_FileDescriptor{ -1 };
+#endif
+	};
+}
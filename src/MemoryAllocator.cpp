@@ -0,0 +1,349 @@
+#include "MemoryAllocator.h"
+
+// std
+#include <algorithm>
+#include <stdexcept>
+
+namespace lve
+{
+	static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	MemoryAllocator::MemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device, bool isBudgetSupported)
+		: m_PhysicalDevice{ physicalDevice }
+		, m_Device{ device }
+		, m_IsBudgetSupported{ isBudgetSupported }
+	{
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_MemoryProperties);
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		m_BufferImageGranularity = properties.limits.bufferImageGranularity;
+		m_NonCoherentAtomSize = properties.limits.nonCoherentAtomSize;
+
+		m_Pools.resize(m_MemoryProperties.memoryTypeCount * 2);
+	}
+
+	MemoryAllocator::~MemoryAllocator()
+	{
+		// every resource is gone by now, only the blocks kept for reuse are left
+		for (Pool& pool : m_Pools)
+		{
+			for (auto& pBlock : pool.blocks)
+			{
+				if (pBlock)
+				{
+					vkFreeMemory(m_Device, pBlock->memory, nullptr);
+				}
+			}
+		}
+	}
+
+	MemoryAllocation MemoryAllocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool isOptimalImage, MemoryCategory category)
+	{
+		MemoryAllocation allocation{};
+		allocation.category = category;
+		allocation.memoryTypeIndex = FindMemoryType(requirements.memoryTypeBits, properties);
+		// with a granularity of 1 buffers and images can share every block
+		allocation.isOptimalImage = isOptimalImage && m_BufferImageGranularity > 1;
+
+		VkDeviceSize alignment = requirements.alignment;
+		allocation.size = requirements.size;
+		const VkMemoryPropertyFlags typeFlags = m_MemoryProperties.memoryTypes[allocation.memoryTypeIndex].propertyFlags;
+		if ((typeFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(typeFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+		{
+			// flushes widen to whole atoms, this keeps them from reaching into a neighbour
+			alignment = std::max(alignment, m_NonCoherentAtomSize);
+			allocation.size = AlignUp(allocation.size, m_NonCoherentAtomSize);
+		}
+
+		std::lock_guard lock{ m_Mutex };
+
+		const VkDeviceSize blockSize = GetBlockSize(allocation.memoryTypeIndex);
+		if (allocation.size > blockSize / 2)
+		{
+			allocation.memory = AllocateDeviceMemory(allocation.memoryTypeIndex, allocation.size, allocation.pMapped);
+			allocation.block = DEDICATED_BLOCK;
+		}
+		else
+		{
+			Pool& pool = GetPool(allocation.memoryTypeIndex, allocation.isOptimalImage);
+
+			uint32_t blockIndex{ 0 };
+			uint32_t node{ TlsfAllocator::INVALID_NODE };
+			for (; blockIndex < pool.blocks.size() && node == TlsfAllocator::INVALID_NODE; ++blockIndex)
+			{
+				if (pool.blocks[blockIndex])
+				{
+					node = pool.blocks[blockIndex]->pRanges->Allocate(allocation.size, alignment);
+				}
+			}
+
+			if (node != TlsfAllocator::INVALID_NODE)
+			{
+				--blockIndex;
+			}
+			else
+			{
+				// every block is full, take the first empty slot for a new one
+				blockIndex = 0;
+				while (blockIndex < pool.blocks.size() && pool.blocks[blockIndex])
+				{
+					++blockIndex;
+				}
+				if (blockIndex == pool.blocks.size())
+				{
+					pool.blocks.emplace_back();
+				}
+
+				auto pBlock = std::make_unique<Block>();
+				pBlock->memory = AllocateDeviceMemory(allocation.memoryTypeIndex, blockSize, pBlock->pMapped);
+				pBlock->pRanges = std::make_unique<TlsfAllocator>(blockSize);
+				node = pBlock->pRanges->Allocate(allocation.size, alignment);
+				pool.blocks[blockIndex] = std::move(pBlock);
+			}
+
+			const Block& block = *pool.blocks[blockIndex];
+			allocation.memory = block.memory;
+			allocation.offset = block.pRanges->GetOffset(node);
+			allocation.pMapped = block.pMapped ? static_cast<char*>(block.pMapped) + allocation.offset : nullptr;
+			allocation.block = blockIndex;
+			allocation.node = node;
+		}
+
+		AddUsedSize(allocation);
+		return allocation;
+	}
+
+	void MemoryAllocator::Free(const MemoryAllocation& allocation)
+	{
+		if (allocation.memory == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		std::lock_guard lock{ m_Mutex };
+		RemoveUsedSize(allocation);
+
+		const uint32_t heapIndex = GetHeapIndex(allocation.memoryTypeIndex);
+		if (allocation.block == DEDICATED_BLOCK)
+		{
+			vkFreeMemory(m_Device, allocation.memory, nullptr);
+			--m_DeviceMemoryCount;
+			m_AllocatedSize -= allocation.size;
+			m_HeapUsages[heapIndex].allocatedSize -= allocation.size;
+			return;
+		}
+
+		Pool& pool = GetPool(allocation.memoryTypeIndex, allocation.isOptimalImage);
+		auto& pBlock = pool.blocks[allocation.block];
+		pBlock->pRanges->Free(allocation.node);
+		if (!pBlock->pRanges->IsEmpty())
+		{
+			return;
+		}
+
+		// one empty block stays around, so a resource that comes and goes every frame does not hit the driver each time
+		const bool hasOtherEmptyBlock = std::any_of(pool.blocks.begin(), pool.blocks.end(), [&pBlock](const auto& pOther)
+		{
+			return pOther != nullptr && pOther != pBlock && pOther->pRanges->IsEmpty();
+		});
+		if (hasOtherEmptyBlock)
+		{
+			vkFreeMemory(m_Device, pBlock->memory, nullptr);
+			--m_DeviceMemoryCount;
+			m_AllocatedSize -= pBlock->pRanges->GetSize();
+			m_HeapUsages[heapIndex].allocatedSize -= pBlock->pRanges->GetSize();
+			pBlock.reset();
+		}
+	}
+
+	VkResult MemoryAllocator::Flush(const MemoryAllocation& allocation, VkDeviceSize size, VkDeviceSize offset)
+	{
+		if (m_MemoryProperties.memoryTypes[allocation.memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+		{
+			return VK_SUCCESS;
+		}
+
+		const VkMappedMemoryRange range = GetMappedRange(allocation, size, offset);
+		return vkFlushMappedMemoryRanges(m_Device, 1, &range);
+	}
+
+	VkResult MemoryAllocator::Invalidate(const MemoryAllocation& allocation, VkDeviceSize size, VkDeviceSize offset)
+	{
+		if (m_MemoryProperties.memoryTypes[allocation.memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+		{
+			return VK_SUCCESS;
+		}
+
+		const VkMappedMemoryRange range = GetMappedRange(allocation, size, offset);
+		return vkInvalidateMappedMemoryRanges(m_Device, 1, &range);
+	}
+
+	uint32_t MemoryAllocator::FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const
+	{
+		for (uint32_t index{}; index < m_MemoryProperties.memoryTypeCount; ++index)
+		{
+			if ((typeFilter & (1 << index)) && (m_MemoryProperties.memoryTypes[index].propertyFlags & properties) == properties)
+			{
+				return index;
+			}
+		}
+
+		throw std::runtime_error("failed to find suitable memory type!");
+	}
+
+	MemoryAllocator::Stats MemoryAllocator::GetStats() const
+	{
+		std::lock_guard lock{ m_Mutex };
+		return { m_DeviceMemoryCount, m_AllocationCount, m_AllocatedSize, m_UsedSize };
+	}
+
+	std::vector<MemoryAllocator::HeapStats> MemoryAllocator::GetHeapStats() const
+	{
+		VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+		budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+		if (m_IsBudgetSupported)
+		{
+			// the driver's numbers change with every allocation anywhere in the process, so they are read each time
+			VkPhysicalDeviceMemoryProperties2 properties{};
+			properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+			properties.pNext = &budgetProperties;
+			vkGetPhysicalDeviceMemoryProperties2(m_PhysicalDevice, &properties);
+		}
+
+		std::lock_guard lock{ m_Mutex };
+		std::vector<HeapStats> heaps(m_MemoryProperties.memoryHeapCount);
+		for (uint32_t heapIndex{}; heapIndex < m_MemoryProperties.memoryHeapCount; ++heapIndex)
+		{
+			const VkMemoryHeap& heap = m_MemoryProperties.memoryHeaps[heapIndex];
+			const HeapUsage& usage = m_HeapUsages[heapIndex];
+			HeapStats& stats = heaps[heapIndex];
+			stats.size = heap.size;
+			stats.isDeviceLocal = (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+			stats.allocatedSize = usage.allocatedSize;
+			stats.usedSize = usage.usedSize;
+			stats.peakAllocatedSize = usage.peakAllocatedSize;
+			if (m_IsBudgetSupported)
+			{
+				stats.usage = budgetProperties.heapUsage[heapIndex];
+				stats.budget = budgetProperties.heapBudget[heapIndex];
+			}
+			else
+			{
+				stats.usage = usage.allocatedSize;
+				stats.budget = heap.size / 10 * 8;
+			}
+		}
+		return heaps;
+	}
+
+	MemoryAllocator::CategoryStats MemoryAllocator::GetCategoryStats(MemoryCategory category) const
+	{
+		std::lock_guard lock{ m_Mutex };
+		return m_CategoryStats[static_cast<size_t>(category)];
+	}
+
+	const char* MemoryAllocator::GetCategoryName(MemoryCategory category)
+	{
+		switch (category)
+		{
+		case MemoryCategory::MeshVertex:
+			return "vertex";
+		case MemoryCategory::MeshIndex:
+			return "index";
+		case MemoryCategory::Staging:
+			return "staging";
+		case MemoryCategory::Uniform:
+			return "uniform";
+		case MemoryCategory::Attachment:
+			return "attachment";
+		case MemoryCategory::Texture:
+			return "texture";
+		default:
+			return "other";
+		}
+	}
+
+	void MemoryAllocator::AddUsedSize(const MemoryAllocation& allocation)
+	{
+		++m_AllocationCount;
+		m_UsedSize += allocation.size;
+		m_HeapUsages[GetHeapIndex(allocation.memoryTypeIndex)].usedSize += allocation.size;
+
+		CategoryStats& category = m_CategoryStats[static_cast<size_t>(allocation.category)];
+		++category.allocationCount;
+		category.usedSize += allocation.size;
+		category.peakUsedSize = std::max(category.peakUsedSize, category.usedSize);
+	}
+
+	void MemoryAllocator::RemoveUsedSize(const MemoryAllocation& allocation)
+	{
+		--m_AllocationCount;
+		m_UsedSize -= allocation.size;
+		m_HeapUsages[GetHeapIndex(allocation.memoryTypeIndex)].usedSize -= allocation.size;
+
+		CategoryStats& category = m_CategoryStats[static_cast<size_t>(allocation.category)];
+		--category.allocationCount;
+		category.usedSize -= allocation.size;
+	}
+
+	MemoryAllocator::Pool& MemoryAllocator::GetPool(uint32_t memoryTypeIndex, bool isOptimalImage)
+	{
+		return m_Pools[memoryTypeIndex * 2 + (isOptimalImage ? 1 : 0)];
+	}
+
+	VkDeviceSize MemoryAllocator::GetBlockSize(uint32_t memoryTypeIndex) const
+	{
+		const VkDeviceSize heapSize = m_MemoryProperties.memoryHeaps[GetHeapIndex(memoryTypeIndex)].size;
+		return heapSize < 1024ull * 1024 * 1024 ? heapSize / 8 : BLOCK_SIZE;
+	}
+
+	VkDeviceMemory MemoryAllocator::AllocateDeviceMemory(uint32_t memoryTypeIndex, VkDeviceSize size, void*& pMapped)
+	{
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = size;
+		allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+		VkDeviceMemory memory;
+		if (vkAllocateMemory(m_Device, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to allocate device memory!");
+		}
+
+		pMapped = nullptr;
+		if (m_MemoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		{
+			// a memory object can only be mapped once, so the block stays mapped and resources get pointers into it
+			if (vkMapMemory(m_Device, memory, 0, VK_WHOLE_SIZE, 0, &pMapped) != VK_SUCCESS)
+			{
+				vkFreeMemory(m_Device, memory, nullptr);
+				throw std::runtime_error("failed to map device memory!");
+			}
+		}
+
+		++m_DeviceMemoryCount;
+		m_AllocatedSize += size;
+		HeapUsage& heapUsage = m_HeapUsages[GetHeapIndex(memoryTypeIndex)];
+		heapUsage.allocatedSize += size;
+		heapUsage.peakAllocatedSize = std::max(heapUsage.peakAllocatedSize, heapUsage.allocatedSize);
+		return memory;
+	}
+
+	VkMappedMemoryRange MemoryAllocator::GetMappedRange(const MemoryAllocation& allocation, VkDeviceSize size, VkDeviceSize offset) const
+	{
+		// non coherent allocations start and end on atoms, so the widened range stays inside the allocation
+		const VkDeviceSize begin = allocation.offset + offset;
+		const VkDeviceSize end = size == VK_WHOLE_SIZE ? allocation.offset + allocation.size : begin + size;
+
+		VkMappedMemoryRange range{};
+		range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		range.memory = allocation.memory;
+		range.offset = begin & ~(m_NonCoherentAtomSize - 1);
+		range.size = std::min(AlignUp(end, m_NonCoherentAtomSize), allocation.offset + allocation.size) - range.offset;
+		return range;
+	}
+}
@@ -0,0 +1,161 @@
+#pragma once
+#include "TlsfAllocator.h"
+
+//libs
+#include <vulkan/vulkan.h>
+
+// std includes
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lve
+{
+	// What an allocation holds, for the statistics
+	enum class MemoryCategory : uint32_t
+	{
+		MeshVertex,
+		MeshIndex,
+		Staging,
+		// uniform and storage buffers
+		Uniform,
+		Attachment,
+		// sampled images
+		Texture,
+		Other,
+		Count
+	};
+
+	// A range of device memory handed out by the MemoryAllocator, bind resources at memory + offset
+	struct MemoryAllocation
+	{
+		VkDeviceMemory memory{ VK_NULL_HANDLE };
+		VkDeviceSize offset{};
+		VkDeviceSize size{};
+		// points at offset while the memory type is host visible, blocks stay mapped for their whole life
+		void* pMapped{ nullptr };
+		uint32_t memoryTypeIndex{};
+		// DEDICATED_BLOCK when the allocation owns its memory
+		uint32_t block{};
+		uint32_t node{};
+		bool isOptimalImage{ false };
+		MemoryCategory category{ MemoryCategory::Other };
+	};
+
+	// Suballocates resources from large per memory type blocks, so thousands of buffers cost a handful of vkAllocateMemory
+	// calls instead of one each. Ranges inside a block come from a TlsfAllocator. Optimal tiling images get blocks of
+	// their own when bufferImageGranularity is above 1, so they never share a granularity page with buffers.
+	// Resources larger than half a block get a dedicated allocation. Usage is counted per heap and per category with
+	// high water marks, heap budgets come from VK_EXT_memory_budget when the device has it. Thread safe.
+	class MemoryAllocator final
+	{
+	public:
+		struct Stats
+		{
+			// live vkAllocateMemory results, blocks and dedicated allocations
+			uint32_t deviceMemoryCount;
+			uint32_t allocationCount;
+			VkDeviceSize allocatedSize;
+			VkDeviceSize usedSize;
+		};
+
+		struct HeapStats
+		{
+			VkDeviceSize size;
+			bool isDeviceLocal;
+			// device memory this allocator holds in the heap and how much of it resources use
+			VkDeviceSize allocatedSize;
+			VkDeviceSize usedSize;
+			VkDeviceSize peakAllocatedSize;
+			// what the whole process uses and may use according to the driver, without the extension
+			// usage is allocatedSize and budget is the heuristic 80% of the heap
+			VkDeviceSize usage;
+			VkDeviceSize budget;
+		};
+
+		struct CategoryStats
+		{
+			uint32_t allocationCount;
+			VkDeviceSize usedSize;
+			VkDeviceSize peakUsedSize;
+		};
+
+		static constexpr uint32_t DEDICATED_BLOCK{ UINT32_MAX };
+		// largest block size, heaps under 1 GiB use an eighth of the heap
+		static constexpr VkDeviceSize BLOCK_SIZE{ 64 * 1024 * 1024 };
+
+		// isBudgetSupported when VK_EXT_memory_budget is enabled on a Vulkan 1.1 device
+		MemoryAllocator(VkPhysicalDevice physicalDevice, VkDevice device, bool isBudgetSupported);
+		~MemoryAllocator();
+
+		MemoryAllocator(const MemoryAllocator&) = delete;
+		MemoryAllocator(MemoryAllocator&&) = delete;
+		MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+		MemoryAllocator& operator=(MemoryAllocator&&) = delete;
+
+		MemoryAllocation Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool isOptimalImage, MemoryCategory category);
+		// The GPU has to be done with the resource, freeing an empty allocation does nothing
+		void Free(const MemoryAllocation& allocation);
+
+		// size and offset are relative to the allocation, widened to nonCoherentAtomSize inside the allocation's memory
+		VkResult Flush(const MemoryAllocation& allocation, VkDeviceSize size, VkDeviceSize offset);
+		VkResult Invalidate(const MemoryAllocation& allocation, VkDeviceSize size, VkDeviceSize offset);
+
+		uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+		Stats GetStats() const;
+		// one entry per memory heap, queries the driver for the budget
+		std::vector<HeapStats> GetHeapStats() const;
+		CategoryStats GetCategoryStats(MemoryCategory category) const;
+		bool IsBudgetSupported() const { return m_IsBudgetSupported; }
+		static const char* GetCategoryName(MemoryCategory category);
+
+	private:
+		struct Block
+		{
+			VkDeviceMemory memory;
+			void* pMapped;
+			std::unique_ptr<TlsfAllocator> pRanges;
+		};
+
+		// blocks of one memory type and resource kind, freed blocks leave an empty slot so indices stay valid
+		struct Pool
+		{
+			std::vector<std::unique_ptr<Block>> blocks;
+		};
+
+		Pool& GetPool(uint32_t memoryTypeIndex, bool isOptimalImage);
+		VkDeviceSize GetBlockSize(uint32_t memoryTypeIndex) const;
+		// vkAllocateMemory plus mapping for host visible types
+		VkDeviceMemory AllocateDeviceMemory(uint32_t memoryTypeIndex, VkDeviceSize size, void*& pMapped);
+		VkMappedMemoryRange GetMappedRange(const MemoryAllocation& allocation, VkDeviceSize size, VkDeviceSize offset) const;
+		uint32_t GetHeapIndex(uint32_t memoryTypeIndex) const { return m_MemoryProperties.memoryTypes[memoryTypeIndex].heapIndex; }
+		void AddUsedSize(const MemoryAllocation& allocation);
+		void RemoveUsedSize(const MemoryAllocation& allocation);
+
+		struct HeapUsage
+		{
+			VkDeviceSize allocatedSize;
+			VkDeviceSize usedSize;
+			VkDeviceSize peakAllocatedSize;
+		};
+
+		VkPhysicalDevice m_PhysicalDevice;
+		VkDevice m_Device;
+		const bool m_IsBudgetSupported;
+		VkPhysicalDeviceMemoryProperties m_MemoryProperties{};
+		VkDeviceSize m_BufferImageGranularity{};
+		VkDeviceSize m_NonCoherentAtomSize{};
+
+		mutable std::mutex m_Mutex;
+		// two pools per memory type, buffers and linear images first, then optimal images
+		std::vector<Pool> m_Pools;
+		uint32_t m_DeviceMemoryCount{};
+		uint32_t m_AllocationCount{};
+		VkDeviceSize m_AllocatedSize{};
+		VkDeviceSize m_UsedSize{};
+		std::array<HeapUsage, VK_MAX_MEMORY_HEAPS> m_HeapUsages{};
+		std::array<CategoryStats, static_cast<size_t>(MemoryCategory::Count)> m_CategoryStats{};
+	};
+}
@@ -1,117 +1,203 @@
 #include "Mesh.h"
-#include "Utils.h"
+#include "HeightmapCache.h"
+#include "MeshCache.h"
+#include "MeshletBuilder.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshStripifier.h"
+#include "NoiseGrid.h"
+#include "ObjParser.h"
+#include "ThreadPool.h"
+#include "Uploader.h"
 
 //libs
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <TinyObjLoader.h>
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
-#include "3rdParty/FastNoiseLite.h"
+#include <glm/gtc/packing.hpp>
 
 //std
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdlib>
 #include <cstring>
 #include <filesystem>
-#include <unordered_map>
+#include <limits>
 
-namespace std
+namespace lve
 {
-	template<>
-	struct hash<lve::Mesh::Vertex>
+	// models are looked up relative to the source directory
+	static std::string GetModelPath(const std::string& filePath)
+	{
+		std::string file = __FILE__;
+		return file.substr(0, file.find_last_of("/\\")) + filePath;
+	}
+
+	static uint16_t QuantizeUnorm16(float value)
+	{
+		return static_cast<uint16_t>(std::round(std::clamp(value, 0.f, 1.f) * 65535.f));
+	}
+
+	static uint8_t QuantizeUnorm8(float value)
+	{
+		return static_cast<uint8_t>(std::round(std::clamp(value, 0.f, 1.f) * 255.f));
+	}
+
+	// octahedral normal, both components mapped from [-1, 1] to 8 bit unorm
+	static uint16_t EncodeOctahedral(const glm::vec3& normal)
 	{
-		size_t operator()(lve::Mesh::Vertex const& vertex) const
+		const float sum = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+		if(sum == 0.f)
 		{
-			size_t seed = 0;
-			lve::HashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
-			return seed;
+			return QuantizeUnorm8(0.5f) | (QuantizeUnorm8(0.5f) << 8);
 		}
-	};
-}
 
-namespace lve
-{
-	void Mesh::Data::LoadModel(const std::string& filePath)
+		glm::vec2 octahedral{ normal.x / sum, normal.y / sum };
+		if(normal.z < 0.f)
+		{
+			octahedral =
+			{
+				(1.f - std::abs(octahedral.y)) * (octahedral.x >= 0.f ? 1.f : -1.f),
+				(1.f - std::abs(octahedral.x)) * (octahedral.y >= 0.f ? 1.f : -1.f)
+			};
+		}
+
+		return QuantizeUnorm8(octahedral.x * 0.5f + 0.5f) | (QuantizeUnorm8(octahedral.y * 0.5f + 0.5f) << 8);
+	}
+
+	static std::vector<Mesh::PackedVertex> PackVertices(const Mesh::Vertex* vertices, uint32_t vertexCount, glm::mat4& dequantizeTransform)
 	{
-		tinyobj::attrib_t attrib;
-		std::vector<tinyobj::shape_t> shapes;
-		std::vector<tinyobj::material_t> materials;
-		std::string warning, err;
+		glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+		glm::vec3 boundsMax{ std::numeric_limits<float>::lowest() };
+		for(uint32_t index{}; index < vertexCount; ++index)
+		{
+			boundsMin = glm::min(boundsMin, vertices[index].position);
+			boundsMax = glm::max(boundsMax, vertices[index].position);
+		}
 
-		std::string file = __FILE__;
-		const std::string path = file.substr(0, file.find_last_of("/\\")) + filePath;
+		// flat axes still need a non zero extent to divide by
+		const glm::vec3 extent = glm::max(boundsMax - boundsMin, glm::vec3{ std::numeric_limits<float>::min() });
 
-		if(!tinyobj::LoadObj(&attrib, &shapes, &materials, &warning, &err, path.c_str()))
+		std::vector<Mesh::PackedVertex> packedVertices(vertexCount);
+		for(uint32_t index{}; index < vertexCount; ++index)
 		{
-			throw std::runtime_error(warning + err);
+			const Mesh::Vertex& vertex = vertices[index];
+			Mesh::PackedVertex& packed = packedVertices[index];
+
+			const glm::vec3 position = (vertex.position - boundsMin) / extent;
+			packed.position[0] = QuantizeUnorm16(position.x);
+			packed.position[1] = QuantizeUnorm16(position.y);
+			packed.position[2] = QuantizeUnorm16(position.z);
+			packed.position[3] = EncodeOctahedral(vertex.normal);
+
+			packed.color[0] = QuantizeUnorm8(vertex.color.r);
+			packed.color[1] = QuantizeUnorm8(vertex.color.g);
+			packed.color[2] = QuantizeUnorm8(vertex.color.b);
+			packed.color[3] = 255;
+
+			packed.uv[0] = glm::packHalf1x16(vertex.uv.x);
+			packed.uv[1] = glm::packHalf1x16(vertex.uv.y);
 		}
 
-		vertices.clear();
-		indices.clear();
+		// unorm positions arrive in [0, 1], scale and offset them back into the bounds
+		dequantizeTransform = glm::mat4{ 1.f };
+		dequantizeTransform[0][0] = extent.x;
+		dequantizeTransform[1][1] = extent.y;
+		dequantizeTransform[2][2] = extent.z;
+		dequantizeTransform[3] = glm::vec4{ boundsMin, 1.f };
+
+		return packedVertices;
+	}
 
-		std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+	void Mesh::Data::LoadModel(const std::string& filePath, const MeshLoadOptions& options)
+	{
+		const std::string path = GetModelPath(filePath);
 
-		for(const auto& shape : shapes)
+		MeshCache cache{};
+		if(cache.Open(path, options))
+		{
+			vertices.assign(cache.GetVertices(), cache.GetVertices() + cache.GetVertexCount());
+			indices.assign(cache.GetIndices(), cache.GetIndices() + cache.GetIndexCount());
+			lods.assign(cache.GetLods(), cache.GetLods() + cache.GetLodCount());
+		}
+		else
 		{
-			for(const auto& index : shape.mesh.indices)
+			ObjParser::Load(path, *this, options.weldEpsilon);
+
+			if(options.optimize)
 			{
-				Vertex vertex{};
+				MeshOptimizer::Optimize(*this, filePath);
+			}
 
-				if(index.vertex_index >= 0)
-				{
-					vertex.position =
-					{
-						attrib.vertices[3 * index.vertex_index + 0],
-						attrib.vertices[3 * index.vertex_index + 1],
-						attrib.vertices[3 * index.vertex_index + 2]
-					};
+			if(options.lodCount > 1)
+			{
+				MeshSimplifier::GenerateLods(*this, options.lodCount);
+			}
 
-					vertex.color =
-					{
-						attrib.colors[3 * index.vertex_index + 0],
-						attrib.colors[3 * index.vertex_index + 1],
-						attrib.colors[3 * index.vertex_index + 2]
-					};
-				}
+			MeshCache::Write(path, *this, options);
+		}
 
-				if (index.normal_index >= 0)
-				{
-					vertex.normal =
-					{
-						attrib.normals[3 * index.normal_index + 0],
-						attrib.normals[3 * index.normal_index + 1],
-						attrib.normals[3 * index.normal_index + 2]
-					};
-				}
+		// cheap enough to redo on every load, so the cache does not depend on it
+		if(options.buildMeshlets)
+		{
+			const uint32_t fullDetailCount = lods.empty() ? static_cast<uint32_t>(indices.size()) : lods[0].indexCount;
+			meshlets = MeshletBuilder::Build(vertices, indices, 0, fullDetailCount);
+		}
 
-				if (index.texcoord_index >= 0)
-				{
-					vertex.uv =
-					{
-						attrib.texcoords[2 * index.texcoord_index + 0],
-						attrib.texcoords[2 * index.texcoord_index + 1],
-					};
-				}
+		if(options.buildStrips)
+		{
+			MeshStripifier::Stripify(*this);
+		}
+	}
 
-				if(uniqueVertices.count(vertex) == 0)
-				{
-					uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-					vertices.push_back(vertex);
-				}
+	Mesh::Mesh(Device& device, GeometryPool& geometryPool, const Data& builder, VertexFormat vertexFormat)
+		: m_Device{ device }
+		, m_GeometryPool{ geometryPool }
+		, m_VertexFormat{ vertexFormat }
+	{
+		CreateVertexBuffers(builder.vertices.data(), static_cast<uint32_t>(builder.vertices.size()));
+		CreateIndexBuffer(builder.indices.data(), static_cast<uint32_t>(builder.indices.size()), builder.isStrip);
+		SetLods(builder.lods.data(), static_cast<uint32_t>(builder.lods.size()));
+		CreateMeshletBuffer(builder.meshlets);
+	}
 
-				indices.push_back(uniqueVertices[vertex]);
-			}
-		}
+	Mesh::Mesh(Device& device, GeometryPool& geometryPool, const MeshCache& cache, VertexFormat vertexFormat)
+		: m_Device{ device }
+		, m_GeometryPool{ geometryPool }
+		, m_VertexFormat{ vertexFormat }
+	{
+		CreateVertexBuffers(cache.GetVertices(), cache.GetVertexCount());
+		CreateIndexBuffer(cache.GetIndices(), cache.GetIndexCount(), false);
+		SetLods(cache.GetLods(), cache.GetLodCount());
 	}
 
-	Mesh::Mesh(Device& device, const Data& builder)
+	Mesh::Mesh(Device& device, GeometryPool& geometryPool, const GeometryPool::Allocation& vertices, const GeometryPool::Allocation& backVertices,
+		std::shared_ptr<const GeometryPool::Allocation> pIndices, uint32_t indexBytesSaved, const glm::vec3& boundsMin, const glm::vec3& boundsMax)
 		: m_Device{ device }
+		, m_GeometryPool{ geometryPool }
+		, m_VertexFormat{ VertexFormat::Full }
+		, m_BoundsCenter{ (boundsMin + boundsMax) * 0.5f }
+		, m_BoundsRadius{ glm::length(boundsMax - boundsMin) * 0.5f }
+		, m_Vertices{ vertices }
+		, m_BackVertices{ backVertices }
+		, m_VertexCount{ vertices.count }
+		, m_HasIndexBuffer{ pIndices->count > 0 }
+		, m_Indices{ *pIndices }
+		, m_pSharedIndices{ std::move(pIndices) }
+		, m_IndexCount{ m_Indices.count }
+		, m_IndexType{ m_Indices.heap == GeometryPool::Heap::Indices16 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32 }
+		, m_IsStrip{ true }
+		, m_IndexBytesSaved{ indexBytesSaved }
 	{
-		CreateVertexBuffers(builder.vertices);
-		CreateIndexBuffer(builder.indices);
+		SetLods(nullptr, 0);
 	}
 
 	Mesh::~Mesh()
 	{
+		m_GeometryPool.Free(m_Vertices);
+		m_GeometryPool.Free(m_BackVertices);
+		if(!m_pSharedIndices)
+		{
+			m_GeometryPool.Free(m_Indices);
+		}
 	}
 
 	std::vector<VkVertexInputBindingDescription> Mesh::Vertex::GetBindingDescriptions()
@@ -146,235 +232,425 @@ namespace lve
 		return attributeDescriptions;
 	}
 
+	std::vector<VkVertexInputBindingDescription> Mesh::PackedVertex::GetBindingDescriptions()
+	{
+		std::vector<VkVertexInputBindingDescription> bindingDescription(1);
+		bindingDescription[0].binding = 0;
+		bindingDescription[0].stride = sizeof(PackedVertex);
+		bindingDescription[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+		return bindingDescription;
+	}
+
+	std::vector<VkVertexInputAttributeDescription> Mesh::PackedVertex::GetAttributeDescriptions()
+	{
+		// location 2 stays free, the normal travels in position.w
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+
+		attributeDescriptions.push_back({ 0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(PackedVertex, position) });
+		attributeDescriptions.push_back({ 1, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(PackedVertex, color) });
+		attributeDescriptions.push_back({ 3, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(PackedVertex, uv) });
+
+		return attributeDescriptions;
+	}
+
 	void Mesh::Bind(VkCommandBuffer commandBuffer)
 	{
-		VkBuffer buffers[] = { m_VertexBuffer->GetBuffer()};
+		VkBuffer buffers[] = { GetVertexBuffer() };
 		VkDeviceSize offsets[] = { 0 };
 		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
 
 		if(m_HasIndexBuffer)
 		{
-			vkCmdBindIndexBuffer(commandBuffer, m_pIndexBuffer->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+			vkCmdBindIndexBuffer(commandBuffer, GetIndexBuffer(), 0, m_IndexType);
 		}
 	}
 
-	void Mesh::Draw(VkCommandBuffer commandBuffer)
+	void Mesh::Draw(VkCommandBuffer commandBuffer, uint32_t lod, uint32_t instanceCount, uint32_t firstInstance)
 	{
 		if(m_HasIndexBuffer)
 		{
-			vkCmdDrawIndexed(commandBuffer, m_IndexCount, 1, 0, 0, 0);
+			const Lod& range = m_Lods[std::min(lod, GetLodCount() - 1)];
+			vkCmdDrawIndexed(commandBuffer, range.indexCount, instanceCount, m_Indices.offset + range.firstIndex, static_cast<int32_t>(m_Vertices.offset), firstInstance);
 		}
 		else
 		{
-			vkCmdDraw(commandBuffer, m_VertexCount, 1, 0, 0);
+			vkCmdDraw(commandBuffer, m_VertexCount, instanceCount, m_Vertices.offset, firstInstance);
 		}
 	}
 
-	std::unique_ptr<Mesh> Mesh::CreateModelFromFile(Device& device, const std::string& filePath)
+	void Mesh::DrawIndirect(VkCommandBuffer commandBuffer, VkBuffer indirectBuffer, VkDeviceSize offset, uint32_t drawCount)
 	{
-		Data data{};
-		data.LoadModel(filePath);
+		if(m_Device.SupportsMultiDrawIndirect())
+		{
+			vkCmdDrawIndexedIndirect(commandBuffer, indirectBuffer, offset, drawCount, sizeof(VkDrawIndexedIndirectCommand));
+			return;
+		}
 
-		return std::make_unique<Mesh>(device, data);
+		for(uint32_t draw{}; draw < drawCount; ++draw)
+		{
+			vkCmdDrawIndexedIndirect(commandBuffer, indirectBuffer, offset + draw * sizeof(VkDrawIndexedIndirectCommand), 1, sizeof(VkDrawIndexedIndirectCommand));
+		}
 	}
 
-	std::pair<Device&, Mesh::Data> Mesh::GeneratePerlinNoiseMap(Device& device, int rows, int columns, float height, float width, float frequency)
+	std::unique_ptr<Mesh> Mesh::CreateModelFromFile(Device& device, GeometryPool& geometryPool, const std::string& filePath, const MeshLoadOptions& options)
 	{
+		// meshlets and strips are not cached, those loads go through Data
+		MeshCache cache{};
+		if(!options.buildMeshlets && !options.buildStrips && cache.Open(GetModelPath(filePath), options))
+		{
+			return std::make_unique<Mesh>(device, geometryPool, cache, options.vertexFormat);
+		}
+
 		Data data{};
-		srand(static_cast<uint32_t>(time(NULL)));
-		FastNoiseLite noise( rand());
-		noise.SetFrequency(frequency);
-		noise.SetNoiseType(FastNoiseLite::NoiseType_Perlin);
-		noise.SetRotationType3D(FastNoiseLite::RotationType3D_None);
-		noise.SetFractalType(FastNoiseLite::FractalType_None);
-		noise.SetFractalOctaves(3);
-		noise.SetFractalGain(0.4f);
-		noise.SetFractalWeightedStrength(0.f);
-
-		std::vector<float> noiseData(10);
-		int index = 0;
-
-		// Generate vertices
-		for (int y{}; y < rows; ++y)
-		{
-			for (int x{}; x < columns; ++x)
+		data.LoadModel(filePath, options);
+
+		return std::make_unique<Mesh>(device, geometryPool, data, options.vertexFormat);
+	}
+
+	std::vector<float> Mesh::GeneratePerlinHeights(const TerrainParams& params)
+	{
+		// octaves of the same noise, summed into one height per vertex and scaled back into the range of one octave
+		std::vector<NoiseGrid::Octave> octaves{};
+		float amplitudeSum{};
+		NoiseGrid::Octave octave{ 1.f, 1.f };
+		// at least one octave, the sum divides by the amplitudes
+		const int octaveCount = std::max(params.octaves, 1);
+		for (int index{}; index < octaveCount; ++index)
+		{
+			octaves.push_back(octave);
+			amplitudeSum += octave.amplitude;
+			octave.scale *= 2.f;
+			octave.amplitude *= params.gain;
+		}
+
+		const int columns = params.columns;
+		std::vector<float> heights(static_cast<size_t>(params.rows) * columns);
+
+		ForEachRowBand(params.rows, [&](int firstRow, int rowCount)
+		{
+			float* pHeights = heights.data() + static_cast<size_t>(firstRow) * columns;
+			NoiseGrid::GeneratePerlin(params.seed, params.frequency, octaves, 0, columns, firstRow, rowCount, pHeights);
+
+			for (size_t sample{}; sample < static_cast<size_t>(rowCount) * columns; ++sample)
 			{
-				Vertex vertex{};
-
-				vertex.position = { static_cast<float>(x) * width / rows, 0.0f, static_cast<float>(y) * height / columns };
-				vertex.color = { 1.0f, 1.0f, 1.0f };
-				vertex.normal = { 0.0f, -1.0f, 0.0f };
-				vertex.uv = { static_cast<float>(x) * width / rows / (columns - 1), static_cast<float>(y) * height / columns / (rows - 1) };
-
-				noiseData[index++] =
-					(
-						1 * noise.GetNoise(static_cast<float>(x), static_cast<float>(y))
-						+ 0.5f * noise.GetNoise(static_cast<float>(x)*2, static_cast<float>(y)*2)
-						+ 0.25f * noise.GetNoise(static_cast<float>(x)*4, static_cast<float>(y)*4)
-						);
-
-				float randomColor = noiseData[index-1] / (1.f + 0.5f + 0.25f);
-				vertex.color.r = randomColor;
-				vertex.color.g = randomColor;
-				vertex.color.b = randomColor;
-
-				data.vertices.push_back(vertex);
-				index = 0;
+				pHeights[sample] /= amplitudeSum;
 			}
+		});
+
+		return heights;
+	}
+
+	Mesh::TerrainBuild Mesh::BuildTerrain(Device& device, const TerrainParams& params)
+	{
+		const int rows = params.rows;
+		const int columns = params.columns;
+		const float width = params.size.x;
+		const float height = params.size.y;
+
+		// the only host copy of the map, mapped from the cache, everything else goes straight into the staging buffer
+		HeightmapCache heightmap{};
+		heightmap.Load(params);
+		const float* pHeights = heightmap.GetHeights();
+
+		TerrainBuild build{};
+		build.rows = rows;
+		build.columns = columns;
+		build.vertexCount = static_cast<uint32_t>(rows * columns);
+		build.indexCount = GetGridIndexCount(rows, columns);
+		build.isShortIndices = build.vertexCount <= 0xffff;
+
+		const VkDeviceSize verticesSize = static_cast<VkDeviceSize>(sizeof(Vertex)) * build.vertexCount;
+		const VkDeviceSize indicesSize = static_cast<VkDeviceSize>(build.isShortIndices ? sizeof(uint16_t) : sizeof(uint32_t)) * build.indexCount;
+		build.pStagingBuffer = std::make_unique<Buffer>
+		(
+			device,
+			verticesSize * 2 + indicesSize,
+			1,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+		);
+		build.pStagingBuffer->Map();
+
+		Vertex* pPreviewVertices = static_cast<Vertex*>(build.pStagingBuffer->GetMappedMemory());
+		Vertex* pTerrainVertices = pPreviewVertices + build.vertexCount;
+		WriteTerrainVertices(pHeights, rows, columns, height, width, pPreviewVertices, pTerrainVertices);
+
+		void* pIndices = pTerrainVertices + build.vertexCount;
+		if (build.isShortIndices)
+		{
+			WriteGridIndices(rows, columns, static_cast<uint16_t*>(pIndices));
+		}
+		else
+		{
+			WriteGridIndices(rows, columns, static_cast<uint32_t*>(pIndices));
 		}
 
-		// Generate indices
-		for (int y{}; y < rows - 1; ++y)
+		const auto [minHeight, maxHeight] = std::minmax_element(pHeights, pHeights + build.vertexCount);
+		const glm::vec3 extent{ static_cast<float>(columns - 1) * width / rows, 0.f, static_cast<float>(rows - 1) * height / columns };
+		build.previewBoundsMax = extent;
+		build.terrainBoundsMin = { 0.f, *minHeight, 0.f };
+		build.terrainBoundsMax = { extent.x, *maxHeight, extent.z };
+		return build;
+	}
+
+	Mesh::TerrainMeshes Mesh::CreateTerrain(Device& device, GeometryPool& geometryPool, const TerrainBuild& build)
+	{
+		const VkBuffer stagingBuffer = build.pStagingBuffer->GetBuffer();
+		const VkDeviceSize verticesSize = static_cast<VkDeviceSize>(sizeof(Vertex)) * build.vertexCount;
+		const GeometryPool::Heap indexHeap = build.isShortIndices ? GeometryPool::Heap::Indices16 : GeometryPool::Heap::Indices;
+
+		std::shared_ptr<const GeometryPool::Allocation> pIndices
 		{
-			for (int x{}; x < columns - 1; ++x)
+			new GeometryPool::Allocation{ geometryPool.Allocate(indexHeap, stagingBuffer, verticesSize * 2, build.indexCount) },
+			[&geometryPool](const GeometryPool::Allocation* pAllocation)
 			{
-				const int topLeft = y * columns + x;
-				const int topRight = topLeft + 1;
-				const int bottomLeft = (y + 1) * columns + x;
-				const int bottomRight = bottomLeft + 1;
-
-				// Calculate normal for this face
-				glm::vec3 edge1 = data.vertices[topRight].position - data.vertices[topLeft].position;
-				glm::vec3 edge2 = data.vertices[bottomLeft].position - data.vertices[topLeft].position;
-				glm::vec3 normal = glm::normalize(glm::cross(edge1, edge2));
-
-				// Assign normal to all vertices of this face
-				data.vertices[topLeft].normal = normal;
-				data.vertices[topRight].normal = normal;
-				data.vertices[bottomLeft].normal = normal;
-				data.vertices[bottomRight].normal = normal;
-
-				data.indices.push_back(topLeft);
-				data.indices.push_back(bottomLeft);
-				data.indices.push_back(topRight);
-
-				data.indices.push_back(topRight);
-				data.indices.push_back(bottomLeft);
-				data.indices.push_back(bottomRight);
+				geometryPool.Free(*pAllocation);
+				delete pAllocation;
 			}
-		}
-		return std::pair<Device&, Mesh::Data>{device, data};
+		};
+
+		// the preview pays for the shared index range, the terrain saves a whole triangle list
+		const uint32_t triangleCount = build.rows < 2 || build.columns < 2 ? 0 : static_cast<uint32_t>((build.rows - 1) * (build.columns - 1) * 2);
+		const uint32_t listSize = triangleCount * 3 * static_cast<uint32_t>(sizeof(uint32_t));
+		const uint32_t indicesSize = static_cast<uint32_t>(GeometryPool::GetSize(*pIndices));
+
+		TerrainMeshes meshes{};
+		meshes.pPerlinNoise = std::unique_ptr<Mesh>(new Mesh(device, geometryPool,
+			geometryPool.Allocate(GeometryPool::Heap::Vertices, stagingBuffer, 0, build.vertexCount),
+			geometryPool.Reserve(GeometryPool::Heap::Vertices, build.vertexCount),
+			pIndices, listSize - indicesSize, build.previewBoundsMin, build.previewBoundsMax));
+		meshes.pTerrain = std::unique_ptr<Mesh>(new Mesh(device, geometryPool,
+			geometryPool.Allocate(GeometryPool::Heap::Vertices, stagingBuffer, verticesSize, build.vertexCount),
+			geometryPool.Reserve(GeometryPool::Heap::Vertices, build.vertexCount),
+			pIndices, listSize, build.terrainBoundsMin, build.terrainBoundsMax));
+		return meshes;
 	}
 
-	std::unique_ptr<Mesh> Mesh::CreateTerrain(Device& device, int rows, int columns, Data previousData)
+	void Mesh::RecordTerrainUpdate(VkCommandBuffer commandBuffer, const TerrainBuild& build, Mesh& perlinNoise, Mesh& terrain)
 	{
-		Data data{};
-		for (int y{}; y < rows; ++y)
+		assert(perlinNoise.m_BackVertices.count == build.vertexCount && terrain.m_BackVertices.count == build.vertexCount
+			&& "Terrain updates need double buffered meshes of the same size");
+
+		// the index range is the same for every build of this size, only the vertices change
+		const VkBuffer stagingBuffer = build.pStagingBuffer->GetBuffer();
+		const VkDeviceSize verticesSize = static_cast<VkDeviceSize>(sizeof(Vertex)) * build.vertexCount;
+		perlinNoise.m_GeometryPool.RecordUpload(commandBuffer, stagingBuffer, 0, perlinNoise.m_BackVertices);
+		terrain.m_GeometryPool.RecordUpload(commandBuffer, stagingBuffer, verticesSize, terrain.m_BackVertices);
+	}
+
+	void Mesh::SwapTerrain(const TerrainBuild& build, Mesh& perlinNoise, Mesh& terrain)
+	{
+		std::swap(perlinNoise.m_Vertices, perlinNoise.m_BackVertices);
+		std::swap(terrain.m_Vertices, terrain.m_BackVertices);
+
+		terrain.m_BoundsCenter = (build.terrainBoundsMin + build.terrainBoundsMax) * 0.5f;
+		terrain.m_BoundsRadius = glm::length(build.terrainBoundsMax - build.terrainBoundsMin) * 0.5f;
+	}
+
+	void Mesh::ForEachRowBand(int rows, const std::function<void(int firstRow, int rowCount)>& body)
+	{
+		// a few bands per thread so uneven bands still balance, every row belongs to exactly one band
+		ThreadPool& threadPool = ThreadPool::GetShared();
+		const int bandCount = std::max(1, std::min(rows, static_cast<int>(threadPool.GetThreadCount()) * 4));
+
+		threadPool.ParallelFor(static_cast<uint32_t>(bandCount), [&](uint32_t band)
+		{
+			const int firstRow = static_cast<int>(static_cast<int64_t>(rows) * band / bandCount);
+			const int endRow = static_cast<int>(static_cast<int64_t>(rows) * (band + 1) / bandCount);
+			body(firstRow, endRow - firstRow);
+		});
+	}
+
+	void Mesh::WriteTerrainVertices(const float* pHeights, int rows, int columns, float height, float width, Vertex* pPreviewVertices, Vertex* pTerrainVertices)
+	{
+		auto getPosition = [&](int x, int y)
+		{
+			return glm::vec3{ static_cast<float>(x) * width / rows, pHeights[static_cast<size_t>(y) * columns + x], static_cast<float>(y) * height / columns };
+		};
+
+		ForEachRowBand(rows, [&](int firstRow, int rowCount)
 		{
-			for (int x{}; x < columns; ++x)
+			for (int y = firstRow; y < firstRow + rowCount; ++y)
 			{
-				Vertex vertex{};
-				float height = (previousData.vertices[y * columns + x].color.r + previousData.vertices[y * columns + x].color.g + previousData.vertices[y * columns + x].color.b) / 3;
+				// a vertex takes the normal of the quad whose top left corner it is, the last row and column use their neighbour's
+				const int quadY = std::max(std::min(y, rows - 2), 0);
+				for (int x{}; x < columns; ++x)
+				{
+					const size_t index = static_cast<size_t>(y) * columns + x;
+					const int quadX = std::max(std::min(x, columns - 2), 0);
 
-				vertex.position = previousData.vertices[y * columns + x].position;
-				vertex.position.y = height;
-				vertex.color = { 0.4f, 0.3f, 0.2f };
-				vertex.normal = previousData.vertices[y * columns + x].normal;
-				vertex.uv = previousData.vertices[y * columns + x].uv;
+					Vertex vertex{};
+					vertex.position = getPosition(x, y);
+					vertex.uv = { static_cast<float>(x) * width / rows / (columns - 1), static_cast<float>(y) * height / columns / (rows - 1) };
 
-				data.vertices.push_back(vertex);
+					vertex.normal = { 0.0f, -1.0f, 0.0f };
+					vertex.color = { vertex.position.y, vertex.position.y, vertex.position.y };
+					vertex.position.y = 0.f;
+					pPreviewVertices[index] = vertex;
+
+					if (rows > 1 && columns > 1)
+					{
+						const glm::vec3 topLeft = getPosition(quadX, quadY);
+						const glm::vec3 edge1 = getPosition(quadX + 1, quadY) - topLeft;
+						const glm::vec3 edge2 = getPosition(quadX, quadY + 1) - topLeft;
+						vertex.normal = glm::normalize(glm::cross(edge1, edge2));
+					}
+					vertex.position.y = pHeights[index];
+					vertex.color = { 0.4f, 0.3f, 0.2f };
+					pTerrainVertices[index] = vertex;
+				}
 			}
+		});
+	}
+
+	void Mesh::GenerateGridIndices(int rows, int columns, Data& data)
+	{
+		if (rows < 2 || columns < 2)
+		{
+			return;
+		}
+
+		data.indices.resize(GetGridIndexCount(rows, columns));
+		data.isStrip = true;
+		WriteGridIndices(rows, columns, data.indices.data());
+	}
+
+	uint32_t Mesh::GetGridIndexCount(int rows, int columns)
+	{
+		if (rows < 2 || columns < 2)
+		{
+			return 0;
 		}
 
-		// Generate indices
-		for (int y{}; y < rows - 1; ++y)
+		return static_cast<uint32_t>((static_cast<size_t>(columns) * 2 + 1) * (rows - 1) - 1);
+	}
+
+	template<typename Index>
+	void Mesh::WriteGridIndices(int rows, int columns, Index* pIndices)
+	{
+		// One strip per row of quads, alternating top and bottom vertices, which keeps the winding of the
+		// topLeft, bottomLeft, topRight and topRight, bottomLeft, bottomRight triangle pairs
+		const size_t stripSize = static_cast<size_t>(columns) * 2;
+
+		ForEachRowBand(rows - 1, [&](int firstRow, int rowCount)
 		{
-			for (int x{}; x < columns - 1; ++x)
+			for (int y = firstRow; y < firstRow + rowCount; ++y)
 			{
-				const int topLeft = y * columns + x;
-				const int topRight = topLeft + 1;
-				const int bottomLeft = (y + 1) * columns + x;
-				const int bottomRight = bottomLeft + 1;
-
-				// Calculate normal for this face
-				glm::vec3 edge1 = data.vertices[topRight].position - data.vertices[topLeft].position;
-				glm::vec3 edge2 = data.vertices[bottomLeft].position - data.vertices[topLeft].position;
-				glm::vec3 normal = glm::normalize(glm::cross(edge1, edge2));
-
-				// Assign normal to all vertices of this face
-				data.vertices[topLeft].normal = normal;
-				data.vertices[topRight].normal = normal;
-				data.vertices[bottomLeft].normal = normal;
-				data.vertices[bottomRight].normal = normal;
-
-				data.indices.push_back(topLeft);
-				data.indices.push_back(bottomLeft);
-				data.indices.push_back(topRight);
-
-				data.indices.push_back(topRight);
-				data.indices.push_back(bottomLeft);
-				data.indices.push_back(bottomRight);
+				Index* pStrip = pIndices + (stripSize + 1) * y;
+				for (int x{}; x < columns; ++x)
+				{
+					pStrip[x * 2] = static_cast<Index>(y * columns + x);
+					pStrip[x * 2 + 1] = static_cast<Index>((y + 1) * columns + x);
+				}
+
+				if (y < rows - 2)
+				{
+					pStrip[stripSize] = static_cast<Index>(RESTART_INDEX);
+				}
 			}
+		});
+	}
+
+	void Mesh::CreateVertexBuffers(const Vertex* vertices, uint32_t vertexCount)
+	{
+		glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+		glm::vec3 boundsMax{ std::numeric_limits<float>::lowest() };
+		for(uint32_t index{}; index < vertexCount; ++index)
+		{
+			boundsMin = glm::min(boundsMin, vertices[index].position);
+			boundsMax = glm::max(boundsMax, vertices[index].position);
+		}
+
+		m_BoundsCenter = (boundsMin + boundsMax) * 0.5f;
+		m_BoundsRadius = 0.f;
+		for(uint32_t index{}; index < vertexCount; ++index)
+		{
+			m_BoundsRadius = std::max(m_BoundsRadius, glm::length(vertices[index].position - m_BoundsCenter));
 		}
 
-		return std::make_unique<Mesh>(device, data);
+		if(m_VertexFormat == VertexFormat::Full)
+		{
+			CreateVertexBuffer(vertices, vertexCount);
+			return;
+		}
+
+		const std::vector<PackedVertex> packedVertices = PackVertices(vertices, vertexCount, m_DequantizeTransform);
+		CreateVertexBuffer(packedVertices.data(), vertexCount);
 	}
 
-	void Mesh::CreateVertexBuffers(const std::vector<Vertex>& vertices)
+	void Mesh::CreateVertexBuffer(const void* vertices, uint32_t vertexCount)
 	{
-		m_VertexCount = static_cast<uint32_t>(vertices.size());
+		m_VertexCount = vertexCount;
 		assert(m_VertexCount >= 3 && "Vertex count must be at least 3 for a triangle");
-		VkDeviceSize bufferSize = sizeof(vertices[0]) * m_VertexCount;
-		uint32_t vertexSize = sizeof(vertices[0]);
 
-		Buffer stagingBuffer
+		const GeometryPool::Heap heap = m_VertexFormat == VertexFormat::Packed ? GeometryPool::Heap::PackedVertices : GeometryPool::Heap::Vertices;
+		m_Vertices = m_GeometryPool.Allocate(heap, vertices, m_VertexCount);
+	}
+
+	void Mesh::SetLods(const Lod* lods, uint32_t lodCount)
+	{
+		m_Lods.assign(lods, lods + lodCount);
+		if(m_Lods.empty())
 		{
-			m_Device,
-			vertexSize,
-			m_VertexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-		};
+			m_Lods.push_back({ 0, m_IndexCount, 0.f });
+		}
+	}
+
+	void Mesh::CreateMeshletBuffer(const std::vector<Meshlet>& meshlets)
+	{
+		m_Meshlets = meshlets;
+		if(m_Meshlets.empty())
+		{
+			return;
+		}
 
-		stagingBuffer.Map();
-		stagingBuffer.WriteToBuffer((void*)vertices.data());
+		const uint32_t meshletSize = sizeof(Meshlet);
+		const uint32_t meshletCount = static_cast<uint32_t>(m_Meshlets.size());
 
-		m_VertexBuffer = std::make_unique<Buffer>
+		m_pMeshletBuffer = std::make_unique<Buffer>
 		(
 			m_Device,
-			vertexSize,
-			m_VertexCount,
-			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			meshletSize,
+			meshletCount,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
 		);
 
-		m_Device.CopyBuffer(stagingBuffer.GetBuffer(), m_VertexBuffer->GetBuffer(), bufferSize);
+		m_Device.GetUploader().UploadBuffer(m_pMeshletBuffer->GetBuffer(), 0, m_Meshlets.data(), static_cast<VkDeviceSize>(meshletSize) * meshletCount);
 	}
 
-	void Mesh::CreateIndexBuffer(const std::vector<uint32_t>& indices)
+	void Mesh::CreateIndexBuffer(const uint32_t* indices, uint32_t indexCount, bool isStrip)
 	{
-		m_IndexCount = static_cast<uint32_t>(indices.size());
+		m_IndexCount = indexCount;
 		m_HasIndexBuffer = m_IndexCount > 0;
+		m_IsStrip = isStrip;
 
 		if(!m_HasIndexBuffer)
 		{
 			return;
 		}
 
-		VkDeviceSize bufferSize = sizeof(indices[0]) * m_IndexCount;
-		uint32_t indexSize = sizeof(indices[0]);
+		const uint32_t triangleCount = m_IsStrip ? MeshStripifier::CountStripTriangles(indices, m_IndexCount) : m_IndexCount / 3;
+		const uint32_t listSize = triangleCount * 3 * sizeof(uint32_t);
 
-		Buffer stagingBuffer
+		// the largest index stays below 0xffff, which is the 16 bit restart index
+		if(m_VertexCount <= 0xffff)
 		{
-			m_Device,
-			indexSize,
-			m_IndexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-		};
-
-		stagingBuffer.Map();
-		stagingBuffer.WriteToBuffer((void*)indices.data());
+			std::vector<uint16_t> narrowIndices(m_IndexCount);
+			for(uint32_t index{}; index < m_IndexCount; ++index)
+			{
+				narrowIndices[index] = static_cast<uint16_t>(indices[index]);
+			}
 
-		m_pIndexBuffer = std::make_unique<Buffer>
-			(
-			m_Device,
-			indexSize,
-			m_IndexCount,
-			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
-		);
+			m_IndexType = VK_INDEX_TYPE_UINT16;
+			m_Indices = m_GeometryPool.Allocate(GeometryPool::Heap::Indices16, narrowIndices.data(), m_IndexCount);
+			m_IndexBytesSaved = listSize - m_IndexCount * static_cast<uint32_t>(sizeof(uint16_t));
+			return;
+		}
 
-		m_Device.CopyBuffer(stagingBuffer.GetBuffer(), m_pIndexBuffer->GetBuffer(), bufferSize);
+		m_IndexType = VK_INDEX_TYPE_UINT32;
+		m_Indices = m_GeometryPool.Allocate(GeometryPool::Heap::Indices, indices, m_IndexCount);
+		m_IndexBytesSaved = listSize - m_IndexCount * static_cast<uint32_t>(sizeof(uint32_t));
 	}
 }
@@ -1,20 +1,65 @@
 #pragma once
 #include "Device.h"
 #include "Buffer.h"
+#include "GeometryPool.h"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
 // std include
+#include <functional>
 #include <vector>
 #include <memory>
 
 namespace lve
 {
+	class MeshCache;
+
+	enum class VertexFormat
+	{
+		// 44 byte Mesh::Vertex
+		Full,
+		// 16 byte Mesh::PackedVertex
+		Packed
+	};
+
+	struct MeshLoadOptions
+	{
+		// above zero also welds near identical vertices
+		float weldEpsilon{ 0.f };
+		// reorders for the vertex cache, overdraw and vertex fetch before upload
+		bool optimize{ false };
+		VertexFormat vertexFormat{ VertexFormat::Full };
+		// 1 keeps only the full mesh, more builds coarser LODs that share its vertex buffer
+		uint32_t lodCount{ 1 };
+		// splits the full detail LOD into meshlets that can be culled one by one
+		bool buildMeshlets{ false };
+		// draws triangle strips with primitive restart when those take fewer indices, ignored with meshlets
+		bool buildStrips{ false };
+	};
+
+	// Everything that decides a generated perlin terrain, the same params always give the same heights
+	struct TerrainParams
+	{
+		int seed{ 1337 };
+		// noise frequency per sample of the first octave
+		float frequency{ 0.08f };
+		// every octave doubles the frequency of the previous one and scales its amplitude by gain
+		int octaves{ 3 };
+		float gain{ 0.5f };
+		int rows{ 128 };
+		int columns{ 128 };
+		// world size along x and z
+		glm::vec2 size{ 10.f, 10.f };
+	};
+
 	class Mesh final
 	{
 	public:
+		// ends a strip, narrowed to 0xffff in 16 bit index buffers
+		static constexpr uint32_t RESTART_INDEX{ 0xffffffff };
+
 		struct Vertex
 		{
 			glm::vec3 position{};
@@ -31,23 +76,132 @@ namespace lve
 			}
 		};
 
+		// Positions are 16 bit unorm inside the mesh bounds, the fourth component holds an 8:8 octahedral normal.
+		// Color is 8 bit unorm and uv is half float, drawn with the PackedShader vertex shader.
+		struct PackedVertex
+		{
+			uint16_t position[4]{};
+			uint8_t color[4]{};
+			uint16_t uv[2]{};
+
+			static std::vector<VkVertexInputBindingDescription> GetBindingDescriptions();
+			static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions();
+		};
+
+		// range of the index buffer holding one level of detail
+		struct Lod
+		{
+			uint32_t firstIndex;
+			uint32_t indexCount;
+			// largest distance the simplification moved the surface, in model space
+			float error;
+		};
+
+		// Cluster of the full detail LOD, laid out to match the std430 storage buffer
+		struct Meshlet
+		{
+			// bounding sphere
+			glm::vec3 center{};
+			float radius{};
+			// every triangle faces away from viewers for which dot(normalize(coneApex - viewer), coneAxis) >= coneCutoff
+			glm::vec3 coneApex{};
+			float coneCutoff{ 1.f };
+			glm::vec3 coneAxis{};
+			uint32_t firstIndex{};
+			uint32_t indexCount{};
+			uint32_t vertexCount{};
+			uint32_t padding[2]{};
+		};
+
 		struct Data
 		{
 			std::vector<Vertex> vertices{};
+			// every LOD back to back, all of them when lods is empty
 			std::vector<uint32_t> indices{};
+			std::vector<Lod> lods{};
+			std::vector<Meshlet> meshlets{};
+			// indices hold triangle strips separated by RESTART_INDEX
+			bool isStrip{ false };
 
-			void LoadModel(const std::string& filePath);
+			void LoadModel(const std::string& filePath, const MeshLoadOptions& options = {});
 		};
 		
-		Mesh(Device& device, const Data& builder);
+		// Staging buffer holding the preview vertices, then the terrain vertices, then the strip indices both of them use
+		struct TerrainBuild
+		{
+			std::unique_ptr<Buffer> pStagingBuffer;
+			int rows{};
+			int columns{};
+			// per mesh
+			uint32_t vertexCount{};
+			uint32_t indexCount{};
+			// 16 bit indices whenever the vertices fit below the restart index
+			bool isShortIndices{ false };
+			glm::vec3 previewBoundsMin{};
+			glm::vec3 previewBoundsMax{};
+			glm::vec3 terrainBoundsMin{};
+			glm::vec3 terrainBoundsMax{};
+		};
+
+		struct TerrainMeshes
+		{
+			std::unique_ptr<Mesh> pPerlinNoise;
+			std::unique_ptr<Mesh> pTerrain;
+		};
+
+		Mesh(Device& device, GeometryPool& geometryPool, const Data& builder, VertexFormat vertexFormat = VertexFormat::Full);
+		Mesh(Device& device, GeometryPool& geometryPool, const MeshCache& cache, VertexFormat vertexFormat = VertexFormat::Full);
+		// returns its ranges to the geometry pool
 		~Mesh();
 
+		// Meshes of one vertex format share pool buffers, skip the bind when these match the bound ones
 		void Bind(VkCommandBuffer commandBuffer);
-		void Draw(VkCommandBuffer commandBuffer);
+		VkBuffer GetVertexBuffer() const { return m_GeometryPool.GetBuffer(m_Vertices); }
+		VkBuffer GetIndexBuffer() const { return m_GeometryPool.GetBuffer(m_Indices); }
+		// where this mesh starts in the shared buffers, in vertices and indices
+		uint32_t GetVertexOffset() const { return m_Vertices.offset; }
+		uint32_t GetFirstIndex() const { return m_Indices.offset; }
+
+		// instances read per instance vertex attributes from firstInstance on
+		void Draw(VkCommandBuffer commandBuffer, uint32_t lod = 0, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
+		// Draws drawCount VkDrawIndexedIndirectCommands, one call per command when multiDrawIndirect is missing
+		void DrawIndirect(VkCommandBuffer commandBuffer, VkBuffer indirectBuffer, VkDeviceSize offset, uint32_t drawCount);
 
-		static std::unique_ptr<Mesh> CreateModelFromFile(Device& device, const std::string& filePath);
-		static std::pair<Device&, Data> GeneratePerlinNoiseMap(Device& device, int rows, int columns, float height, float width, float frequency);
-		static std::unique_ptr<Mesh> CreateTerrain(Device& device, int rows, int columns, Data previousData);
+		uint32_t GetLodCount() const { return static_cast<uint32_t>(m_Lods.size()); }
+		const Lod& GetLod(uint32_t lod) const { return m_Lods[lod]; }
+		// bounding sphere in model space
+		const glm::vec3& GetBoundsCenter() const { return m_BoundsCenter; }
+		float GetBoundsRadius() const { return m_BoundsRadius; }
+		const std::vector<Meshlet>& GetMeshlets() const { return m_Meshlets; }
+		// storage buffer with the meshlets, null when the mesh has none
+		Buffer* GetMeshletBuffer() const { return m_pMeshletBuffer.get(); }
+
+		VertexFormat GetVertexFormat() const { return m_VertexFormat; }
+		// strips need a pipeline with the strip topology and primitive restart
+		bool IsStrip() const { return m_IsStrip; }
+		// index buffer size compared to a 32 bit triangle list
+		uint32_t GetIndexBytesSaved() const { return m_IndexBytesSaved; }
+		// bytes of the geometry pool this mesh holds
+		VkDeviceSize GetGeometrySize() const { return GeometryPool::GetSize(m_Vertices) + GeometryPool::GetSize(m_BackVertices) + GeometryPool::GetSize(m_Indices); }
+		// Maps packed positions back into model space, identity for full vertices
+		const glm::mat4& GetDequantizeTransform() const { return m_DequantizeTransform; }
+
+		static std::unique_ptr<Mesh> CreateModelFromFile(Device& device, GeometryPool& geometryPool, const std::string& filePath, const MeshLoadOptions& options = {});
+		// Terrain heights of a perlin map, rows * columns values stored row by row, safe to run on a worker thread
+		static std::vector<float> GeneratePerlinHeights(const TerrainParams& params);
+		// Loads a perlin map through the heightmap cache and writes its flat preview and the terrain straight into
+		// one staging buffer, safe to run on a worker thread
+		static TerrainBuild BuildTerrain(Device& device, const TerrainParams& params);
+		// Copies a build into the geometry pool, both meshes draw with the same index range. Each mesh also reserves
+		// a second vertex range, so later builds of the same size replace the terrain in place.
+		static TerrainMeshes CreateTerrain(Device& device, GeometryPool& geometryPool, const TerrainBuild& build);
+		// Records copying a build of the same size into the vertex ranges the meshes do not draw, inside an Uploader batch.
+		// No frame in flight may still draw those ranges.
+		static void RecordTerrainUpdate(VkCommandBuffer commandBuffer, const TerrainBuild& build, Mesh& perlinNoise, Mesh& terrain);
+		// Draws the ranges RecordTerrainUpdate wrote once its commands are done
+		static void SwapTerrain(const TerrainBuild& build, Mesh& perlinNoise, Mesh& terrain);
+		// Triangle strips over a rows x columns grid of vertices stored row by row
+		static void GenerateGridIndices(int rows, int columns, Data& data);
 
 		Mesh(const Mesh&) = delete;
 		Mesh(Mesh&&) = delete;
@@ -55,15 +209,47 @@ namespace lve
 		Mesh& operator=(Mesh&&) = delete;
 
 	private:
-		void CreateVertexBuffers(const std::vector<Vertex>& vertices);
-		void CreateIndexBuffer(const std::vector<uint32_t>& indices);
+		// Draws full vertices already in the geometry pool with a strip index range that other meshes may share,
+		// backVertices is the same size and receives in place updates
+		Mesh(Device& device, GeometryPool& geometryPool, const GeometryPool::Allocation& vertices, const GeometryPool::Allocation& backVertices,
+			std::shared_ptr<const GeometryPool::Allocation> pIndices, uint32_t indexBytesSaved, const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+		void CreateVertexBuffers(const Vertex* vertices, uint32_t vertexCount);
+		void CreateVertexBuffer(const void* vertices, uint32_t vertexCount);
+		void CreateIndexBuffer(const uint32_t* indices, uint32_t indexCount, bool isStrip);
+		void SetLods(const Lod* lods, uint32_t lodCount);
+		// Runs body over bands of rows on the shared thread pool and returns once every row is done
+		static void ForEachRowBand(int rows, const std::function<void(int firstRow, int rowCount)>& body);
+		static uint32_t GetGridIndexCount(int rows, int columns);
+		template<typename Index>
+		static void WriteGridIndices(int rows, int columns, Index* pIndices);
+		// writes every vertex once, in order, since staging memory may be write combined
+		static void WriteTerrainVertices(const float* pHeights, int rows, int columns, float height, float width, Vertex* pPreviewVertices, Vertex* pTerrainVertices);
+		void CreateMeshletBuffer(const std::vector<Meshlet>& meshlets);
 
 		Device& m_Device;
-		std::unique_ptr<Buffer> m_VertexBuffer;
+		GeometryPool& m_GeometryPool;
+		VertexFormat m_VertexFormat;
+		glm::mat4 m_DequantizeTransform{ 1.f };
+		glm::vec3 m_BoundsCenter{};
+		float m_BoundsRadius{};
+		GeometryPool::Allocation m_Vertices{};
+		// empty unless the mesh is double buffered, then it is the range updates go into while m_Vertices is drawn
+		GeometryPool::Allocation m_BackVertices{};
 		uint32_t m_VertexCount;
 
 		bool m_HasIndexBuffer = false;
-		std::unique_ptr<Buffer> m_pIndexBuffer;
+		GeometryPool::Allocation m_Indices{};
+		// set when other meshes draw with the same index range, the last one to go frees it
+		std::shared_ptr<const GeometryPool::Allocation> m_pSharedIndices;
 		uint32_t m_IndexCount;
+		// 16 bit whenever every vertex fits below the restart index
+		VkIndexType m_IndexType{ VK_INDEX_TYPE_UINT32 };
+		bool m_IsStrip{ false };
+		uint32_t m_IndexBytesSaved{};
+		std::vector<Lod> m_Lods{};
+
+		std::vector<Meshlet> m_Meshlets{};
+		std::unique_ptr<Buffer> m_pMeshletBuffer;
 	};
 }
@@ -0,0 +1,183 @@
+#include "MeshCache.h"
+#include "Utils.h"
+
+// std
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace lve
+{
+	static constexpr char MESH_CACHE_MAGIC[4]{ 'L', 'V', 'E', 'M' };
+
+	std::string MeshCache::GetCachePath(const std::string& modelPath, const MeshLoadOptions& options)
+	{
+		// every set of options gets its own file, so assets loaded with different options do not keep overwriting each other
+		std::string suffix{};
+		if (options.optimize)
+		{
+			suffix += ".optimized";
+		}
+		if (options.weldEpsilon > 0.f)
+		{
+			suffix += ".weld" + std::to_string(options.weldEpsilon);
+		}
+		if (options.lodCount > 1)
+		{
+			suffix += ".lod" + std::to_string(options.lodCount);
+		}
+		return modelPath + suffix + ".meshcache";
+	}
+
+	bool MeshCache::Open(const std::string& modelPath, const MeshLoadOptions& options)
+	{
+		m_pHeader = nullptr;
+
+		if (!m_File.Open(GetCachePath(modelPath, options)) || m_File.GetSize() < sizeof(Header))
+		{
+			m_File.Close();
+			return false;
+		}
+
+		const auto* header = reinterpret_cast<const Header*>(m_File.GetData());
+		const uint64_t expectedSize = sizeof(Header)
+			+ static_cast<uint64_t>(header->vertexCount) * sizeof(Mesh::Vertex)
+			+ static_cast<uint64_t>(header->indexCount) * sizeof(uint32_t)
+			+ static_cast<uint64_t>(header->lodCount) * sizeof(Mesh::Lod);
+
+		if (std::memcmp(header->magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC)) != 0
+			|| header->version != VERSION
+			|| header->vertexStride != sizeof(Mesh::Vertex)
+			|| header->weldEpsilon != options.weldEpsilon
+			|| header->isOptimized != static_cast<uint32_t>(options.optimize)
+			|| m_File.GetSize() != expectedSize)
+		{
+			m_File.Close();
+			return false;
+		}
+
+		// size and timestamp are enough when nothing touched the OBJ, otherwise fall back to the content hash
+		std::error_code error{};
+		const uint64_t sourceSize = std::filesystem::file_size(modelPath, error);
+		if (error || sourceSize != header->sourceSize)
+		{
+			m_File.Close();
+			return false;
+		}
+
+		const int64_t sourceWriteTime = std::filesystem::last_write_time(modelPath, error).time_since_epoch().count();
+		if (error || sourceWriteTime != header->sourceWriteTime)
+		{
+			uint64_t sourceHash{};
+			if (!HashSource(modelPath, sourceHash) || sourceHash != header->sourceHash)
+			{
+				m_File.Close();
+				return false;
+			}
+		}
+
+		m_pHeader = header;
+		return true;
+	}
+
+	bool MeshCache::Write(const std::string& modelPath, const Mesh::Data& data, const MeshLoadOptions& options)
+	{
+		Header header{};
+		std::memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC));
+		header.version = VERSION;
+		header.vertexStride = sizeof(Mesh::Vertex);
+		header.vertexCount = static_cast<uint32_t>(data.vertices.size());
+		header.indexCount = static_cast<uint32_t>(data.indices.size());
+		header.weldEpsilon = options.weldEpsilon;
+		header.isOptimized = static_cast<uint32_t>(options.optimize);
+		header.lodCount = static_cast<uint32_t>(data.lods.size());
+
+		std::error_code error{};
+		header.sourceSize = std::filesystem::file_size(modelPath, error);
+		if (!error)
+		{
+			header.sourceWriteTime = std::filesystem::last_write_time(modelPath, error).time_since_epoch().count();
+		}
+
+		if (error || !HashSource(modelPath, header.sourceHash))
+		{
+			return false;
+		}
+
+		// write next to the final file and rename, so a crash never leaves a half written cache behind
+		// and loads of the same model on two threads never write into the same file
+		const std::string cachePath = GetCachePath(modelPath, options);
+		const std::string tempPath = cachePath + "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			if (!file.is_open())
+			{
+				std::cerr << "Failed to write mesh cache: " << cachePath << std::endl;
+				return false;
+			}
+
+			file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+			file.write(reinterpret_cast<const char*>(data.vertices.data()), data.vertices.size() * sizeof(Mesh::Vertex));
+			file.write(reinterpret_cast<const char*>(data.indices.data()), data.indices.size() * sizeof(uint32_t));
+			file.write(reinterpret_cast<const char*>(data.lods.data()), data.lods.size() * sizeof(Mesh::Lod));
+
+			if (!file.good())
+			{
+				file.close();
+				std::filesystem::remove(tempPath, error);
+				std::cerr << "Failed to write mesh cache: " << cachePath << std::endl;
+				return false;
+			}
+		}
+
+		std::filesystem::rename(tempPath, cachePath, error);
+		if (error)
+		{
+			std::filesystem::remove(tempPath, error);
+			std::cerr << "Failed to write mesh cache: " << cachePath << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	const Mesh::Vertex* MeshCache::GetVertices() const
+	{
+		if (!m_pHeader)
+		{
+			return nullptr;
+		}
+		return reinterpret_cast<const Mesh::Vertex*>(m_File.GetData() + sizeof(Header));
+	}
+
+	const uint32_t* MeshCache::GetIndices() const
+	{
+		if (!m_pHeader)
+		{
+			return nullptr;
+		}
+		return reinterpret_cast<const uint32_t*>(m_File.GetData() + sizeof(Header) + m_pHeader->vertexCount * sizeof(Mesh::Vertex));
+	}
+
+	const Mesh::Lod* MeshCache::GetLods() const
+	{
+		if (!m_pHeader)
+		{
+			return nullptr;
+		}
+		return reinterpret_cast<const Mesh::Lod*>(reinterpret_cast<const uint8_t*>(GetIndices()) + m_pHeader->indexCount * sizeof(uint32_t));
+	}
+
+	bool MeshCache::HashSource(const std::string& modelPath, uint64_t& hash)
+	{
+		MappedFile source{};
+		if (!source.Open(modelPath))
+		{
+			return false;
+		}
+
+		hash = HashBytes(source.GetData(), source.GetSize());
+		return true;
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "Mesh.h"
+#include "MappedFile.h"
+
+// std includes
+#include <cstdint>
+#include <string>
+
+namespace lve
+{
+	// Binary copy of an already deduplicated model and its LODs, written next to the source OBJ.
+	// A valid cache is mapped instead of parsed, so its vertices and indices can go straight into a staging buffer.
+	class MeshCache final
+	{
+	public:
+		static constexpr uint32_t VERSION{ 3 };
+
+		MeshCache() = default;
+		~MeshCache() = default;
+
+		MeshCache(const MeshCache&) = delete;
+		MeshCache(MeshCache&&) = delete;
+		MeshCache& operator=(const MeshCache&) = delete;
+		MeshCache& operator=(MeshCache&&) = delete;
+
+		// Maps the cache of modelPath, fails when it is missing, from another version, stale or built with other options
+		bool Open(const std::string& modelPath, const MeshLoadOptions& options = {});
+		static bool Write(const std::string& modelPath, const Mesh::Data& data, const MeshLoadOptions& options = {});
+		static std::string GetCachePath(const std::string& modelPath, const MeshLoadOptions& options = {});
+
+		const Mesh::Vertex* GetVertices() const;
+		const uint32_t* GetIndices() const;
+		uint32_t GetVertexCount() const { return m_pHeader ? m_pHeader->vertexCount : 0; }
+		uint32_t GetIndexCount() const { return m_pHeader ? m_pHeader->indexCount : 0; }
+		const Mesh::Lod* GetLods() const;
+		uint32_t GetLodCount() const { return m_pHeader ? m_pHeader->lodCount : 0; }
+
+	private:
+		struct Header
+		{
+			char magic[4];
+			uint32_t version;
+			uint64_t sourceSize;
+			int64_t sourceWriteTime;
+			uint64_t sourceHash;
+			uint32_t vertexStride;
+			uint32_t vertexCount;
+			uint32_t indexCount;
+			float weldEpsilon;
+			uint32_t isOptimized;
+			uint32_t lodCount;
+		};
+
+		static bool HashSource(const std::string& modelPath, uint64_t& hash);
+
+		MappedFile m_File;
+		const Header* m_pHeader{ nullptr };
+	};
+}
@@ -0,0 +1,361 @@
+#include "MeshOptimizer.h"
+
+// std
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+namespace lve
+{
+	// FIFO cache of recent vertex indices, a vertex counts as cached while fewer than cacheSize misses happened since it was loaded
+	class FifoCache final
+	{
+	public:
+		FifoCache(size_t vertexCount, uint32_t cacheSize)
+			: m_Timestamps(vertexCount, 0)
+			, m_CacheSize{ cacheSize }
+			, m_Time{ cacheSize + 1 }
+		{
+		}
+
+		// Returns true on a miss
+		bool Access(uint32_t vertex)
+		{
+			if (m_Time - m_Timestamps[vertex] > m_CacheSize)
+			{
+				m_Timestamps[vertex] = m_Time++;
+				return true;
+			}
+			return false;
+		}
+
+		void Reset()
+		{
+			m_Time += m_CacheSize + 1;
+		}
+
+	private:
+		std::vector<uint32_t> m_Timestamps;
+		uint32_t m_CacheSize;
+		uint32_t m_Time;
+	};
+
+	void MeshOptimizer::Optimize(Mesh::Data& data, const std::string& name)
+	{
+		if (data.indices.size() < 3)
+		{
+			return;
+		}
+
+		const Stats before = AnalyzeVertexCache(data);
+
+		OptimizeVertexCache(data);
+		OptimizeOverdraw(data);
+		OptimizeVertexFetch(data);
+
+		const Stats after = AnalyzeVertexCache(data);
+		std::cout << name << ": ACMR " << before.acmr << " -> " << after.acmr
+			<< ", ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+	}
+
+	void MeshOptimizer::OptimizeVertexCache(Mesh::Data& data, uint32_t cacheSize)
+	{
+		OptimizeVertexCache(data.indices, data.vertices.size(), cacheSize);
+	}
+
+	// Tipsify from Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"
+	void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+	{
+		const size_t triangleCount = indices.size() / 3;
+
+		// vertex to triangle adjacency
+		std::vector<uint32_t> liveTriangles(vertexCount, 0);
+		for (uint32_t index : indices)
+		{
+			++liveTriangles[index];
+		}
+
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		std::inclusive_scan(liveTriangles.begin(), liveTriangles.end(), adjacencyOffsets.begin() + 1);
+
+		std::vector<uint32_t> adjacency(indices.size());
+		{
+			std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t corner{}; corner < triangleCount * 3; ++corner)
+			{
+				adjacency[fill[indices[corner]]++] = static_cast<uint32_t>(corner / 3);
+			}
+		}
+
+		std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+		std::vector<bool> isEmitted(triangleCount, false);
+		std::vector<uint32_t> deadEndStack{};
+		std::vector<uint32_t> candidates{};
+
+		std::vector<uint32_t> result{};
+		result.reserve(triangleCount * 3);
+
+		uint32_t time{ cacheSize + 1 };
+		uint32_t cursor{};
+		int64_t fanningVertex = triangleCount > 0 ? 0 : -1;
+
+		while (fanningVertex >= 0)
+		{
+			candidates.clear();
+
+			const uint32_t vertex = static_cast<uint32_t>(fanningVertex);
+			for (uint32_t adjacent{ adjacencyOffsets[vertex] }; adjacent < adjacencyOffsets[vertex + 1]; ++adjacent)
+			{
+				const uint32_t triangle = adjacency[adjacent];
+				if (isEmitted[triangle])
+				{
+					continue;
+				}
+
+				for (uint32_t corner{}; corner < 3; ++corner)
+				{
+					const uint32_t triangleVertex = indices[triangle * 3 + corner];
+					result.push_back(triangleVertex);
+					deadEndStack.push_back(triangleVertex);
+					candidates.push_back(triangleVertex);
+					--liveTriangles[triangleVertex];
+
+					if (time - cacheTimestamps[triangleVertex] > cacheSize)
+					{
+						cacheTimestamps[triangleVertex] = time++;
+					}
+				}
+				isEmitted[triangle] = true;
+			}
+
+			// prefer the candidate that stays in the cache while its remaining triangles get emitted
+			fanningVertex = -1;
+			int64_t bestPriority{ -1 };
+			for (uint32_t candidate : candidates)
+			{
+				if (liveTriangles[candidate] == 0)
+				{
+					continue;
+				}
+
+				int64_t priority{ 0 };
+				if (time - cacheTimestamps[candidate] + 2 * liveTriangles[candidate] <= cacheSize)
+				{
+					priority = time - cacheTimestamps[candidate];
+				}
+
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					fanningVertex = candidate;
+				}
+			}
+
+			if (fanningVertex >= 0)
+			{
+				continue;
+			}
+
+			// dead end, restart from a recently used vertex or else the next one in input order
+			while (!deadEndStack.empty() && fanningVertex < 0)
+			{
+				const uint32_t deadEndVertex = deadEndStack.back();
+				deadEndStack.pop_back();
+				if (liveTriangles[deadEndVertex] > 0)
+				{
+					fanningVertex = deadEndVertex;
+				}
+			}
+
+			while (fanningVertex < 0 && cursor < vertexCount)
+			{
+				if (liveTriangles[cursor] > 0)
+				{
+					fanningVertex = cursor;
+				}
+				++cursor;
+			}
+		}
+
+		indices = std::move(result);
+	}
+
+	void MeshOptimizer::OptimizeOverdraw(Mesh::Data& data, float threshold, uint32_t cacheSize)
+	{
+		const size_t triangleCount = data.indices.size() / 3;
+		if (triangleCount == 0)
+		{
+			return;
+		}
+
+		const std::vector<uint32_t>& indices = data.indices;
+
+		// hard boundaries where the cache order already starts over, every vertex of the triangle misses
+		std::vector<uint32_t> hardClusters{};
+		{
+			FifoCache cache{ data.vertices.size(), cacheSize };
+			for (uint32_t triangle{}; triangle < triangleCount; ++triangle)
+			{
+				uint32_t misses{};
+				for (uint32_t corner{}; corner < 3; ++corner)
+				{
+					misses += cache.Access(indices[triangle * 3 + corner]);
+				}
+
+				if (triangle == 0 || misses == 3)
+				{
+					hardClusters.push_back(triangle);
+				}
+			}
+			hardClusters.push_back(static_cast<uint32_t>(triangleCount));
+		}
+
+		// soft boundaries split a hard cluster wherever restarting the cache costs less than the threshold allows
+		std::vector<uint32_t> clusters{};
+		{
+			FifoCache cache{ data.vertices.size(), cacheSize };
+			for (size_t hardCluster{}; hardCluster + 1 < hardClusters.size(); ++hardCluster)
+			{
+				const uint32_t begin = hardClusters[hardCluster];
+				const uint32_t end = hardClusters[hardCluster + 1];
+
+				cache.Reset();
+				uint32_t clusterMisses{};
+				for (uint32_t corner{ begin * 3 }; corner < end * 3; ++corner)
+				{
+					clusterMisses += cache.Access(indices[corner]);
+				}
+				const float targetAcmr = static_cast<float>(clusterMisses) / static_cast<float>(end - begin) * threshold;
+
+				cache.Reset();
+				clusters.push_back(begin);
+				uint32_t start{ begin };
+				uint32_t misses{};
+				for (uint32_t triangle{ begin }; triangle < end; ++triangle)
+				{
+					for (uint32_t corner{}; corner < 3; ++corner)
+					{
+						misses += cache.Access(indices[triangle * 3 + corner]);
+					}
+
+					if (triangle + 1 < end && static_cast<float>(misses) / static_cast<float>(triangle + 1 - start) <= targetAcmr)
+					{
+						start = triangle + 1;
+						misses = 0;
+						cache.Reset();
+						clusters.push_back(start);
+					}
+				}
+			}
+			clusters.push_back(static_cast<uint32_t>(triangleCount));
+		}
+
+		const size_t clusterCount = clusters.size() - 1;
+		if (clusterCount < 2)
+		{
+			return;
+		}
+
+		// draw the clusters that face away from the mesh center first, they tend to occlude the rest
+		glm::vec3 meshCenter{};
+		float meshArea{};
+		std::vector<glm::vec3> clusterCenters(clusterCount, glm::vec3{});
+		std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3{});
+
+		for (size_t cluster{}; cluster < clusterCount; ++cluster)
+		{
+			float clusterArea{};
+			for (uint32_t triangle{ clusters[cluster] }; triangle < clusters[cluster + 1]; ++triangle)
+			{
+				const glm::vec3& p0 = data.vertices[indices[triangle * 3 + 0]].position;
+				const glm::vec3& p1 = data.vertices[indices[triangle * 3 + 1]].position;
+				const glm::vec3& p2 = data.vertices[indices[triangle * 3 + 2]].position;
+
+				const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+				const float area = glm::length(normal);
+				const glm::vec3 center = (p0 + p1 + p2) / 3.f;
+
+				clusterCenters[cluster] += center * area;
+				clusterNormals[cluster] += normal;
+				clusterArea += area;
+				meshCenter += center * area;
+				meshArea += area;
+			}
+
+			if (clusterArea > 0.f)
+			{
+				clusterCenters[cluster] /= clusterArea;
+			}
+		}
+
+		if (meshArea > 0.f)
+		{
+			meshCenter /= meshArea;
+		}
+
+		std::vector<float> sortKeys(clusterCount);
+		for (size_t cluster{}; cluster < clusterCount; ++cluster)
+		{
+			const float normalLength = glm::length(clusterNormals[cluster]);
+			const glm::vec3 normal = normalLength > 0.f ? clusterNormals[cluster] / normalLength : glm::vec3{};
+			sortKeys[cluster] = glm::dot(clusterCenters[cluster] - meshCenter, normal);
+		}
+
+		std::vector<uint32_t> order(clusterCount);
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&sortKeys](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+		std::vector<uint32_t> result{};
+		result.reserve(indices.size());
+		for (uint32_t cluster : order)
+		{
+			result.insert(result.end(), indices.begin() + clusters[cluster] * 3, indices.begin() + clusters[cluster + 1] * 3);
+		}
+
+		data.indices = std::move(result);
+	}
+
+	void MeshOptimizer::OptimizeVertexFetch(Mesh::Data& data)
+	{
+		constexpr uint32_t unused{ UINT32_MAX };
+		std::vector<uint32_t> remap(data.vertices.size(), unused);
+
+		std::vector<Mesh::Vertex> vertices{};
+		vertices.reserve(data.vertices.size());
+
+		for (uint32_t& index : data.indices)
+		{
+			if (remap[index] == unused)
+			{
+				remap[index] = static_cast<uint32_t>(vertices.size());
+				vertices.push_back(data.vertices[index]);
+			}
+			index = remap[index];
+		}
+
+		data.vertices = std::move(vertices);
+	}
+
+	MeshOptimizer::Stats MeshOptimizer::AnalyzeVertexCache(const Mesh::Data& data, uint32_t cacheSize)
+	{
+		FifoCache cache{ data.vertices.size(), cacheSize };
+
+		uint32_t misses{};
+		for (uint32_t index : data.indices)
+		{
+			misses += cache.Access(index);
+		}
+
+		Stats stats{};
+		if (!data.indices.empty())
+		{
+			stats.acmr = static_cast<float>(misses) / static_cast<float>(data.indices.size() / 3);
+		}
+		if (!data.vertices.empty())
+		{
+			stats.atvr = static_cast<float>(misses) / static_cast<float>(data.vertices.size());
+		}
+		return stats;
+	}
+}
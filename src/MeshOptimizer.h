@@ -0,0 +1,41 @@
+#pragma once
+#include "Mesh.h"
+
+// std includes
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lve
+{
+	// Reorders an indexed triangle list before upload so the GPU runs the vertex shader less often:
+	// triangles for the post-transform cache (Tipsify), clusters of those for overdraw, then vertices in first use order.
+	class MeshOptimizer final
+	{
+	public:
+		static constexpr uint32_t CACHE_SIZE{ 16 };
+
+		struct Stats
+		{
+			// average cache miss ratio, vertex shader invocations per triangle
+			float acmr;
+			// average transform to vertex ratio, vertex shader invocations per unique vertex
+			float atvr;
+		};
+
+		MeshOptimizer() = delete;
+
+		// Runs every pass and logs the cache statistics from before and after
+		static void Optimize(Mesh::Data& data, const std::string& name);
+
+		static void OptimizeVertexCache(Mesh::Data& data, uint32_t cacheSize = CACHE_SIZE);
+		static void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = CACHE_SIZE);
+		// Only reorders whole clusters whose cache cost stays within threshold times the current one, run after OptimizeVertexCache
+		static void OptimizeOverdraw(Mesh::Data& data, float threshold = 1.05f, uint32_t cacheSize = CACHE_SIZE);
+		// Renumbers the vertices in the order the indices first use them and drops unreferenced ones
+		static void OptimizeVertexFetch(Mesh::Data& data);
+
+		// Simulates a FIFO post-transform cache
+		static Stats AnalyzeVertexCache(const Mesh::Data& data, uint32_t cacheSize = CACHE_SIZE);
+	};
+}
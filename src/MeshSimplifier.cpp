@@ -0,0 +1,387 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include "Utils.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+
+namespace lve
+{
+	// weight of the planes that keep open borders in place
+	static constexpr double BOUNDARY_WEIGHT{ 10.0 };
+
+	// symmetric 4x4 matrix of the squared distance to a set of planes
+	struct Quadric
+	{
+		double a2{}, ab{}, ac{}, ad{}, b2{}, bc{}, bd{}, c2{}, cd{}, d2{};
+
+		static Quadric FromPlane(const glm::dvec3& normal, double distance, double weight)
+		{
+			Quadric quadric{};
+			quadric.a2 = weight * normal.x * normal.x;
+			quadric.ab = weight * normal.x * normal.y;
+			quadric.ac = weight * normal.x * normal.z;
+			quadric.ad = weight * normal.x * distance;
+			quadric.b2 = weight * normal.y * normal.y;
+			quadric.bc = weight * normal.y * normal.z;
+			quadric.bd = weight * normal.y * distance;
+			quadric.c2 = weight * normal.z * normal.z;
+			quadric.cd = weight * normal.z * distance;
+			quadric.d2 = weight * distance * distance;
+			return quadric;
+		}
+
+		Quadric& operator+=(const Quadric& other)
+		{
+			a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+			b2 += other.b2; bc += other.bc; bd += other.bd;
+			c2 += other.c2; cd += other.cd;
+			d2 += other.d2;
+			return *this;
+		}
+
+		double Evaluate(const glm::dvec3& point) const
+		{
+			const double x = point.x, y = point.y, z = point.z;
+			const double result = a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x
+				+ b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y
+				+ c2 * z * z + 2.0 * cd * z
+				+ d2;
+			return std::max(result, 0.0);
+		}
+	};
+
+	struct Collapse
+	{
+		double cost;
+		uint32_t from;
+		uint32_t to;
+		uint32_t fromVersion;
+		uint32_t toVersion;
+
+		bool operator>(const Collapse& other) const { return cost > other.cost; }
+	};
+
+	struct PositionHash
+	{
+		size_t operator()(const glm::vec3& position) const
+		{
+			// adding zero turns -0 into +0, which compare equal and so have to hash equal
+			const glm::vec3 normalized{ position.x + 0.f, position.y + 0.f, position.z + 0.f };
+			return static_cast<size_t>(HashBytes(&normalized, sizeof(glm::vec3)));
+		}
+	};
+
+	std::vector<uint32_t> MeshSimplifier::Simplify(const std::vector<Mesh::Vertex>& vertices, const std::vector<uint32_t>& indices,
+		size_t targetIndexCount, float maxError, float& error)
+	{
+		error = 0.f;
+		const size_t triangleCount = indices.size() / 3;
+
+		// collapse on positions, so attribute seams (flat shading, uv borders) move together and never tear open
+		std::vector<uint32_t> positionOf(vertices.size());
+		std::vector<glm::dvec3> positions{};
+		std::vector<std::vector<uint32_t>> siblings{};
+		{
+			std::unordered_map<glm::vec3, uint32_t, PositionHash> positionIds{};
+			positionIds.reserve(vertices.size());
+			for (uint32_t vertex{}; vertex < vertices.size(); ++vertex)
+			{
+				const auto [it, isNew] = positionIds.try_emplace(vertices[vertex].position, static_cast<uint32_t>(positions.size()));
+				if (isNew)
+				{
+					positions.push_back(glm::dvec3{ vertices[vertex].position });
+					siblings.emplace_back();
+				}
+				positionOf[vertex] = it->second;
+				siblings[it->second].push_back(vertex);
+			}
+		}
+
+		const size_t positionCount = positions.size();
+		std::vector<uint32_t> remap(positionCount);
+		for (uint32_t position{}; position < positionCount; ++position)
+		{
+			remap[position] = position;
+		}
+
+		auto find = [&remap](uint32_t position)
+		{
+			while (remap[position] != position)
+			{
+				remap[position] = remap[remap[position]];
+				position = remap[position];
+			}
+			return position;
+		};
+
+		std::vector<bool> isTriangleAlive(triangleCount, true);
+		std::vector<std::vector<uint32_t>> trianglesOf(positionCount);
+		std::vector<Quadric> quadrics(positionCount);
+		std::unordered_map<uint64_t, uint32_t> edgeUses{};
+		edgeUses.reserve(triangleCount * 3);
+
+		size_t aliveTriangles{};
+		for (uint32_t triangle{}; triangle < triangleCount; ++triangle)
+		{
+			const uint32_t p0 = positionOf[indices[triangle * 3 + 0]];
+			const uint32_t p1 = positionOf[indices[triangle * 3 + 1]];
+			const uint32_t p2 = positionOf[indices[triangle * 3 + 2]];
+			if (p0 == p1 || p1 == p2 || p0 == p2)
+			{
+				isTriangleAlive[triangle] = false;
+				continue;
+			}
+			++aliveTriangles;
+
+			const glm::dvec3 normal = glm::cross(positions[p1] - positions[p0], positions[p2] - positions[p0]);
+			const double length = glm::length(normal);
+			if (length > 0.0)
+			{
+				const glm::dvec3 unitNormal = normal / length;
+				const Quadric quadric = Quadric::FromPlane(unitNormal, -glm::dot(unitNormal, positions[p0]), 1.0);
+				quadrics[p0] += quadric;
+				quadrics[p1] += quadric;
+				quadrics[p2] += quadric;
+			}
+
+			for (const uint32_t position : { p0, p1, p2 })
+			{
+				trianglesOf[position].push_back(triangle);
+			}
+
+			const uint32_t corners[3]{ p0, p1, p2 };
+			for (uint32_t corner{}; corner < 3; ++corner)
+			{
+				const uint32_t a = std::min(corners[corner], corners[(corner + 1) % 3]);
+				const uint32_t b = std::max(corners[corner], corners[(corner + 1) % 3]);
+				++edgeUses[(static_cast<uint64_t>(a) << 32) | b];
+			}
+		}
+
+		// edges with a single triangle are open borders, pin them with a plane perpendicular to that triangle
+		for (uint32_t triangle{}; triangle < triangleCount; ++triangle)
+		{
+			if (!isTriangleAlive[triangle])
+			{
+				continue;
+			}
+
+			const uint32_t corners[3]{ positionOf[indices[triangle * 3 + 0]], positionOf[indices[triangle * 3 + 1]], positionOf[indices[triangle * 3 + 2]] };
+			const glm::dvec3 normal = glm::cross(positions[corners[1]] - positions[corners[0]], positions[corners[2]] - positions[corners[0]]);
+
+			for (uint32_t corner{}; corner < 3; ++corner)
+			{
+				const uint32_t a = corners[corner];
+				const uint32_t b = corners[(corner + 1) % 3];
+				if (edgeUses[(static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b)] != 1)
+				{
+					continue;
+				}
+
+				const glm::dvec3 borderNormal = glm::cross(positions[b] - positions[a], normal);
+				const double length = glm::length(borderNormal);
+				if (length > 0.0)
+				{
+					const glm::dvec3 unitNormal = borderNormal / length;
+					const Quadric quadric = Quadric::FromPlane(unitNormal, -glm::dot(unitNormal, positions[a]), BOUNDARY_WEIGHT);
+					quadrics[a] += quadric;
+					quadrics[b] += quadric;
+				}
+			}
+		}
+
+		std::vector<uint32_t> versions(positionCount, 0);
+		std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> collapses{};
+
+		auto pushCollapse = [&](uint32_t from, uint32_t to)
+		{
+			Quadric quadric = quadrics[from];
+			quadric += quadrics[to];
+			collapses.push({ quadric.Evaluate(positions[to]), from, to, versions[from], versions[to] });
+		};
+
+		for (const auto& [edge, uses] : edgeUses)
+		{
+			const uint32_t a = static_cast<uint32_t>(edge >> 32);
+			const uint32_t b = static_cast<uint32_t>(edge & 0xFFFFFFFFu);
+			pushCollapse(a, b);
+			pushCollapse(b, a);
+		}
+
+		auto trianglePositions = [&](uint32_t triangle, uint32_t corners[3])
+		{
+			for (uint32_t corner{}; corner < 3; ++corner)
+			{
+				corners[corner] = find(positionOf[indices[triangle * 3 + corner]]);
+			}
+		};
+
+		const double maxCost = static_cast<double>(maxError) * static_cast<double>(maxError);
+		const size_t targetTriangles = targetIndexCount / 3;
+
+		while (aliveTriangles > targetTriangles && !collapses.empty())
+		{
+			const Collapse collapse = collapses.top();
+			collapses.pop();
+
+			if (collapse.cost > maxCost)
+			{
+				break;
+			}
+
+			const uint32_t from = collapse.from;
+			const uint32_t to = collapse.to;
+			if (remap[from] != from || remap[to] != to || versions[from] != collapse.fromVersion || versions[to] != collapse.toVersion)
+			{
+				continue;
+			}
+
+			// reject collapses that would flip a remaining triangle
+			bool isFlipping{ false };
+			for (uint32_t triangle : trianglesOf[from])
+			{
+				uint32_t corners[3];
+				trianglePositions(triangle, corners);
+				if (!isTriangleAlive[triangle] || corners[0] == to || corners[1] == to || corners[2] == to)
+				{
+					continue;
+				}
+
+				const glm::dvec3 oldNormal = glm::cross(positions[corners[1]] - positions[corners[0]], positions[corners[2]] - positions[corners[0]]);
+				for (uint32_t& corner : corners)
+				{
+					corner = corner == from ? to : corner;
+				}
+				const glm::dvec3 newNormal = glm::cross(positions[corners[1]] - positions[corners[0]], positions[corners[2]] - positions[corners[0]]);
+
+				if (glm::dot(oldNormal, newNormal) <= 0.0)
+				{
+					isFlipping = true;
+					break;
+				}
+			}
+
+			if (isFlipping)
+			{
+				continue;
+			}
+
+			remap[from] = to;
+			quadrics[to] += quadrics[from];
+			++versions[to];
+			error = std::max(error, static_cast<float>(std::sqrt(collapse.cost)));
+
+			for (uint32_t triangle : trianglesOf[from])
+			{
+				if (!isTriangleAlive[triangle])
+				{
+					continue;
+				}
+
+				uint32_t corners[3];
+				trianglePositions(triangle, corners);
+				if (corners[0] == corners[1] || corners[1] == corners[2] || corners[0] == corners[2])
+				{
+					isTriangleAlive[triangle] = false;
+					--aliveTriangles;
+				}
+				else
+				{
+					trianglesOf[to].push_back(triangle);
+				}
+			}
+			trianglesOf[from].clear();
+			trianglesOf[from].shrink_to_fit();
+
+			// costs around the merged vertex changed
+			std::erase_if(trianglesOf[to], [&isTriangleAlive](uint32_t triangle) { return !isTriangleAlive[triangle]; });
+			for (uint32_t triangle : trianglesOf[to])
+			{
+				uint32_t corners[3];
+				trianglePositions(triangle, corners);
+				for (uint32_t corner : corners)
+				{
+					if (corner != to)
+					{
+						pushCollapse(corner, to);
+						pushCollapse(to, corner);
+					}
+				}
+			}
+		}
+
+		// corners that moved pick the vertex at their new position whose attributes match best
+		auto pickVertex = [&](uint32_t vertex, uint32_t position)
+		{
+			const Mesh::Vertex& original = vertices[vertex];
+			uint32_t best{ siblings[position].front() };
+			float bestScore{ std::numeric_limits<float>::lowest() };
+			for (uint32_t sibling : siblings[position])
+			{
+				const Mesh::Vertex& candidate = vertices[sibling];
+				const glm::vec2 uvDelta = candidate.uv - original.uv;
+				const float score = glm::dot(candidate.normal, original.normal) - glm::dot(uvDelta, uvDelta);
+				if (score > bestScore)
+				{
+					bestScore = score;
+					best = sibling;
+				}
+			}
+			return best;
+		};
+
+		std::vector<uint32_t> result{};
+		result.reserve(aliveTriangles * 3);
+		for (uint32_t triangle{}; triangle < triangleCount; ++triangle)
+		{
+			if (!isTriangleAlive[triangle])
+			{
+				continue;
+			}
+
+			for (uint32_t corner{}; corner < 3; ++corner)
+			{
+				const uint32_t vertex = indices[triangle * 3 + corner];
+				const uint32_t position = find(positionOf[vertex]);
+				result.push_back(position == positionOf[vertex] ? vertex : pickVertex(vertex, position));
+			}
+		}
+
+		return result;
+	}
+
+	void MeshSimplifier::GenerateLods(Mesh::Data& data, uint32_t lodCount)
+	{
+		data.lods.clear();
+		data.lods.push_back({ 0, static_cast<uint32_t>(data.indices.size()), 0.f });
+
+		const std::vector<uint32_t> sourceIndices = data.indices;
+		size_t previousIndexCount = sourceIndices.size();
+
+		for (uint32_t lod{ 1 }; lod < lodCount; ++lod)
+		{
+			const size_t targetIndexCount = static_cast<size_t>(previousIndexCount / 3 * LOD_REDUCTION) * 3;
+
+			// always simplify the full mesh, errors do not pile up that way
+			float error{};
+			std::vector<uint32_t> lodIndices = Simplify(data.vertices, sourceIndices, targetIndexCount, std::numeric_limits<float>::max(), error);
+
+			// not worth a level when barely anything could be removed
+			if (lodIndices.empty() || lodIndices.size() > previousIndexCount * 9 / 10)
+			{
+				break;
+			}
+
+			MeshOptimizer::OptimizeVertexCache(lodIndices, data.vertices.size());
+
+			data.lods.push_back({ static_cast<uint32_t>(data.indices.size()), static_cast<uint32_t>(lodIndices.size()), error });
+			data.indices.insert(data.indices.end(), lodIndices.begin(), lodIndices.end());
+			previousIndexCount = lodIndices.size();
+		}
+	}
+}
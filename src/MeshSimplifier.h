@@ -0,0 +1,28 @@
+#pragma once
+#include "Mesh.h"
+
+// std includes
+#include <cstdint>
+#include <vector>
+
+namespace lve
+{
+	// Quadric error metric simplification (Garland and Heckbert) that only collapses edges onto existing vertices,
+	// so every LOD is an index list into the same vertex buffer.
+	class MeshSimplifier final
+	{
+	public:
+		// every LOD aims for this fraction of the triangles of the previous one
+		static constexpr float LOD_REDUCTION{ 0.5f };
+
+		MeshSimplifier() = delete;
+
+		// Collapses edges until at most targetIndexCount indices remain or the next collapse would move the surface further than maxError.
+		// error receives the largest collapse error that was accepted, in model space units.
+		static std::vector<uint32_t> Simplify(const std::vector<Mesh::Vertex>& vertices, const std::vector<uint32_t>& indices,
+			size_t targetIndexCount, float maxError, float& error);
+
+		// Appends up to lodCount - 1 coarser LODs behind the indices of data, stopping early once simplification no longer pays off
+		static void GenerateLods(Mesh::Data& data, uint32_t lodCount);
+	};
+}
@@ -0,0 +1,166 @@
+#include "MeshStripifier.h"
+
+namespace lve
+{
+	bool MeshStripifier::Stripify(Mesh::Data& data)
+	{
+		// meshlets index into the triangle list
+		if (data.isStrip || !data.meshlets.empty() || data.indices.empty())
+		{
+			return false;
+		}
+
+		std::vector<Mesh::Lod> lods = data.lods;
+		if (lods.empty())
+		{
+			lods.push_back({ 0, static_cast<uint32_t>(data.indices.size()), 0.f });
+		}
+
+		std::vector<uint32_t> indices{};
+		for (auto& lod : lods)
+		{
+			const std::vector<uint32_t> strip = Stripify(data.indices.data() + lod.firstIndex, lod.indexCount, data.vertices.size());
+			lod.firstIndex = static_cast<uint32_t>(indices.size());
+			lod.indexCount = static_cast<uint32_t>(strip.size());
+			indices.insert(indices.end(), strip.begin(), strip.end());
+		}
+
+		if (indices.size() >= data.indices.size())
+		{
+			return false;
+		}
+
+		data.indices = std::move(indices);
+		if (!data.lods.empty())
+		{
+			data.lods = std::move(lods);
+		}
+		data.isStrip = true;
+		return true;
+	}
+
+	std::vector<uint32_t> MeshStripifier::Stripify(const uint32_t* indices, uint32_t indexCount, size_t vertexCount)
+	{
+		const uint32_t triangleCount = indexCount / 3;
+
+		// triangles around every vertex, flattened
+		std::vector<uint32_t> firstTriangle(vertexCount + 1, 0);
+		for (uint32_t index{}; index < triangleCount * 3; ++index)
+		{
+			++firstTriangle[indices[index] + 1];
+		}
+		for (size_t vertex{}; vertex < vertexCount; ++vertex)
+		{
+			firstTriangle[vertex + 1] += firstTriangle[vertex];
+		}
+
+		std::vector<uint32_t> vertexTriangles(triangleCount * 3);
+		std::vector<uint32_t> fill(firstTriangle.begin(), firstTriangle.end() - 1);
+		for (uint32_t index{}; index < triangleCount * 3; ++index)
+		{
+			vertexTriangles[fill[indices[index]]++] = index / 3;
+		}
+
+		std::vector<bool> isUsed(triangleCount, false);
+
+		// unused triangle with the directed edge from -> to, its third vertex goes in third
+		auto findTriangle = [&](uint32_t from, uint32_t to, uint32_t& third) -> uint32_t
+		{
+			for (uint32_t slot = firstTriangle[from]; slot < firstTriangle[from + 1]; ++slot)
+			{
+				const uint32_t triangle = vertexTriangles[slot];
+				if (isUsed[triangle])
+				{
+					continue;
+				}
+
+				const uint32_t* pCorners = indices + triangle * 3;
+				for (uint32_t corner{}; corner < 3; ++corner)
+				{
+					if (pCorners[corner] == from && pCorners[(corner + 1) % 3] == to)
+					{
+						third = pCorners[(corner + 2) % 3];
+						return triangle;
+					}
+				}
+			}
+			return UINT32_MAX;
+		};
+
+		std::vector<uint32_t> strip{};
+		strip.reserve(indexCount);
+
+		uint32_t nextStart{};
+		while (true)
+		{
+			while (nextStart < triangleCount && isUsed[nextStart])
+			{
+				++nextStart;
+			}
+			if (nextStart == triangleCount)
+			{
+				break;
+			}
+
+			// start with the rotation whose last edge continues into a neighbour
+			const uint32_t* pCorners = indices + nextStart * 3;
+			uint32_t rotation{};
+			for (uint32_t candidate{}; candidate < 3; ++candidate)
+			{
+				uint32_t third{};
+				if (findTriangle(pCorners[(candidate + 2) % 3], pCorners[(candidate + 1) % 3], third) != UINT32_MAX)
+				{
+					rotation = candidate;
+					break;
+				}
+			}
+
+			if (!strip.empty())
+			{
+				strip.push_back(Mesh::RESTART_INDEX);
+			}
+			strip.push_back(pCorners[rotation]);
+			strip.push_back(pCorners[(rotation + 1) % 3]);
+			strip.push_back(pCorners[(rotation + 2) % 3]);
+			isUsed[nextStart] = true;
+
+			// odd triangles of a strip are wound the other way, so they need the reversed edge
+			bool isOdd{ true };
+			while (true)
+			{
+				const uint32_t previous = strip[strip.size() - 2];
+				const uint32_t last = strip.back();
+
+				uint32_t third{};
+				const uint32_t triangle = isOdd ? findTriangle(last, previous, third) : findTriangle(previous, last, third);
+				if (triangle == UINT32_MAX)
+				{
+					break;
+				}
+
+				strip.push_back(third);
+				isUsed[triangle] = true;
+				isOdd = !isOdd;
+			}
+		}
+
+		return strip;
+	}
+
+	uint32_t MeshStripifier::CountStripTriangles(const uint32_t* indices, uint32_t indexCount)
+	{
+		uint32_t triangleCount{};
+		uint32_t stripLength{};
+		for (uint32_t index{}; index <= indexCount; ++index)
+		{
+			if (index == indexCount || indices[index] == Mesh::RESTART_INDEX)
+			{
+				triangleCount += stripLength >= 3 ? stripLength - 2 : 0;
+				stripLength = 0;
+				continue;
+			}
+			++stripLength;
+		}
+		return triangleCount;
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "Mesh.h"
+
+// std includes
+#include <cstdint>
+#include <vector>
+
+namespace lve
+{
+	// Rewrites triangle lists as triangle strips separated by Mesh::RESTART_INDEX, keeping the winding of every triangle.
+	// Strips start in the current triangle order, so a vertex cache optimized mesh mostly stays optimized.
+	class MeshStripifier final
+	{
+	public:
+		MeshStripifier() = delete;
+
+		// Converts every LOD and returns true, unless the strips would not be smaller or the mesh has meshlets
+		static bool Stripify(Mesh::Data& data);
+
+		static std::vector<uint32_t> Stripify(const uint32_t* indices, uint32_t indexCount, size_t vertexCount);
+		// triangles in indices drawn as strips with restarts
+		static uint32_t CountStripTriangles(const uint32_t* indices, uint32_t indexCount);
+	};
+}
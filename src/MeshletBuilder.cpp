@@ -0,0 +1,149 @@
+#include "MeshletBuilder.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace lve
+{
+	// below this the triangles spread over more than a hemisphere and the cone can never cull
+	static constexpr float MIN_CONE_SPREAD{ 0.1f };
+
+	std::vector<Mesh::Meshlet> MeshletBuilder::Build(const std::vector<Mesh::Vertex>& vertices, const std::vector<uint32_t>& indices,
+		uint32_t firstIndex, uint32_t indexCount)
+	{
+		std::vector<Mesh::Meshlet> meshlets{};
+		if (indexCount < 3)
+		{
+			return meshlets;
+		}
+
+		// which meshlet last used a vertex, so the vertex count only grows on first use
+		std::vector<uint32_t> lastMeshlet(vertices.size(), UINT32_MAX);
+
+		Mesh::Meshlet meshlet{};
+		meshlet.firstIndex = firstIndex;
+
+		auto finishMeshlet = [&](uint32_t nextIndex)
+		{
+			meshlet.indexCount = nextIndex - meshlet.firstIndex;
+			ComputeBounds(vertices, indices, meshlet);
+			meshlets.push_back(meshlet);
+
+			meshlet = Mesh::Meshlet{};
+			meshlet.firstIndex = nextIndex;
+		};
+
+		auto countNewVertices = [&](uint32_t index, uint32_t meshletIndex)
+		{
+			uint32_t newVertices{};
+			for (uint32_t corner{}; corner < 3; ++corner)
+			{
+				const uint32_t vertex = indices[index + corner];
+				const bool isRepeated = (corner > 0 && indices[index] == vertex) || (corner > 1 && indices[index + 1] == vertex);
+				newVertices += lastMeshlet[vertex] != meshletIndex && !isRepeated;
+			}
+			return newVertices;
+		};
+
+		const uint32_t endIndex = firstIndex + indexCount / 3 * 3;
+		for (uint32_t index{ firstIndex }; index < endIndex; index += 3)
+		{
+			uint32_t newVertices = countNewVertices(index, static_cast<uint32_t>(meshlets.size()));
+
+			const uint32_t triangleCount = (index - meshlet.firstIndex) / 3;
+			if (meshlet.vertexCount + newVertices > MAX_VERTICES || triangleCount + 1 > MAX_TRIANGLES)
+			{
+				finishMeshlet(index);
+				newVertices = countNewVertices(index, static_cast<uint32_t>(meshlets.size()));
+			}
+
+			for (uint32_t corner{}; corner < 3; ++corner)
+			{
+				lastMeshlet[indices[index + corner]] = static_cast<uint32_t>(meshlets.size());
+			}
+			meshlet.vertexCount += newVertices;
+		}
+
+		if (endIndex > meshlet.firstIndex)
+		{
+			finishMeshlet(endIndex);
+		}
+
+		return meshlets;
+	}
+
+	void MeshletBuilder::ComputeBounds(const std::vector<Mesh::Vertex>& vertices, const std::vector<uint32_t>& indices, Mesh::Meshlet& meshlet)
+	{
+		const uint32_t endIndex = meshlet.firstIndex + meshlet.indexCount;
+
+		glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+		glm::vec3 boundsMax{ std::numeric_limits<float>::lowest() };
+		for (uint32_t index{ meshlet.firstIndex }; index < endIndex; ++index)
+		{
+			boundsMin = glm::min(boundsMin, vertices[indices[index]].position);
+			boundsMax = glm::max(boundsMax, vertices[indices[index]].position);
+		}
+
+		meshlet.center = (boundsMin + boundsMax) * 0.5f;
+		meshlet.radius = 0.f;
+		for (uint32_t index{ meshlet.firstIndex }; index < endIndex; ++index)
+		{
+			meshlet.radius = std::max(meshlet.radius, glm::length(vertices[indices[index]].position - meshlet.center));
+		}
+
+		// normal cone from the face normals, the mesh vertex normals can be smoothed across the silhouette
+		glm::vec3 axis{};
+		std::vector<glm::vec3> normals{};
+		normals.reserve(meshlet.indexCount / 3);
+		for (uint32_t index{ meshlet.firstIndex }; index < endIndex; index += 3)
+		{
+			const glm::vec3& p0 = vertices[indices[index + 0]].position;
+			const glm::vec3& p1 = vertices[indices[index + 1]].position;
+			const glm::vec3& p2 = vertices[indices[index + 2]].position;
+
+			const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			const float length = glm::length(normal);
+			if (length > 0.f)
+			{
+				normals.push_back(normal / length);
+				axis += normals.back();
+			}
+		}
+
+		meshlet.coneApex = meshlet.center;
+		meshlet.coneAxis = glm::vec3{ 0.f, 0.f, 1.f };
+		meshlet.coneCutoff = 1.f;
+
+		const float axisLength = glm::length(axis);
+		if (normals.empty() || axisLength <= 0.f)
+		{
+			return;
+		}
+		axis /= axisLength;
+
+		float minDot{ 1.f };
+		for (const glm::vec3& normal : normals)
+		{
+			minDot = std::min(minDot, glm::dot(normal, axis));
+		}
+
+		if (minDot <= MIN_CONE_SPREAD)
+		{
+			return;
+		}
+
+		// move the apex back until every triangle plane lies in front of it
+		float apexDistance{};
+		for (uint32_t index{ meshlet.firstIndex }; index < endIndex; ++index)
+		{
+			const glm::vec3 offset = meshlet.center - vertices[indices[index]].position;
+			apexDistance = std::max(apexDistance, glm::dot(offset, axis) / minDot);
+		}
+
+		meshlet.coneApex = meshlet.center - axis * apexDistance;
+		meshlet.coneAxis = axis;
+		meshlet.coneCutoff = std::sqrt(1.f - minDot * minDot);
+	}
+}
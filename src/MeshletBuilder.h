@@ -0,0 +1,26 @@
+#pragma once
+#include "Mesh.h"
+
+// std includes
+#include <cstdint>
+#include <vector>
+
+namespace lve
+{
+	// Splits an index range into meshlets of at most MAX_VERTICES vertices and MAX_TRIANGLES triangles.
+	// Triangles are taken in their current order, so a vertex cache optimized mesh stays optimized.
+	class MeshletBuilder final
+	{
+	public:
+		static constexpr uint32_t MAX_VERTICES{ 64 };
+		static constexpr uint32_t MAX_TRIANGLES{ 124 };
+
+		MeshletBuilder() = delete;
+
+		static std::vector<Mesh::Meshlet> Build(const std::vector<Mesh::Vertex>& vertices, const std::vector<uint32_t>& indices,
+			uint32_t firstIndex, uint32_t indexCount);
+
+	private:
+		static void ComputeBounds(const std::vector<Mesh::Vertex>& vertices, const std::vector<uint32_t>& indices, Mesh::Meshlet& meshlet);
+	};
+}
@@ -0,0 +1,136 @@
+#include "NoiseGrid.h"
+
+//libs
+#include "3rdParty/FastNoiseLite.h"
+
+#if defined(LVE_NOISE_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace lve
+{
+	const float NoiseGrid::GRADIENTS[256] =
+	{
+		0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+		0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+		0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+		-0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+		-0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+		-0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+		0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+		0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+		0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+		-0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+		-0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+		-0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+		0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+		0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+		0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+		-0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+		-0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+		-0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+		0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+		0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+		0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+		-0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+		-0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+		-0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+		0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+		0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+		0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+		-0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+		-0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+		-0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+		0.38268343236509f, 0.923879532511287f, 0.923879532511287f, 0.38268343236509f, 0.923879532511287f, -0.38268343236509f, 0.38268343236509f, -0.923879532511287f,
+		-0.38268343236509f, -0.923879532511287f, -0.923879532511287f, -0.38268343236509f, -0.923879532511287f, 0.38268343236509f, -0.38268343236509f, 0.923879532511287f
+	};
+
+	NoiseGrid::Isa NoiseGrid::GetBestIsa()
+	{
+		static const Isa bestIsa = []()
+		{
+#if defined(LVE_NOISE_X86) && defined(_MSC_VER)
+			int info[4]{};
+			__cpuid(info, 0);
+			const int maxLeaf = info[0];
+
+			__cpuid(info, 1);
+			const bool hasSse41 = (info[2] & (1 << 19)) != 0;
+			// the OS has to save the ymm registers too
+			const bool hasAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+
+			bool hasAvx2{ false };
+			if (hasAvx && maxLeaf >= 7)
+			{
+				__cpuidex(info, 7, 0);
+				hasAvx2 = (info[1] & (1 << 5)) != 0;
+			}
+
+			return hasAvx2 ? Isa::Avx2 : hasSse41 ? Isa::Sse41 : Isa::Scalar;
+#elif defined(LVE_NOISE_X86)
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2") ? Isa::Avx2 : __builtin_cpu_supports("sse4.1") ? Isa::Sse41 : Isa::Scalar;
+#else
+			return Isa::Scalar;
+#endif
+		}();
+
+		return bestIsa;
+	}
+
+	const char* NoiseGrid::GetIsaName(Isa isa)
+	{
+		switch (isa)
+		{
+		case Isa::Sse41:
+			return "SSE4.1";
+		case Isa::Avx2:
+			return "AVX2";
+		default:
+			return "scalar";
+		}
+	}
+
+	void NoiseGrid::GeneratePerlin(int seed, float frequency, const std::vector<Octave>& octaves, int firstColumn, int columns,
+		int firstRow, int rowCount, float* pHeights, Isa isa)
+	{
+		for (int row{}; row < rowCount; ++row)
+		{
+			float* pRow = pHeights + static_cast<size_t>(row) * columns;
+			for (size_t octave{}; octave < octaves.size(); ++octave)
+			{
+				const bool isFirst = octave == 0;
+
+				int start{};
+#ifdef LVE_NOISE_X86
+				if (isa == Isa::Avx2)
+				{
+					start = PerlinRowAvx2(seed, frequency, octaves[octave], firstRow + row, firstColumn, columns, pRow, isFirst);
+				}
+				else if (isa == Isa::Sse41)
+				{
+					start = PerlinRowSse41(seed, frequency, octaves[octave], firstRow + row, firstColumn, columns, pRow, isFirst);
+				}
+#endif
+				PerlinRowScalar(seed, frequency, octaves[octave], firstRow + row, firstColumn, start, columns, pRow, isFirst);
+			}
+		}
+	}
+
+	void NoiseGrid::PerlinRowScalar(int seed, float frequency, const Octave& octave, int y, int firstColumn, int start, int columns, float* pRow, bool isFirst)
+	{
+		FastNoiseLite noise(seed);
+		noise.SetFrequency(frequency);
+		noise.SetNoiseType(FastNoiseLite::NoiseType_Perlin);
+		noise.SetRotationType3D(FastNoiseLite::RotationType3D_None);
+		noise.SetFractalType(FastNoiseLite::FractalType_None);
+
+		const float sampleY = static_cast<float>(y) * octave.scale;
+		for (int x = start; x < columns; ++x)
+		{
+			const float value = octave.amplitude * noise.GetNoise(static_cast<float>(firstColumn + x) * octave.scale, sampleY);
+			pRow[x] = isFirst ? value : pRow[x] + value;
+		}
+	}
+}
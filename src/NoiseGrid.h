@@ -0,0 +1,60 @@
+#pragma once
+
+// std includes
+#include <cstdint>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define LVE_NOISE_X86
+#endif
+
+namespace lve
+{
+	// Evaluates 2D Perlin noise over whole rows of a grid at once, bit identical to FastNoiseLite::GetNoise
+	// with NoiseType_Perlin, no fractal and no rotation. The SIMD paths never fuse multiply and add,
+	// so they round exactly like the scalar library.
+	class NoiseGrid final
+	{
+	public:
+		enum class Isa
+		{
+			Scalar,
+			Sse41,
+			Avx2
+		};
+
+		// summed in order, each one samples at the grid coordinate times scale
+		struct Octave
+		{
+			float scale;
+			float amplitude;
+		};
+
+		NoiseGrid() = delete;
+
+		// widest instruction set this CPU and OS support
+		static Isa GetBestIsa();
+		static const char* GetIsaName(Isa isa);
+
+		// Writes rowCount rows of columns samples starting at firstColumn and firstRow, heights[row * columns + column]
+		// is the sum of amplitude * GetNoise((firstColumn + column) * scale, (firstRow + row) * scale) over the octaves
+		static void GeneratePerlin(int seed, float frequency, const std::vector<Octave>& octaves, int firstColumn, int columns,
+			int firstRow, int rowCount, float* pHeights, Isa isa = GetBestIsa());
+
+	private:
+		// Adds amplitude * noise at ((firstColumn + x) * scale, y * scale) to pRow[x] for x from start, or stores it when isFirst
+		static void PerlinRowScalar(int seed, float frequency, const Octave& octave, int y, int firstColumn, int start, int columns, float* pRow, bool isFirst);
+#ifdef LVE_NOISE_X86
+		// both handle every full vector and leave the remainder to PerlinRowScalar
+		static int PerlinRowSse41(int seed, float frequency, const Octave& octave, int y, int firstColumn, int columns, float* pRow, bool isFirst);
+		static int PerlinRowAvx2(int seed, float frequency, const Octave& octave, int y, int firstColumn, int columns, float* pRow, bool isFirst);
+#endif
+
+		// FastNoiseLite's 2D gradient table, gradient i is at 2 * i
+		static const float GRADIENTS[256];
+		static constexpr int PRIME_X{ 501125321 };
+		static constexpr int PRIME_Y{ 1136930381 };
+		static constexpr int HASH_MULTIPLIER{ 0x27d4eb2d };
+		static constexpr float PERLIN_SCALE{ 1.4247691104677813f };
+	};
+}
@@ -0,0 +1,88 @@
+#include "NoiseGrid.h"
+
+#ifdef LVE_NOISE_X86
+#include <immintrin.h>
+
+namespace lve
+{
+	// Every operation below mirrors FastNoiseLite::SinglePerlin in the same order, eight columns at a time
+	int NoiseGrid::PerlinRowAvx2(int seed, float frequency, const Octave& octave, int y, int firstColumn, int columns, float* pRow, bool isFirst)
+	{
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.f);
+		const __m256 six = _mm256_set1_ps(6.f);
+		const __m256 fifteen = _mm256_set1_ps(15.f);
+		const __m256 ten = _mm256_set1_ps(10.f);
+		const __m256 scale = _mm256_set1_ps(octave.scale);
+		const __m256 amplitude = _mm256_set1_ps(octave.amplitude);
+		const __m256 frequencies = _mm256_set1_ps(frequency);
+		const __m256i seeds = _mm256_set1_epi32(seed);
+		const __m256i primeX = _mm256_set1_epi32(PRIME_X);
+		const __m256i multiplier = _mm256_set1_epi32(HASH_MULTIPLIER);
+		const __m256i gradientMask = _mm256_set1_epi32(127 << 1);
+		const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+		// the row coordinate is the same for every lane, so its half of the work stays scalar
+		const float sampleY = static_cast<float>(y) * octave.scale * frequency;
+		const int y0 = sampleY >= 0 ? static_cast<int>(sampleY) : static_cast<int>(sampleY) - 1;
+		const float yd0 = sampleY - static_cast<float>(y0);
+		const float yd1 = yd0 - 1;
+		const float ys = yd0 * yd0 * yd0 * (yd0 * (yd0 * 6 - 15) + 10);
+		const __m256i y0Primed = _mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>(y0) * static_cast<uint32_t>(PRIME_Y)));
+		const __m256i y1Primed = _mm256_add_epi32(y0Primed, _mm256_set1_epi32(PRIME_Y));
+
+		auto interpQuintic = [&](__m256 t)
+		{
+			const __m256 cube = _mm256_mul_ps(_mm256_mul_ps(t, t), t);
+			return _mm256_mul_ps(cube, _mm256_add_ps(_mm256_mul_ps(t, _mm256_sub_ps(_mm256_mul_ps(t, six), fifteen)), ten));
+		};
+
+		auto lerp = [](__m256 a, __m256 b, __m256 t)
+		{
+			return _mm256_add_ps(a, _mm256_mul_ps(t, _mm256_sub_ps(b, a)));
+		};
+
+		auto gradCoord = [&](__m256i xPrimed, __m256i yPrimed, __m256 xd, __m256 yd)
+		{
+			__m256i hash = _mm256_xor_si256(_mm256_xor_si256(seeds, xPrimed), yPrimed);
+			hash = _mm256_mullo_epi32(hash, multiplier);
+			hash = _mm256_xor_si256(hash, _mm256_srai_epi32(hash, 15));
+			hash = _mm256_and_si256(hash, gradientMask);
+
+			// hash is even, so hash | 1 is the next float
+			const __m256 xg = _mm256_i32gather_ps(GRADIENTS, hash, 4);
+			const __m256 yg = _mm256_i32gather_ps(GRADIENTS + 1, hash, 4);
+
+			return _mm256_add_ps(_mm256_mul_ps(xd, xg), _mm256_mul_ps(yd, yg));
+		};
+
+		const int vectorColumns = columns & ~7;
+		for (int x{}; x < vectorColumns; x += 8)
+		{
+			const __m256 sampleX = _mm256_mul_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(firstColumn + x), lanes)), scale), frequencies);
+
+			// FastFloor, truncation minus one for negative values
+			const __m256i truncated = _mm256_cvttps_epi32(sampleX);
+			const __m256i x0 = _mm256_add_epi32(truncated, _mm256_castps_si256(_mm256_cmp_ps(sampleX, zero, _CMP_LT_OQ)));
+
+			const __m256 xd0 = _mm256_sub_ps(sampleX, _mm256_cvtepi32_ps(x0));
+			const __m256 xd1 = _mm256_sub_ps(xd0, one);
+			const __m256 xs = interpQuintic(xd0);
+
+			const __m256i x0Primed = _mm256_mullo_epi32(x0, primeX);
+			const __m256i x1Primed = _mm256_add_epi32(x0Primed, primeX);
+
+			const __m256 yd0s = _mm256_set1_ps(yd0);
+			const __m256 yd1s = _mm256_set1_ps(yd1);
+			const __m256 xf0 = lerp(gradCoord(x0Primed, y0Primed, xd0, yd0s), gradCoord(x1Primed, y0Primed, xd1, yd0s), xs);
+			const __m256 xf1 = lerp(gradCoord(x0Primed, y1Primed, xd0, yd1s), gradCoord(x1Primed, y1Primed, xd1, yd1s), xs);
+			const __m256 noise = _mm256_mul_ps(lerp(xf0, xf1, _mm256_set1_ps(ys)), _mm256_set1_ps(PERLIN_SCALE));
+
+			const __m256 value = _mm256_mul_ps(amplitude, noise);
+			_mm256_storeu_ps(pRow + x, isFirst ? value : _mm256_add_ps(_mm256_loadu_ps(pRow + x), value));
+		}
+
+		return vectorColumns;
+	}
+}
+#endif
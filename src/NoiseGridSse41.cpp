@@ -0,0 +1,89 @@
+#include "NoiseGrid.h"
+
+#ifdef LVE_NOISE_X86
+#include <smmintrin.h>
+
+namespace lve
+{
+	// Every operation below mirrors FastNoiseLite::SinglePerlin in the same order, four columns at a time
+	int NoiseGrid::PerlinRowSse41(int seed, float frequency, const Octave& octave, int y, int firstColumn, int columns, float* pRow, bool isFirst)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.f);
+		const __m128 six = _mm_set1_ps(6.f);
+		const __m128 fifteen = _mm_set1_ps(15.f);
+		const __m128 ten = _mm_set1_ps(10.f);
+		const __m128 scale = _mm_set1_ps(octave.scale);
+		const __m128 amplitude = _mm_set1_ps(octave.amplitude);
+		const __m128 frequencies = _mm_set1_ps(frequency);
+		const __m128i seeds = _mm_set1_epi32(seed);
+		const __m128i primeX = _mm_set1_epi32(PRIME_X);
+		const __m128i multiplier = _mm_set1_epi32(HASH_MULTIPLIER);
+		const __m128i gradientMask = _mm_set1_epi32(127 << 1);
+		const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+
+		// the row coordinate is the same for every lane, so its half of the work stays scalar
+		const float sampleY = static_cast<float>(y) * octave.scale * frequency;
+		const int y0 = sampleY >= 0 ? static_cast<int>(sampleY) : static_cast<int>(sampleY) - 1;
+		const float yd0 = sampleY - static_cast<float>(y0);
+		const float yd1 = yd0 - 1;
+		const float ys = yd0 * yd0 * yd0 * (yd0 * (yd0 * 6 - 15) + 10);
+		const __m128i y0Primed = _mm_set1_epi32(static_cast<int>(static_cast<uint32_t>(y0) * static_cast<uint32_t>(PRIME_Y)));
+		const __m128i y1Primed = _mm_add_epi32(y0Primed, _mm_set1_epi32(PRIME_Y));
+
+		auto interpQuintic = [&](__m128 t)
+		{
+			const __m128 cube = _mm_mul_ps(_mm_mul_ps(t, t), t);
+			return _mm_mul_ps(cube, _mm_add_ps(_mm_mul_ps(t, _mm_sub_ps(_mm_mul_ps(t, six), fifteen)), ten));
+		};
+
+		auto lerp = [](__m128 a, __m128 b, __m128 t)
+		{
+			return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+		};
+
+		auto gradCoord = [&](__m128i xPrimed, __m128i yPrimed, __m128 xd, __m128 yd)
+		{
+			__m128i hash = _mm_xor_si128(_mm_xor_si128(seeds, xPrimed), yPrimed);
+			hash = _mm_mullo_epi32(hash, multiplier);
+			hash = _mm_xor_si128(hash, _mm_srai_epi32(hash, 15));
+			hash = _mm_and_si128(hash, gradientMask);
+
+			alignas(16) int indices[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(indices), hash);
+			const __m128 xg = _mm_setr_ps(GRADIENTS[indices[0]], GRADIENTS[indices[1]], GRADIENTS[indices[2]], GRADIENTS[indices[3]]);
+			const __m128 yg = _mm_setr_ps(GRADIENTS[indices[0] | 1], GRADIENTS[indices[1] | 1], GRADIENTS[indices[2] | 1], GRADIENTS[indices[3] | 1]);
+
+			return _mm_add_ps(_mm_mul_ps(xd, xg), _mm_mul_ps(yd, yg));
+		};
+
+		const int vectorColumns = columns & ~3;
+		for (int x{}; x < vectorColumns; x += 4)
+		{
+			const __m128 sampleX = _mm_mul_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(firstColumn + x), lanes)), scale), frequencies);
+
+			// FastFloor, truncation minus one for negative values
+			const __m128i truncated = _mm_cvttps_epi32(sampleX);
+			const __m128i x0 = _mm_add_epi32(truncated, _mm_castps_si128(_mm_cmplt_ps(sampleX, zero)));
+
+			const __m128 xd0 = _mm_sub_ps(sampleX, _mm_cvtepi32_ps(x0));
+			const __m128 xd1 = _mm_sub_ps(xd0, one);
+			const __m128 xs = interpQuintic(xd0);
+
+			const __m128i x0Primed = _mm_mullo_epi32(x0, primeX);
+			const __m128i x1Primed = _mm_add_epi32(x0Primed, primeX);
+
+			const __m128 yd0s = _mm_set1_ps(yd0);
+			const __m128 yd1s = _mm_set1_ps(yd1);
+			const __m128 xf0 = lerp(gradCoord(x0Primed, y0Primed, xd0, yd0s), gradCoord(x1Primed, y0Primed, xd1, yd0s), xs);
+			const __m128 xf1 = lerp(gradCoord(x0Primed, y1Primed, xd0, yd1s), gradCoord(x1Primed, y1Primed, xd1, yd1s), xs);
+			const __m128 noise = _mm_mul_ps(lerp(xf0, xf1, _mm_set1_ps(ys)), _mm_set1_ps(PERLIN_SCALE));
+
+			const __m128 value = _mm_mul_ps(amplitude, noise);
+			_mm_storeu_ps(pRow + x, isFirst ? value : _mm_add_ps(_mm_loadu_ps(pRow + x), value));
+		}
+
+		return vectorColumns;
+	}
+}
+#endif
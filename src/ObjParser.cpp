@@ -0,0 +1,511 @@
+#include "ObjParser.h"
+#include "MappedFile.h"
+
+//libs
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <TinyObjLoader.h>
+
+//std
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+
+namespace lve
+{
+	// smaller chunks cost more in scheduling than they win in parallelism
+	static constexpr size_t MIN_CHUNK_SIZE{ 64 * 1024 };
+	static constexpr uint32_t CHUNKS_PER_THREAD{ 4 };
+
+	static constexpr uint8_t RELATIVE_POSITION{ 1 << 0 };
+	static constexpr uint8_t RELATIVE_TEXCOORD{ 1 << 1 };
+	static constexpr uint8_t RELATIVE_NORMAL{ 1 << 2 };
+
+	struct ObjChunk
+	{
+		const char* begin{};
+		const char* end{};
+		ObjParser::Geometry geometry{};
+		// 3 or 4 corners per face, quads are split once all positions are known
+		std::vector<uint8_t> faceSizes{};
+		// negative OBJ indices count back from the vertices read so far, these are resolved while merging
+		std::vector<uint8_t> relativeMasks{};
+		bool isSupported{ true };
+	};
+
+	static const char* SkipSpaces(const char* current, const char* end)
+	{
+		while (current < end && (*current == ' ' || *current == '\t'))
+		{
+			++current;
+		}
+		return current;
+	}
+
+	static bool ParseFloat(const char*& current, const char* end, float& value)
+	{
+		current = SkipSpaces(current, end);
+		if (current < end && *current == '+')
+		{
+			++current;
+		}
+
+		// parsed as double like tinyobj does, so both paths round the same way
+		double result{};
+		const auto [last, error] = std::from_chars(current, end, result);
+		if (error != std::errc{})
+		{
+			return false;
+		}
+
+		value = static_cast<float>(result);
+		current = last;
+		return true;
+	}
+
+	static bool ParseIndex(const char*& current, const char* end, int32_t& value)
+	{
+		const auto [last, error] = std::from_chars(current, end, value);
+		if (error != std::errc{} || value == 0)
+		{
+			return false;
+		}
+
+		current = last;
+		return true;
+	}
+
+	// stores an OBJ index as zero based, or as an offset from the chunk start when it is relative
+	static int32_t ToChunkIndex(int32_t objIndex, size_t chunkCount, uint8_t relativeBit, uint8_t& mask)
+	{
+		if (objIndex < 0)
+		{
+			mask |= relativeBit;
+			return static_cast<int32_t>(chunkCount) + objIndex;
+		}
+		return objIndex - 1;
+	}
+
+	static bool ParseFace(const char* current, const char* end, ObjChunk& chunk)
+	{
+		ObjParser::Geometry& geometry = chunk.geometry;
+		const size_t positionCount = geometry.positions.size() / 3;
+		const size_t texcoordCount = geometry.texcoords.size() / 2;
+		const size_t normalCount = geometry.normals.size() / 3;
+
+		uint8_t faceSize{};
+		for (current = SkipSpaces(current, end); current < end; current = SkipSpaces(current, end))
+		{
+			ObjParser::Corner corner{ -1, -1, -1 };
+			uint8_t mask{};
+			int32_t index{};
+
+			if (!ParseIndex(current, end, index))
+			{
+				return false;
+			}
+			corner.position = ToChunkIndex(index, positionCount, RELATIVE_POSITION, mask);
+
+			if (current < end && *current == '/')
+			{
+				++current;
+				if (current < end && *current != '/')
+				{
+					if (!ParseIndex(current, end, index))
+					{
+						return false;
+					}
+					corner.texcoord = ToChunkIndex(index, texcoordCount, RELATIVE_TEXCOORD, mask);
+				}
+
+				if (current < end && *current == '/')
+				{
+					++current;
+					if (!ParseIndex(current, end, index))
+					{
+						return false;
+					}
+					corner.normal = ToChunkIndex(index, normalCount, RELATIVE_NORMAL, mask);
+				}
+			}
+
+			if (current < end && *current != ' ' && *current != '\t')
+			{
+				return false;
+			}
+
+			// polygons need tinyobj's triangulation
+			if (++faceSize > 4)
+			{
+				return false;
+			}
+
+			geometry.corners.push_back(corner);
+			chunk.relativeMasks.push_back(mask);
+		}
+
+		if (faceSize < 3)
+		{
+			return false;
+		}
+
+		chunk.faceSizes.push_back(faceSize);
+		return true;
+	}
+
+	static void ParseChunk(ObjChunk& chunk)
+	{
+		ObjParser::Geometry& geometry = chunk.geometry;
+
+		for (const char* line = chunk.begin; line < chunk.end;)
+		{
+			const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', chunk.end - line));
+			if (lineEnd == nullptr)
+			{
+				lineEnd = chunk.end;
+			}
+
+			const char* next = lineEnd < chunk.end ? lineEnd + 1 : chunk.end;
+			if (lineEnd > line && lineEnd[-1] == '\r')
+			{
+				--lineEnd;
+			}
+
+			const char* current = SkipSpaces(line, lineEnd);
+			line = next;
+
+			if (current == lineEnd || *current == '#')
+			{
+				continue;
+			}
+
+			// line continuations are rare enough to leave to tinyobj
+			if (lineEnd[-1] == '\\')
+			{
+				chunk.isSupported = false;
+				return;
+			}
+
+			const char* keywordEnd = current;
+			while (keywordEnd < lineEnd && *keywordEnd != ' ' && *keywordEnd != '\t')
+			{
+				++keywordEnd;
+			}
+			const std::string_view keyword{ current, static_cast<size_t>(keywordEnd - current) };
+			current = keywordEnd;
+
+			if (keyword == "v")
+			{
+				// x y z, x y z w or x y z r g b, colors default to white the way tinyobj does it
+				float values[6]{};
+				int componentCount{};
+				while (componentCount < 6 && ParseFloat(current, lineEnd, values[componentCount]))
+				{
+					++componentCount;
+				}
+
+				if (componentCount < 3)
+				{
+					chunk.isSupported = false;
+					return;
+				}
+
+				geometry.positions.insert(geometry.positions.end(), { values[0], values[1], values[2] });
+				if (componentCount == 6)
+				{
+					geometry.colors.insert(geometry.colors.end(), { values[3], values[4], values[5] });
+				}
+				else if (componentCount == 4)
+				{
+					geometry.colors.insert(geometry.colors.end(), { values[3], 1.f, 1.f });
+				}
+				else
+				{
+					geometry.colors.insert(geometry.colors.end(), { 1.f, 1.f, 1.f });
+				}
+			}
+			else if (keyword == "vn")
+			{
+				float x{}, y{}, z{};
+				if (!ParseFloat(current, lineEnd, x) || !ParseFloat(current, lineEnd, y) || !ParseFloat(current, lineEnd, z))
+				{
+					chunk.isSupported = false;
+					return;
+				}
+				geometry.normals.insert(geometry.normals.end(), { x, y, z });
+			}
+			else if (keyword == "vt")
+			{
+				float u{}, v{};
+				if (!ParseFloat(current, lineEnd, u))
+				{
+					chunk.isSupported = false;
+					return;
+				}
+				ParseFloat(current, lineEnd, v);
+				geometry.texcoords.insert(geometry.texcoords.end(), { u, v });
+			}
+			else if (keyword == "f")
+			{
+				if (!ParseFace(current, lineEnd, chunk))
+				{
+					chunk.isSupported = false;
+					return;
+				}
+			}
+			else if (keyword != "o" && keyword != "g" && keyword != "s" && keyword != "usemtl" && keyword != "mtllib")
+			{
+				// lines, points, free-form geometry and anything else unknown
+				chunk.isSupported = false;
+				return;
+			}
+		}
+	}
+
+	void ObjParser::Load(const std::string& filePath, Mesh::Data& data, float weldEpsilon)
+	{
+		Geometry geometry{};
+		if (!Parse(filePath, geometry, ThreadPool::GetShared()))
+		{
+			geometry = Geometry{};
+			ParseWithTinyObj(filePath, geometry);
+		}
+
+		const VertexWelder::Stats stats = BuildMeshData(geometry, data, weldEpsilon);
+		if (stats.mergedCount > 0)
+		{
+			std::cout << "Welded " << stats.mergedCount << " near identical corners in " << filePath << std::endl;
+		}
+	}
+
+	bool ObjParser::Parse(const std::string& filePath, Geometry& geometry, ThreadPool& threadPool)
+	{
+		MappedFile file{};
+		if (!file.Open(filePath) || file.GetSize() == 0)
+		{
+			return false;
+		}
+
+		const char* text = reinterpret_cast<const char*>(file.GetData());
+		const size_t size = file.GetSize();
+
+		// Split into line aligned chunks
+		const size_t maxChunks = static_cast<size_t>(threadPool.GetThreadCount()) * CHUNKS_PER_THREAD;
+		const size_t chunkCount = std::clamp<size_t>(size / MIN_CHUNK_SIZE, 1, std::max<size_t>(maxChunks, 1));
+
+		std::vector<ObjChunk> chunks(chunkCount);
+		const char* chunkBegin = text;
+		for (size_t index{}; index < chunkCount; ++index)
+		{
+			const char* chunkEnd = text + size;
+			if (index + 1 < chunkCount)
+			{
+				chunkEnd = std::max(chunkBegin, text + size * (index + 1) / chunkCount);
+				const void* newline = std::memchr(chunkEnd, '\n', text + size - chunkEnd);
+				chunkEnd = newline ? static_cast<const char*>(newline) + 1 : text + size;
+			}
+
+			chunks[index].begin = chunkBegin;
+			chunks[index].end = chunkEnd;
+			chunkBegin = chunkEnd;
+		}
+
+		// Tokenize
+		threadPool.ParallelFor(static_cast<uint32_t>(chunkCount), [&chunks](uint32_t index) { ParseChunk(chunks[index]); });
+
+		if (std::any_of(chunks.begin(), chunks.end(), [](const ObjChunk& chunk) { return !chunk.isSupported; }))
+		{
+			return false;
+		}
+
+		// Merge in file order: every chunk gets its offset into the combined arrays
+		struct ChunkOffsets
+		{
+			size_t positions, normals, texcoords, corners;
+		};
+
+		std::vector<ChunkOffsets> offsets(chunkCount);
+		ChunkOffsets total{};
+		for (size_t index{}; index < chunkCount; ++index)
+		{
+			offsets[index] = total;
+			const Geometry& chunkGeometry = chunks[index].geometry;
+			total.positions += chunkGeometry.positions.size();
+			total.normals += chunkGeometry.normals.size();
+			total.texcoords += chunkGeometry.texcoords.size();
+			for (uint8_t faceSize : chunks[index].faceSizes)
+			{
+				total.corners += faceSize == 4 ? 6 : 3;
+			}
+		}
+
+		geometry.positions.resize(total.positions);
+		geometry.colors.resize(total.positions);
+		geometry.normals.resize(total.normals);
+		geometry.texcoords.resize(total.texcoords);
+		geometry.corners.resize(total.corners);
+
+		threadPool.ParallelFor(static_cast<uint32_t>(chunkCount), [&](uint32_t index)
+		{
+			const Geometry& chunkGeometry = chunks[index].geometry;
+			std::copy(chunkGeometry.positions.begin(), chunkGeometry.positions.end(), geometry.positions.begin() + offsets[index].positions);
+			std::copy(chunkGeometry.colors.begin(), chunkGeometry.colors.end(), geometry.colors.begin() + offsets[index].positions);
+			std::copy(chunkGeometry.normals.begin(), chunkGeometry.normals.end(), geometry.normals.begin() + offsets[index].normals);
+			std::copy(chunkGeometry.texcoords.begin(), chunkGeometry.texcoords.end(), geometry.texcoords.begin() + offsets[index].texcoords);
+		});
+
+		const int32_t positionCount = static_cast<int32_t>(total.positions / 3);
+		const int32_t texcoordCount = static_cast<int32_t>(total.texcoords / 2);
+		const int32_t normalCount = static_cast<int32_t>(total.normals / 3);
+
+		// Resolve indices and split quads along their shortest diagonal, matching tinyobj
+		threadPool.ParallelFor(static_cast<uint32_t>(chunkCount), [&](uint32_t index)
+		{
+			ObjChunk& chunk = chunks[index];
+			const ChunkOffsets& offset = offsets[index];
+			const int32_t positionBase = static_cast<int32_t>(offset.positions / 3);
+			const int32_t texcoordBase = static_cast<int32_t>(offset.texcoords / 2);
+			const int32_t normalBase = static_cast<int32_t>(offset.normals / 3);
+
+			std::vector<Corner>& corners = chunk.geometry.corners;
+			for (size_t cornerIndex{}; cornerIndex < corners.size(); ++cornerIndex)
+			{
+				Corner& corner = corners[cornerIndex];
+				const uint8_t mask = chunk.relativeMasks[cornerIndex];
+
+				if (mask & RELATIVE_POSITION) corner.position += positionBase;
+				if (mask & RELATIVE_TEXCOORD) corner.texcoord += texcoordBase;
+				if (mask & RELATIVE_NORMAL) corner.normal += normalBase;
+
+				if (corner.position < 0 || corner.position >= positionCount
+					|| corner.texcoord < -1 || corner.texcoord >= texcoordCount
+					|| corner.normal < -1 || corner.normal >= normalCount)
+				{
+					chunk.isSupported = false;
+					return;
+				}
+			}
+
+			Corner* output = geometry.corners.data() + offset.corners;
+			const Corner* face = corners.data();
+			for (uint8_t faceSize : chunk.faceSizes)
+			{
+				if (faceSize == 3)
+				{
+					output = std::copy(face, face + 3, output);
+				}
+				else
+				{
+					auto squaredDistance = [&geometry](int32_t from, int32_t to)
+					{
+						const float x = geometry.positions[3 * to + 0] - geometry.positions[3 * from + 0];
+						const float y = geometry.positions[3 * to + 1] - geometry.positions[3 * from + 1];
+						const float z = geometry.positions[3 * to + 2] - geometry.positions[3 * from + 2];
+						return x * x + y * y + z * z;
+					};
+
+					if (squaredDistance(face[0].position, face[2].position) < squaredDistance(face[1].position, face[3].position))
+					{
+						for (int corner : { 0, 1, 2, 0, 2, 3 })
+						{
+							*output++ = face[corner];
+						}
+					}
+					else
+					{
+						for (int corner : { 0, 1, 3, 1, 2, 3 })
+						{
+							*output++ = face[corner];
+						}
+					}
+				}
+				face += faceSize;
+			}
+		});
+
+		return std::all_of(chunks.begin(), chunks.end(), [](const ObjChunk& chunk) { return chunk.isSupported; });
+	}
+
+	void ObjParser::ParseWithTinyObj(const std::string& filePath, Geometry& geometry)
+	{
+		tinyobj::attrib_t attrib;
+		std::vector<tinyobj::shape_t> shapes;
+		std::vector<tinyobj::material_t> materials;
+		std::string warning, err;
+
+		if(!tinyobj::LoadObj(&attrib, &shapes, &materials, &warning, &err, filePath.c_str()))
+		{
+			throw std::runtime_error(warning + err);
+		}
+
+		geometry.positions = std::move(attrib.vertices);
+		geometry.colors = std::move(attrib.colors);
+		geometry.normals = std::move(attrib.normals);
+		geometry.texcoords = std::move(attrib.texcoords);
+
+		geometry.corners.clear();
+		for(const auto& shape : shapes)
+		{
+			for(const auto& index : shape.mesh.indices)
+			{
+				geometry.corners.push_back({ index.vertex_index, index.texcoord_index, index.normal_index });
+			}
+		}
+	}
+
+	VertexWelder::Stats ObjParser::BuildMeshData(const Geometry& geometry, Mesh::Data& data, float weldEpsilon)
+	{
+		data.vertices.clear();
+		data.indices.clear();
+		data.indices.reserve(geometry.corners.size());
+
+		VertexWelder welder{ data.vertices, geometry.corners.size(), weldEpsilon };
+
+		for(const auto& corner : geometry.corners)
+		{
+			Mesh::Vertex vertex{};
+
+			if(corner.position >= 0)
+			{
+				vertex.position =
+				{
+					geometry.positions[3 * corner.position + 0],
+					geometry.positions[3 * corner.position + 1],
+					geometry.positions[3 * corner.position + 2]
+				};
+
+				vertex.color =
+				{
+					geometry.colors[3 * corner.position + 0],
+					geometry.colors[3 * corner.position + 1],
+					geometry.colors[3 * corner.position + 2]
+				};
+			}
+
+			if (corner.normal >= 0)
+			{
+				vertex.normal =
+				{
+					geometry.normals[3 * corner.normal + 0],
+					geometry.normals[3 * corner.normal + 1],
+					geometry.normals[3 * corner.normal + 2]
+				};
+			}
+
+			if (corner.texcoord >= 0)
+			{
+				vertex.uv =
+				{
+					geometry.texcoords[2 * corner.texcoord + 0],
+					geometry.texcoords[2 * corner.texcoord + 1],
+				};
+			}
+
+			data.indices.push_back(welder.Weld(vertex));
+		}
+
+		return welder.GetStats();
+	}
+}
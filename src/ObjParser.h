@@ -0,0 +1,48 @@
+#pragma once
+#include "Mesh.h"
+#include "ThreadPool.h"
+#include "VertexWelder.h"
+
+// std includes
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lve
+{
+	// Multithreaded Wavefront OBJ reader. The file is mapped, split into line aligned chunks,
+	// tokenized on the thread pool and merged back in file order, so the result never depends on the thread count.
+	// Files using anything besides v/vn/vt and triangle or quad faces are handed to TinyObjLoader instead.
+	class ObjParser final
+	{
+	public:
+		// zero based attribute indices, -1 when a corner has no such attribute
+		struct Corner
+		{
+			int32_t position;
+			int32_t texcoord;
+			int32_t normal;
+		};
+
+		struct Geometry
+		{
+			std::vector<float> positions{};
+			std::vector<float> colors{};
+			std::vector<float> normals{};
+			std::vector<float> texcoords{};
+			std::vector<Corner> corners{};
+		};
+
+		ObjParser() = delete;
+
+		// Parses with the native parser and falls back to tinyobj, then welds the corners into data.
+		// A weldEpsilon above zero also merges vertices that only differ by less than roughly that amount.
+		static void Load(const std::string& filePath, Mesh::Data& data, float weldEpsilon = 0.f);
+
+		// Returns false when the file uses a feature the native parser does not handle
+		static bool Parse(const std::string& filePath, Geometry& geometry, ThreadPool& threadPool);
+		static void ParseWithTinyObj(const std::string& filePath, Geometry& geometry);
+
+		static VertexWelder::Stats BuildMeshData(const Geometry& geometry, Mesh::Data& data, float weldEpsilon = 0.f);
+	};
+}
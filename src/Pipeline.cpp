@@ -90,6 +90,9 @@ namespace lve
 		configInfo.dynamicStateInfo.pDynamicStates = configInfo.dynamicStateEnables.data();
 		configInfo.dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
 		configInfo.dynamicStateInfo.flags = 0;
+
+		configInfo.bindingDescriptions = Mesh::Vertex::GetBindingDescriptions();
+		configInfo.attributeDescriptions = Mesh::Vertex::GetAttributeDescriptions();
 	}
 
 
@@ -144,8 +147,8 @@ namespace lve
 		shaderStages[1].pNext = nullptr;
 		shaderStages[1].pSpecializationInfo = nullptr;
 
-		auto bindingDescriptions = Mesh::Vertex::GetBindingDescriptions();
-		auto attributeDescriptions = Mesh::Vertex::GetAttributeDescriptions();
+		const auto& bindingDescriptions = configInfo.bindingDescriptions;
+		const auto& attributeDescriptions = configInfo.attributeDescriptions;
 		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
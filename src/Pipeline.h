@@ -15,6 +15,8 @@ namespace lve
 		PipelineConfigInfo& operator=(const PipelineConfigInfo&) = delete;
 		PipelineConfigInfo& operator=(PipelineConfigInfo&&) = delete;
 
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions{};
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
 		VkPipelineViewportStateCreateInfo viewportInfo{};
 		VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo{};
 		VkPipelineRasterizationStateCreateInfo rasterizationInfo{};
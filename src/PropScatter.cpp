@@ -0,0 +1,242 @@
+#include "PropScatter.h"
+#include "GameObject.h"
+#include "ThreadPool.h"
+#include "Utils.h"
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <random>
+
+//library
+#include <glm/gtc/constants.hpp>
+
+namespace lve
+{
+	PropScatter::PropScatter(const ScatterParams& params)
+		: m_Params{ params }
+	{
+	}
+
+	uint32_t PropScatter::Update(const TerrainQuery& query)
+	{
+		const glm::vec2 groundLow{ query.GetOrigin().x, query.GetOrigin().z };
+		const glm::vec2 groundHigh = groundLow + query.GetSize();
+		const glm::ivec2 firstTile{ glm::floor(groundLow / m_Params.tileSize) };
+		const glm::ivec2 tileCount = glm::max(glm::ivec2{ glm::ceil(groundHigh / m_Params.tileSize) } - firstTile, glm::ivec2{ 1 });
+
+		bool isLayoutChanged{ false };
+		if (firstTile != m_FirstTile || tileCount != m_TileCount)
+		{
+			m_FirstTile = firstTile;
+			m_TileCount = tileCount;
+			m_Tiles.clear();
+			m_Tiles.resize(static_cast<size_t>(tileCount.x) * tileCount.y);
+			isLayoutChanged = true;
+		}
+
+		std::atomic<uint32_t> rebuiltCount{};
+		ThreadPool::GetShared().ParallelFor(static_cast<uint32_t>(m_Tiles.size()), [&](uint32_t index)
+		{
+			const int tileX = static_cast<int>(index) % tileCount.x;
+			const int tileZ = static_cast<int>(index) / tileCount.x;
+			const glm::vec2 tileLow = glm::vec2{ firstTile + glm::ivec2{ tileX, tileZ } } * m_Params.tileSize;
+
+			Tile& tile = m_Tiles[index];
+			const uint64_t groundHash = query.GetRegionHash(tileLow, tileLow + m_Params.tileSize);
+			if (!isLayoutChanged && tile.groundHash == groundHash)
+			{
+				return;
+			}
+
+			tile.groundHash = groundHash;
+			ScatterTile(query, tileX, tileZ, tile);
+			++rebuiltCount;
+		});
+
+		if (!isLayoutChanged && rebuiltCount == 0)
+		{
+			return 0;
+		}
+
+		m_PendingInstances.clear();
+		m_PendingTileRanges.clear();
+		for (Tile& tile : m_Tiles)
+		{
+			if (tile.instances.empty())
+			{
+				continue;
+			}
+
+			tile.range.firstInstance = static_cast<uint32_t>(m_PendingInstances.size());
+			m_PendingInstances.insert(m_PendingInstances.end(), tile.instances.begin(), tile.instances.end());
+			m_PendingTileRanges.push_back(tile.range);
+		}
+		m_IsPending = true;
+
+		return rebuiltCount;
+	}
+
+	void PropScatter::Publish()
+	{
+		if (!m_IsPending)
+		{
+			return;
+		}
+
+		// the update keeps its vectors for the next one, so swapping keeps both allocations alive
+		m_Instances.swap(m_PendingInstances);
+		m_TileRanges.swap(m_PendingTileRanges);
+		m_IsPending = false;
+		++m_Version;
+	}
+
+	void PropScatter::ScatterTile(const TerrainQuery& query, int tileX, int tileZ, Tile& tile) const
+	{
+		tile.instances.clear();
+
+		const glm::ivec2 worldTile = m_FirstTile + glm::ivec2{ tileX, tileZ };
+		const glm::vec2 tileLow = glm::vec2{ worldTile } * m_Params.tileSize;
+		const glm::vec2 groundLow{ query.GetOrigin().x, query.GetOrigin().z };
+		const glm::vec2 groundHigh = groundLow + query.GetSize();
+
+		// half the distance on both sides of every tile edge keeps points of neighbouring tiles far enough apart
+		const float margin = m_Params.minDistance * 0.5f;
+		const glm::vec2 low = glm::max(tileLow + margin, groundLow);
+		const glm::vec2 high = glm::min(tileLow + m_Params.tileSize - margin, groundHigh);
+
+		const uint64_t tileKey = (static_cast<uint64_t>(static_cast<uint32_t>(worldTile.x)) << 32) | static_cast<uint32_t>(worldTile.y);
+		const uint64_t seed = MixBits(m_Params.seed ^ MixBits(tileKey));
+
+		std::vector<glm::vec2> points{};
+		SamplePoissonDisk(low, high, seed, points);
+		if (points.empty())
+		{
+			return;
+		}
+
+		std::vector<float> heights(points.size());
+		std::vector<glm::vec3> normals(points.size());
+		query.GetHeights(points, heights, normals);
+
+		// the placement draws come from their own generator, so changing the rules does not move the points
+		std::mt19937_64 random{ MixBits(seed + 1) };
+		std::uniform_real_distribution<float> randomYaw{ 0.f, glm::two_pi<float>() };
+		std::uniform_real_distribution<float> randomScale{ m_Params.minScale, m_Params.maxScale };
+		const float minUp = std::cos(m_Params.maxSlope);
+
+		glm::vec3 boundsLow{ std::numeric_limits<float>::max() };
+		glm::vec3 boundsHigh{ std::numeric_limits<float>::lowest() };
+		for (size_t index{}; index < points.size(); ++index)
+		{
+			const float yaw = randomYaw(random);
+			const float scale = randomScale(random);
+
+			// normals point towards -y, away from the ground
+			if (-normals[index].y < minUp || heights[index] < m_Params.minY || heights[index] > m_Params.maxY)
+			{
+				continue;
+			}
+
+			TransformComponent transform{};
+			transform.translation = { points[index].x, heights[index], points[index].y };
+			transform.rotation.y = yaw;
+			transform.scale = glm::vec3{ scale };
+			tile.instances.push_back({ transform.Mat4() });
+
+			boundsLow = glm::min(boundsLow, transform.translation);
+			boundsHigh = glm::max(boundsHigh, transform.translation);
+		}
+
+		tile.range.instanceCount = static_cast<uint32_t>(tile.instances.size());
+		tile.range.boundsCenter = (boundsLow + boundsHigh) * 0.5f;
+		tile.range.boundsRadius = glm::length(boundsHigh - boundsLow) * 0.5f;
+		tile.range.maxScale = m_Params.maxScale;
+	}
+
+	void PropScatter::SamplePoissonDisk(glm::vec2 low, glm::vec2 high, uint64_t seed, std::vector<glm::vec2>& points) const
+	{
+		if (high.x < low.x || high.y < low.y)
+		{
+			return;
+		}
+
+		// with cells of r / sqrt(2) every cell holds at most one point, so a candidate only checks the 5x5 cells around it
+		const float minDistance = m_Params.minDistance;
+		const float cellSize = minDistance / glm::root_two<float>();
+		const glm::ivec2 cellCount = glm::max(glm::ivec2{ glm::ceil((high - low) / cellSize) }, glm::ivec2{ 1 });
+		std::vector<int> cells(static_cast<size_t>(cellCount.x) * cellCount.y, -1);
+
+		auto getCell = [&](glm::vec2 point)
+		{
+			return glm::clamp(glm::ivec2{ (point - low) / cellSize }, glm::ivec2{ 0 }, cellCount - 1);
+		};
+
+		auto isFree = [&](glm::vec2 point, glm::ivec2 cell)
+		{
+			for (int z = std::max(cell.y - 2, 0); z <= std::min(cell.y + 2, cellCount.y - 1); ++z)
+			{
+				for (int x = std::max(cell.x - 2, 0); x <= std::min(cell.x + 2, cellCount.x - 1); ++x)
+				{
+					const int other = cells[static_cast<size_t>(z) * cellCount.x + x];
+					if (other >= 0)
+					{
+						const glm::vec2 offset = points[other] - point;
+						if (glm::dot(offset, offset) < minDistance * minDistance)
+						{
+							return false;
+						}
+					}
+				}
+			}
+			return true;
+		};
+
+		std::mt19937_64 random{ seed };
+		std::uniform_real_distribution<float> unit{ 0.f, 1.f };
+		std::vector<int> active{};
+
+		auto add = [&](glm::vec2 point)
+		{
+			const glm::ivec2 cell = getCell(point);
+			cells[static_cast<size_t>(cell.y) * cellCount.x + cell.x] = static_cast<int>(points.size());
+			active.push_back(static_cast<int>(points.size()));
+			points.push_back(point);
+		};
+
+		add(low + glm::vec2{ unit(random), unit(random) } * (high - low));
+
+		while (!active.empty())
+		{
+			const size_t activeIndex = static_cast<size_t>(random() % active.size());
+			const glm::vec2 center = points[active[activeIndex]];
+
+			bool isPlaced{ false };
+			for (int attempt{}; attempt < m_Params.attempts && !isPlaced; ++attempt)
+			{
+				// uniform over the ring between r and 2r
+				const float angle = unit(random) * glm::two_pi<float>();
+				const float distance = minDistance * std::sqrt(1.f + 3.f * unit(random));
+				const glm::vec2 candidate = center + glm::vec2{ std::cos(angle), std::sin(angle) } * distance;
+				if (candidate.x < low.x || candidate.y < low.y || candidate.x > high.x || candidate.y > high.y)
+				{
+					continue;
+				}
+
+				if (isFree(candidate, getCell(candidate)))
+				{
+					add(candidate);
+					isPlaced = true;
+				}
+			}
+
+			if (!isPlaced)
+			{
+				active[activeIndex] = active.back();
+				active.pop_back();
+			}
+		}
+	}
+}
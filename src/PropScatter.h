@@ -0,0 +1,101 @@
+#pragma once
+#include "TerrainQuery.h"
+
+//libs
+#include <glm/glm.hpp>
+
+// std includes
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace lve
+{
+	// Everything that decides where props stand, the same params on the same ground always give the same props
+	struct ScatterParams
+	{
+		uint64_t seed{ 1 };
+		// smallest distance between two props
+		float minDistance{ 0.1f };
+		// world size of the square tiles that are scattered and rebuilt on their own
+		float tileSize{ 1.f };
+		// steepest ground a prop still stands on, in radians from flat
+		float maxSlope{ 0.5f };
+		// world y range of the ground props stand on, +y points down so minY is the highest ground
+		float minY{ -1e30f };
+		float maxY{ 1e30f };
+		float minScale{ 0.3f };
+		float maxScale{ 0.6f };
+		// candidates tried around a point before it stops spawning new ones
+		int attempts{ 30 };
+	};
+
+	// Poisson disk scatter of one prop over a terrain. The terrain is cut into tiles that are sampled independently on the
+	// shared thread pool, points keep half the min distance from their tile edges so no tile ever needs its neighbours.
+	// Every tile seeds its own generator from its world position, so it only changes when the ground under it does.
+	class PropScatter final
+	{
+	public:
+		struct Instance
+		{
+			glm::mat4 transform;
+		};
+
+		// the instances of a tile are contiguous, so a tile is drawn or skipped as a whole
+		struct TileRange
+		{
+			uint32_t firstInstance;
+			uint32_t instanceCount;
+			// sphere around the ground points of the instances
+			glm::vec3 boundsCenter;
+			float boundsRadius;
+			float maxScale;
+		};
+
+		explicit PropScatter(const ScatterParams& params);
+		~PropScatter() = default;
+
+		PropScatter(const PropScatter&) = delete;
+		PropScatter(PropScatter&&) = delete;
+		PropScatter& operator=(const PropScatter&) = delete;
+		PropScatter& operator=(PropScatter&&) = delete;
+
+		// Rescatters the tiles whose ground changed since the last update and returns how many that were. Safe on a worker
+		// thread while no other update runs, what the renderer reads stays the same until Publish.
+		uint32_t Update(const TerrainQuery& query);
+		// Makes the result of the last update visible, main thread only
+		void Publish();
+
+		std::span<const Instance> GetInstances() const { return m_Instances; }
+		std::span<const TileRange> GetTileRanges() const { return m_TileRanges; }
+		uint32_t GetTileCount() const { return static_cast<uint32_t>(m_Tiles.size()); }
+		// changes every time Publish changes the instances
+		uint64_t GetVersion() const { return m_Version; }
+
+	private:
+		struct Tile
+		{
+			uint64_t groundHash;
+			std::vector<Instance> instances;
+			TileRange range;
+		};
+
+		void ScatterTile(const TerrainQuery& query, int tileX, int tileZ, Tile& tile) const;
+		// bridson's algorithm inside the rectangle
+		void SamplePoissonDisk(glm::vec2 low, glm::vec2 high, uint64_t seed, std::vector<glm::vec2>& points) const;
+
+		const ScatterParams m_Params;
+
+		// tile coordinates are world position / tile size, so tiles stay put when the terrain grows
+		glm::ivec2 m_FirstTile{};
+		glm::ivec2 m_TileCount{};
+		std::vector<Tile> m_Tiles;
+		bool m_IsPending{ false };
+		std::vector<Instance> m_PendingInstances;
+		std::vector<TileRange> m_PendingTileRanges;
+
+		std::vector<Instance> m_Instances;
+		std::vector<TileRange> m_TileRanges;
+		uint64_t m_Version{};
+	};
+}
@@ -60,16 +60,47 @@ namespace lve
 		pipelineConfig.renderPass = renderPass;
 		pipelineConfig.pipelineLayout = m_PipelineLayout;
 		m_Pipeline = std::make_unique<Pipeline>(m_Device, "Shaders/SimpleShader.vert.spv", "Shaders/SimpleShader.frag.spv", pipelineConfig);
+
+		pipelineConfig.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+		pipelineConfig.inputAssemblyInfo.primitiveRestartEnable = VK_TRUE;
+		m_StripPipeline = std::make_unique<Pipeline>(m_Device, "Shaders/SimpleShader.vert.spv", "Shaders/SimpleShader.frag.spv", pipelineConfig);
+
+		pipelineConfig.bindingDescriptions = Mesh::PackedVertex::GetBindingDescriptions();
+		pipelineConfig.attributeDescriptions = Mesh::PackedVertex::GetAttributeDescriptions();
+		m_PackedStripPipeline = std::make_unique<Pipeline>(m_Device, "Shaders/PackedShader.vert.spv", "Shaders/SimpleShader.frag.spv", pipelineConfig);
+
+		pipelineConfig.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		pipelineConfig.inputAssemblyInfo.primitiveRestartEnable = VK_FALSE;
+		m_PackedPipeline = std::make_unique<Pipeline>(m_Device, "Shaders/PackedShader.vert.spv", "Shaders/SimpleShader.frag.spv", pipelineConfig);
 	}
 
-	void RenderSystem2D::RenderGameObjects(FrameInfo& frameInfo, std::vector<GameObject>& gameObjects)
+	Pipeline* RenderSystem2D::SelectPipeline(const Mesh& mesh) const
 	{
-		m_Pipeline->Bind(frameInfo.commandBuffer);
+		if (mesh.GetVertexFormat() == VertexFormat::Packed)
+		{
+			return mesh.IsStrip() ? m_PackedStripPipeline.get() : m_PackedPipeline.get();
+		}
 
+		return mesh.IsStrip() ? m_StripPipeline.get() : m_Pipeline.get();
+	}
+
+	void RenderSystem2D::RenderGameObjects(FrameInfo& frameInfo, std::vector<GameObject>& gameObjects)
+	{
+		Pipeline* pBoundPipeline{ nullptr };
+		// meshes share the geometry pool buffers, so most objects keep the previous binding
+		VkBuffer boundVertexBuffer{ VK_NULL_HANDLE };
+		VkBuffer boundIndexBuffer{ VK_NULL_HANDLE };
 		for (auto& object : gameObjects)
 		{
+			Pipeline* pPipeline = SelectPipeline(*object.mesh);
+			if (pPipeline != pBoundPipeline)
+			{
+				pPipeline->Bind(frameInfo.commandBuffer);
+				pBoundPipeline = pPipeline;
+			}
+
 			SimplePushConstantData push{};
-			push.transform = object.transform.Mat4();
+			push.transform = object.transform.Mat4() * object.mesh->GetDequantizeTransform();
 
 			vkCmdPushConstants
 			(
@@ -80,7 +111,12 @@ namespace lve
 				sizeof(SimplePushConstantData),
 				&push
 			);
-			object.mesh->Bind(frameInfo.commandBuffer);
+			if (object.mesh->GetVertexBuffer() != boundVertexBuffer || object.mesh->GetIndexBuffer() != boundIndexBuffer)
+			{
+				object.mesh->Bind(frameInfo.commandBuffer);
+				boundVertexBuffer = object.mesh->GetVertexBuffer();
+				boundIndexBuffer = object.mesh->GetIndexBuffer();
+			}
 			object.mesh->Draw(frameInfo.commandBuffer);
 		}
 	}
@@ -25,9 +25,13 @@ namespace lve
     private:
         void CreatePipelineLayout();
         void CreatePipeline(VkRenderPass renderPass);
+        Pipeline* SelectPipeline(const Mesh& mesh) const;
 
 		Device& m_Device;
 		std::unique_ptr<Pipeline> m_Pipeline;
+		std::unique_ptr<Pipeline> m_PackedPipeline;
+		std::unique_ptr<Pipeline> m_StripPipeline;
+		std::unique_ptr<Pipeline> m_PackedStripPipeline;
 		VkPipelineLayout m_PipelineLayout;
 	};
 }
@@ -1,6 +1,7 @@
 #include "Renderer.h"
 
 // std
+#include <algorithm>
 #include <stdexcept>
 #include <array>
 #include <cassert>
@@ -38,6 +39,12 @@ namespace lve
 			throw std::runtime_error("failed to acquire next image!");
 		}
 
+		// acquiring waited for the fence of the frame that last used this slot, MAX_FRAMES_IN_FLIGHT frames ago
+		if (m_SubmittedFrameCount >= SwapChain::MAX_FRAMES_IN_FLIGHT)
+		{
+			m_CompletedFrameCount = std::max(m_CompletedFrameCount, m_SubmittedFrameCount + 1 - SwapChain::MAX_FRAMES_IN_FLIGHT);
+		}
+
 		m_IsFrameStarted = true;
 
 		auto commandBuffer = GetCurrentCommandBuffer();
@@ -64,6 +71,7 @@ namespace lve
 		}
 
 		auto result = m_SwapChain->SubmitCommandBuffers(&commandBuffer, &m_CurrentImageIndex);
+		++m_SubmittedFrameCount;
 
 		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_Window.WasWindowResized())
 		{
@@ -79,6 +87,12 @@ namespace lve
 		m_CurrentFrameIndex = (m_CurrentFrameIndex + 1) % SwapChain::MAX_FRAMES_IN_FLIGHT;
 	}
 
+	void Renderer::WaitIdle()
+	{
+		vkDeviceWaitIdle(m_Device.GetDevice());
+		m_CompletedFrameCount = m_SubmittedFrameCount;
+	}
+
 	void Renderer::BeginSwapChainRenderPass(VkCommandBuffer commandBuffer)
 	{
 		assert(m_IsFrameStarted && "Can't call BeginSwapChainRenderPass if frame is not in progress");
@@ -153,7 +167,7 @@ namespace lve
 			glfwWaitEvents();
 		}
 
-		vkDeviceWaitIdle(m_Device.GetDevice());
+		WaitIdle();
 
 		if (m_SwapChain == nullptr)
 		{
@@ -37,6 +37,13 @@ namespace lve
 			return m_CurrentFrameIndex;
 		}
 
+		// Frames handed to the GPU so far, and how many of those are known to have finished going by the in flight
+		// fences. Everything recorded before the submitted count was read is done once the completed count reaches it.
+		uint64_t GetSubmittedFrameCount() const { return m_SubmittedFrameCount; }
+		uint64_t GetCompletedFrameCount() const { return m_CompletedFrameCount; }
+		// Waits for the device, every submitted frame counts as completed afterwards
+		void WaitIdle();
+
 		Renderer(const Renderer&) = delete;
 		Renderer(Renderer&&) = delete;
 		Renderer& operator=(const Renderer&) = delete;
@@ -55,5 +62,7 @@ namespace lve
 		uint32_t m_CurrentImageIndex;
 		int m_CurrentFrameIndex{ 0 };
 		bool m_IsFrameStarted{false};
+		uint64_t m_SubmittedFrameCount{};
+		uint64_t m_CompletedFrameCount{};
 	};
 }
@@ -0,0 +1,46 @@
+#version 450
+
+// Heightfield grid without a vertex buffer, the vertex index picks the sample and the texture holds its height
+layout(set = 0, binding = 0) uniform sampler2D heights;
+
+layout(location = 0) out vec3 fragColor;
+
+layout(push_constant) uniform Push
+{
+	mat4 transform;
+	// the last column holds the grid columns and 1 for the flat preview
+	mat4 normalMatrix;
+} push;
+
+const vec3 DIRECTION_TO_LIGHT = normalize(vec3(1.0, -3.0, -1.0));
+
+const float AMBIENT = 0.02;
+
+const vec3 TERRAIN_COLOR = vec3(0.4, 0.3, 0.2);
+
+float FetchHeight(ivec2 sampleCoordinate)
+{
+	return texelFetch(heights, clamp(sampleCoordinate, ivec2(0), textureSize(heights, 0) - 1), 0).r;
+}
+
+void main()
+{
+	int columns = int(push.normalMatrix[3].x);
+	bool isPreview = push.normalMatrix[3].y > 0.5;
+
+	ivec2 sampleCoordinate = ivec2(gl_VertexIndex % columns, gl_VertexIndex / columns);
+	float height = FetchHeight(sampleCoordinate);
+
+	// central differences, the normal points at -y like the mesh terrain
+	float slopeX = FetchHeight(sampleCoordinate + ivec2(1, 0)) - FetchHeight(sampleCoordinate - ivec2(1, 0));
+	float slopeZ = FetchHeight(sampleCoordinate + ivec2(0, 1)) - FetchHeight(sampleCoordinate - ivec2(0, 1));
+	vec3 normal = isPreview ? vec3(0.0, -1.0, 0.0) : vec3(slopeX, -2.0, slopeZ);
+
+	gl_Position = push.transform * vec4(float(sampleCoordinate.x), isPreview ? 0.0 : height, float(sampleCoordinate.y), 1.0);
+
+	vec3 normalWorldSpace = normalize(mat3(push.normalMatrix) * normal);
+
+	float lightIntensity = AMBIENT + max(dot(normalWorldSpace, DIRECTION_TO_LIGHT), 0);
+
+	fragColor = lightIntensity * (isPreview ? vec3(height) : TERRAIN_COLOR);
+}
@@ -0,0 +1,42 @@
+#version 450
+
+// Mesh::PackedVertex, the transform already contains the dequantization into the mesh bounds
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec4 color;
+layout(location = 3) in vec2 uv;
+
+layout(location = 0) out vec3 fragColor;
+
+layout(push_constant) uniform Push
+{
+	mat4 transform;
+	mat4 normalMatrix;
+} push;
+
+const vec3 DIRECTION_TO_LIGHT = normalize(vec3(1.0, -3.0, -1.0));
+
+const float AMBIENT = 0.02;
+
+vec3 DecodeOctahedral(float packedNormal)
+{
+	uint bits = uint(round(packedNormal * 65535.0));
+	vec2 octahedral = vec2(bits & 0xFFu, bits >> 8) / 255.0 * 2.0 - 1.0;
+
+	vec3 normal = vec3(octahedral, 1.0 - abs(octahedral.x) - abs(octahedral.y));
+	if (normal.z < 0.0)
+	{
+		normal.xy = (1.0 - abs(normal.yx)) * vec2(normal.x >= 0.0 ? 1.0 : -1.0, normal.y >= 0.0 ? 1.0 : -1.0);
+	}
+	return normalize(normal);
+}
+
+void main()
+{
+	gl_Position = push.transform * vec4(position.xyz, 1.0);
+
+	vec3 normalWorldSpace = normalize(mat3(push.normalMatrix) * DecodeOctahedral(position.w));
+
+	float lightIntensity = AMBIENT + max(dot(normalWorldSpace, DIRECTION_TO_LIGHT), 0);
+
+	fragColor = lightIntensity * color.rgb;
+}
@@ -1,9 +1,11 @@
 #include "SimpleRenderSystem.h"
+#include "SwapChain.h"
 
 // std
 #include <stdexcept>
 #include <array>
 #include <cassert>
+#include <cstring>
 
 //library
 #define GLM_FORCE_RADIANS
@@ -19,8 +21,33 @@ namespace lve
 		glm::mat4 normalMatrix{ 1.f };
 	};
 
+	// planes of the view space frustum for Vulkan clip space, pointing inwards and normalized
+	static void ExtractFrustumPlanes(const glm::mat4& projection, glm::vec4 planes[6])
+	{
+		const glm::vec4 row0{ projection[0][0], projection[1][0], projection[2][0], projection[3][0] };
+		const glm::vec4 row1{ projection[0][1], projection[1][1], projection[2][1], projection[3][1] };
+		const glm::vec4 row2{ projection[0][2], projection[1][2], projection[2][2], projection[3][2] };
+		const glm::vec4 row3{ projection[0][3], projection[1][3], projection[2][3], projection[3][3] };
+
+		planes[0] = row3 + row0;
+		planes[1] = row3 - row0;
+		planes[2] = row3 + row1;
+		planes[3] = row3 - row1;
+		planes[4] = row2;
+		planes[5] = row3 - row2;
+
+		for (int plane{}; plane < 6; ++plane)
+		{
+			planes[plane] /= glm::length(glm::vec3{ planes[plane] });
+		}
+	}
+
 	SimpleRenderSystem::SimpleRenderSystem(Device& device, VkRenderPass renderPass)
 		: m_Device(device)
+		, m_IndirectBuffers(SwapChain::MAX_FRAMES_IN_FLIGHT)
+		, m_RetiredIndirectBuffers(SwapChain::MAX_FRAMES_IN_FLIGHT)
+		, m_InstanceBuffers(SwapChain::MAX_FRAMES_IN_FLIGHT)
+		, m_InstanceVersions(SwapChain::MAX_FRAMES_IN_FLIGHT)
 	{
 		CreatePipelineLayout();
 		CreatePipeline(renderPass);
@@ -60,19 +87,83 @@ namespace lve
 		pipelineConfig.renderPass = renderPass;
 		pipelineConfig.pipelineLayout = m_PipelineLayout;
 		m_Pipeline = std::make_unique<Pipeline>(m_Device, "Shaders/SimpleShader.vert.spv", "Shaders/SimpleShader.frag.spv", pipelineConfig);
+
+		pipelineConfig.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+		pipelineConfig.inputAssemblyInfo.primitiveRestartEnable = VK_TRUE;
+		m_StripPipeline = std::make_unique<Pipeline>(m_Device, "Shaders/SimpleShader.vert.spv", "Shaders/SimpleShader.frag.spv", pipelineConfig);
+
+		pipelineConfig.bindingDescriptions = Mesh::PackedVertex::GetBindingDescriptions();
+		pipelineConfig.attributeDescriptions = Mesh::PackedVertex::GetAttributeDescriptions();
+		m_PackedStripPipeline = std::make_unique<Pipeline>(m_Device, "Shaders/PackedShader.vert.spv", "Shaders/SimpleShader.frag.spv", pipelineConfig);
+
+		pipelineConfig.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		pipelineConfig.inputAssemblyInfo.primitiveRestartEnable = VK_FALSE;
+		m_PackedPipeline = std::make_unique<Pipeline>(m_Device, "Shaders/PackedShader.vert.spv", "Shaders/SimpleShader.frag.spv", pipelineConfig);
+
+		// the instance model matrix is a second vertex stream, one column per location
+		pipelineConfig.bindingDescriptions = Mesh::Vertex::GetBindingDescriptions();
+		pipelineConfig.bindingDescriptions.push_back({ 1, sizeof(PropScatter::Instance), VK_VERTEX_INPUT_RATE_INSTANCE });
+		pipelineConfig.attributeDescriptions = Mesh::Vertex::GetAttributeDescriptions();
+		for (uint32_t column{}; column < 4; ++column)
+		{
+			pipelineConfig.attributeDescriptions.push_back({ 4 + column, 1, VK_FORMAT_R32G32B32A32_SFLOAT, static_cast<uint32_t>(column * sizeof(glm::vec4)) });
+		}
+		m_InstancedPipeline = std::make_unique<Pipeline>(m_Device, "Shaders/InstancedShader.vert.spv", "Shaders/SimpleShader.frag.spv", pipelineConfig);
+
+		pipelineConfig.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+		pipelineConfig.inputAssemblyInfo.primitiveRestartEnable = VK_TRUE;
+		m_InstancedStripPipeline = std::make_unique<Pipeline>(m_Device, "Shaders/InstancedShader.vert.spv", "Shaders/SimpleShader.frag.spv", pipelineConfig);
 	}
 
-	void SimpleRenderSystem::RenderGameObjects(FrameInfo& frameInfo, std::vector<GameObject>& gameObjects)
+	Pipeline* SimpleRenderSystem::SelectPipeline(const Mesh& mesh) const
 	{
-		m_Pipeline->Bind(frameInfo.commandBuffer);
+		if (mesh.GetVertexFormat() == VertexFormat::Packed)
+		{
+			return mesh.IsStrip() ? m_PackedStripPipeline.get() : m_PackedPipeline.get();
+		}
 
-		auto projectionView = frameInfo.camera.GetProjectionMatrix() * frameInfo.camera.GetViewMatrix();
+		return mesh.IsStrip() ? m_StripPipeline.get() : m_Pipeline.get();
+	}
+
+	void SimpleRenderSystem::BeginFrame(int frameIndex)
+	{
+		// the fence of this frame already signaled
+		m_RetiredIndirectBuffers[frameIndex].clear();
+		m_IndirectCommandCount = 0;
+		m_DrawnMeshletCount = 0;
+		m_CulledMeshletCount = 0;
+		m_DrawnInstanceCount = 0;
+	}
 
+	void SimpleRenderSystem::RenderGameObjects(FrameInfo& frameInfo, std::span<GameObject> gameObjects)
+	{
+		const auto& projection = frameInfo.camera.GetProjectionMatrix();
+		const auto& view = frameInfo.camera.GetViewMatrix();
+
+		glm::vec4 frustumPlanes[6];
+		ExtractFrustumPlanes(projection, frustumPlanes);
+
+		ReserveIndirectCommands(frameInfo.frameIndex, gameObjects);
+		Buffer* pIndirectBuffer = m_IndirectBuffers[frameInfo.frameIndex].get();
+		uint32_t commandCount = m_IndirectCommandCount;
+
+		Pipeline* pBoundPipeline{ nullptr };
+		// meshes share the geometry pool buffers, so most objects keep the previous binding
+		VkBuffer boundVertexBuffer{ VK_NULL_HANDLE };
+		VkBuffer boundIndexBuffer{ VK_NULL_HANDLE };
 		for (auto& object : gameObjects)
 		{
+			Pipeline* pPipeline = SelectPipeline(*object.mesh);
+			if (pPipeline != pBoundPipeline)
+			{
+				pPipeline->Bind(frameInfo.commandBuffer);
+				pBoundPipeline = pPipeline;
+			}
+
 			SimplePushConstantData push{};
 			auto modelMatrix = object.transform.Mat4();
-			push.transform = projectionView * modelMatrix;
+			auto modelView = view * modelMatrix;
+			push.transform = projection * modelView * object.mesh->GetDequantizeTransform();
 			push.normalMatrix = object.transform.NormalMatrix();
 
 			vkCmdPushConstants
@@ -84,8 +175,242 @@ namespace lve
 				sizeof(SimplePushConstantData),
 				&push
 			);
-			object.mesh->Bind(frameInfo.commandBuffer);
-			object.mesh->Draw(frameInfo.commandBuffer);
+			if (object.mesh->GetVertexBuffer() != boundVertexBuffer || object.mesh->GetIndexBuffer() != boundIndexBuffer)
+			{
+				object.mesh->Bind(frameInfo.commandBuffer);
+				boundVertexBuffer = object.mesh->GetVertexBuffer();
+				boundIndexBuffer = object.mesh->GetIndexBuffer();
+			}
+
+			const uint32_t lod = SelectLod(*object.mesh, object.transform, modelView, projection);
+			if (lod != 0 || !pIndirectBuffer || object.mesh->GetMeshlets().empty())
+			{
+				object.mesh->Draw(frameInfo.commandBuffer, lod);
+				continue;
+			}
+
+			auto* pCommands = static_cast<VkDrawIndexedIndirectCommand*>(pIndirectBuffer->GetMappedMemory()) + commandCount;
+			const uint32_t drawCount = CullMeshlets(*object.mesh, object.transform, modelView, frustumPlanes, pCommands);
+			if (drawCount > 0)
+			{
+				object.mesh->DrawIndirect(frameInfo.commandBuffer, pIndirectBuffer->GetBuffer(), commandCount * sizeof(VkDrawIndexedIndirectCommand), drawCount);
+				commandCount += drawCount;
+			}
+		}
+		m_IndirectCommandCount = commandCount;
+	}
+
+	void SimpleRenderSystem::RenderInstances(FrameInfo& frameInfo, Mesh& mesh, const PropScatter& scatter)
+	{
+		assert(mesh.GetVertexFormat() == VertexFormat::Full && "Instanced meshes use the full vertex format");
+
+		if (scatter.GetInstances().empty())
+		{
+			return;
+		}
+
+		UpdateInstanceBuffer(frameInfo.frameIndex, scatter);
+
+		const auto& projection = frameInfo.camera.GetProjectionMatrix();
+		const auto& view = frameInfo.camera.GetViewMatrix();
+
+		glm::vec4 frustumPlanes[6];
+		ExtractFrustumPlanes(projection, frustumPlanes);
+
+		Pipeline* pPipeline = mesh.IsStrip() ? m_InstancedStripPipeline.get() : m_InstancedPipeline.get();
+		pPipeline->Bind(frameInfo.commandBuffer);
+
+		SimplePushConstantData push{};
+		push.transform = projection * view;
+		vkCmdPushConstants
+		(
+			frameInfo.commandBuffer,
+			m_PipelineLayout,
+			VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+			0,
+			sizeof(SimplePushConstantData),
+			&push
+		);
+
+		mesh.Bind(frameInfo.commandBuffer);
+		VkBuffer instanceBuffers[] = { m_InstanceBuffers[frameInfo.frameIndex]->GetBuffer() };
+		VkDeviceSize offsets[] = { 0 };
+		vkCmdBindVertexBuffers(frameInfo.commandBuffer, 1, 1, instanceBuffers, offsets);
+
+		// tile bounds only hold the ground points, grow them by the largest instance around its origin
+		const float meshRadius = glm::length(mesh.GetBoundsCenter()) + mesh.GetBoundsRadius();
+		for (const auto& tile : scatter.GetTileRanges())
+		{
+			const glm::vec3 center{ view * glm::vec4{ tile.boundsCenter, 1.f } };
+			const float radius = tile.boundsRadius + meshRadius * tile.maxScale;
+
+			bool isVisible{ true };
+			for (int plane{}; plane < 6 && isVisible; ++plane)
+			{
+				isVisible = glm::dot(glm::vec3{ frustumPlanes[plane] }, center) + frustumPlanes[plane].w >= -radius;
+			}
+
+			if (isVisible)
+			{
+				mesh.Draw(frameInfo.commandBuffer, SelectLod(mesh, tile.maxScale, center.z, radius, projection), tile.instanceCount, tile.firstInstance);
+				m_DrawnInstanceCount += tile.instanceCount;
+			}
+		}
+	}
+
+	void SimpleRenderSystem::UpdateInstanceBuffer(int frameIndex, const PropScatter& scatter)
+	{
+		auto& pInstanceBuffer = m_InstanceBuffers[frameIndex];
+		if (pInstanceBuffer && m_InstanceVersions[frameIndex] == scatter.GetVersion())
+		{
+			return;
+		}
+
+		// the fence of this frame already signaled, so its copy is free to rewrite or replace
+		const auto instances = scatter.GetInstances();
+		if (!pInstanceBuffer || pInstanceBuffer->GetInstanceCount() < instances.size())
+		{
+			pInstanceBuffer = std::make_unique<Buffer>
+			(
+				m_Device,
+				sizeof(PropScatter::Instance),
+				static_cast<uint32_t>(instances.size() * 3 / 2),
+				VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+			);
+			pInstanceBuffer->Map();
+		}
+
+		std::memcpy(pInstanceBuffer->GetMappedMemory(), instances.data(), instances.size_bytes());
+		m_InstanceVersions[frameIndex] = scatter.GetVersion();
+	}
+
+	void SimpleRenderSystem::ReserveIndirectCommands(int frameIndex, std::span<const GameObject> gameObjects)
+	{
+		if (!m_IsMeshletCullingEnabled)
+		{
+			m_IndirectBuffers[frameIndex].reset();
+			return;
+		}
+
+		size_t meshletCount{};
+		for (const auto& object : gameObjects)
+		{
+			meshletCount += object.mesh->GetMeshlets().size();
+		}
+
+		if (meshletCount == 0)
+		{
+			return;
+		}
+
+		// draws recorded earlier this frame keep their commands at the front
+		meshletCount += m_IndirectCommandCount;
+		auto& pIndirectBuffer = m_IndirectBuffers[frameIndex];
+		if (!pIndirectBuffer || pIndirectBuffer->GetInstanceCount() < meshletCount)
+		{
+			if (pIndirectBuffer && m_IndirectCommandCount > 0)
+			{
+				m_RetiredIndirectBuffers[frameIndex].push_back(std::move(pIndirectBuffer));
+			}
+			pIndirectBuffer = std::make_unique<Buffer>
+			(
+				m_Device,
+				sizeof(VkDrawIndexedIndirectCommand),
+				static_cast<uint32_t>(meshletCount * 3 / 2),
+				VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+			);
+			pIndirectBuffer->Map();
+		}
+	}
+
+	uint32_t SimpleRenderSystem::CullMeshlets(const Mesh& mesh, const TransformComponent& transform, const glm::mat4& modelView,
+		const glm::vec4 frustumPlanes[6], VkDrawIndexedIndirectCommand* pCommands)
+	{
+		const float scale = glm::max(glm::abs(transform.scale.x), glm::max(glm::abs(transform.scale.y), glm::abs(transform.scale.z)));
+		const glm::vec3 viewerPosition{ glm::inverse(modelView) * glm::vec4{ 0.f, 0.f, 0.f, 1.f } };
+
+		const uint32_t meshFirstIndex = mesh.GetFirstIndex();
+		const int32_t vertexOffset = static_cast<int32_t>(mesh.GetVertexOffset());
+
+		uint32_t drawCount{};
+		for (const auto& meshlet : mesh.GetMeshlets())
+		{
+			const glm::vec3 center{ modelView * glm::vec4{ meshlet.center, 1.f } };
+			const float radius = meshlet.radius * scale;
+
+			bool isVisible{ true };
+			for (int plane{}; plane < 6 && isVisible; ++plane)
+			{
+				isVisible = glm::dot(glm::vec3{ frustumPlanes[plane] }, center) + frustumPlanes[plane].w >= -radius;
+			}
+
+			if (isVisible && m_IsConeCullingEnabled)
+			{
+				isVisible = glm::dot(glm::normalize(meshlet.coneApex - viewerPosition), meshlet.coneAxis) < meshlet.coneCutoff;
+			}
+
+			if (!isVisible)
+			{
+				++m_CulledMeshletCount;
+				continue;
+			}
+
+			// neighbouring meshlets are contiguous in the index buffer, so they merge into one draw
+			const uint32_t firstIndex = meshFirstIndex + meshlet.firstIndex;
+			if (drawCount > 0 && pCommands[drawCount - 1].firstIndex + pCommands[drawCount - 1].indexCount == firstIndex)
+			{
+				pCommands[drawCount - 1].indexCount += meshlet.indexCount;
+			}
+			else
+			{
+				pCommands[drawCount++] = { meshlet.indexCount, 1, firstIndex, vertexOffset, 0 };
+			}
+			++m_DrawnMeshletCount;
+		}
+
+		return drawCount;
+	}
+
+	uint32_t SimpleRenderSystem::SelectLod(const Mesh& mesh, const TransformComponent& transform, const glm::mat4& modelView, const glm::mat4& projection) const
+	{
+		if (mesh.GetLodCount() <= 1)
+		{
+			return 0;
+		}
+
+		const float scale = glm::max(glm::abs(transform.scale.x), glm::max(glm::abs(transform.scale.y), glm::abs(transform.scale.z)));
+		const float depth = (modelView * glm::vec4{ mesh.GetBoundsCenter(), 1.f }).z;
+		return SelectLod(mesh, scale, depth, mesh.GetBoundsRadius() * scale, projection);
+	}
+
+	uint32_t SimpleRenderSystem::SelectLod(const Mesh& mesh, float scale, float depth, float radius, const glm::mat4& projection) const
+	{
+		if (mesh.GetLodCount() <= 1)
+		{
+			return 0;
+		}
+
+		// perspective divides by the distance to the nearest point of the bounds, orthographic does not divide at all
+		float distance{ 1.f };
+		if (projection[2][3] != 0.f)
+		{
+			distance = depth - radius;
+			if (distance <= 0.f)
+			{
+				return 0;
+			}
+		}
+
+		// model space error to a fraction of the viewport height, clip space spans two units
+		const float errorToScreen = scale * glm::abs(projection[1][1]) * 0.5f / distance;
+
+		uint32_t lod{};
+		while (lod + 1 < mesh.GetLodCount() && mesh.GetLod(lod + 1).error * errorToScreen <= m_LodErrorThreshold)
+		{
+			++lod;
 		}
+		return lod;
 	}
 }
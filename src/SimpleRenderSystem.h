@@ -4,9 +4,12 @@
 #include "GameObject.h"
 #include "Camera.h"
 #include "FrameInfo.h"
+#include "Buffer.h"
+#include "PropScatter.h"
 
 // std includes
 #include <memory>
+#include <span>
 #include <vector>
 
 namespace lve
@@ -18,7 +21,23 @@ namespace lve
 		SimpleRenderSystem(Device& device, VkRenderPass renderPass);
 		~SimpleRenderSystem();
 
-		void RenderGameObjects(FrameInfo& frameInfo, std::vector<GameObject>& gameObjects);
+		// Once per frame before the first draw, the stats below then add up every call of the frame
+		void BeginFrame(int frameIndex);
+		void RenderGameObjects(FrameInfo& frameInfo, std::span<GameObject> gameObjects);
+		// One instanced draw of mesh per visible scatter tile, mesh has to use the full vertex format
+		void RenderInstances(FrameInfo& frameInfo, Mesh& mesh, const PropScatter& scatter);
+
+		// Largest projected LOD error that is still acceptable, as a fraction of the viewport height
+		void SetLodErrorThreshold(float threshold) { m_LodErrorThreshold = threshold; }
+		float GetLodErrorThreshold() const { return m_LodErrorThreshold; }
+
+		// Meshes with meshlets draw their full detail LOD through indirect draws of the meshlets that pass culling
+		void SetMeshletCulling(bool isEnabled) { m_IsMeshletCullingEnabled = isEnabled; }
+		// The pipeline draws both faces, so only enable backface cone culling when every culled mesh is closed
+		void SetMeshletConeCulling(bool isEnabled) { m_IsConeCullingEnabled = isEnabled; }
+		uint32_t GetDrawnMeshletCount() const { return m_DrawnMeshletCount; }
+		uint32_t GetCulledMeshletCount() const { return m_CulledMeshletCount; }
+		uint32_t GetDrawnInstanceCount() const { return m_DrawnInstanceCount; }
 
 		SimpleRenderSystem(const SimpleRenderSystem&) = delete;
 		SimpleRenderSystem(SimpleRenderSystem&&) = delete;
@@ -28,9 +47,39 @@ namespace lve
 	private:
 		void CreatePipelineLayout();
 		void CreatePipeline(VkRenderPass renderPass);
+		Pipeline* SelectPipeline(const Mesh& mesh) const;
+		uint32_t SelectLod(const Mesh& mesh, const TransformComponent& transform, const glm::mat4& modelView, const glm::mat4& projection) const;
+		// depth is the view space depth of the bounds center, radius the view space radius of the bounds
+		uint32_t SelectLod(const Mesh& mesh, float scale, float depth, float radius, const glm::mat4& projection) const;
+		void UpdateInstanceBuffer(int frameIndex, const PropScatter& scatter);
+		void ReserveIndirectCommands(int frameIndex, std::span<const GameObject> gameObjects);
+		// Writes the draws of the visible meshlets at the command offset and returns how many there are
+		uint32_t CullMeshlets(const Mesh& mesh, const TransformComponent& transform, const glm::mat4& modelView,
+			const glm::vec4 frustumPlanes[6], VkDrawIndexedIndirectCommand* pCommands);
 
 		Device& m_Device;
 		std::unique_ptr<Pipeline> m_Pipeline;
+		std::unique_ptr<Pipeline> m_PackedPipeline;
+		std::unique_ptr<Pipeline> m_StripPipeline;
+		std::unique_ptr<Pipeline> m_PackedStripPipeline;
+		std::unique_ptr<Pipeline> m_InstancedPipeline;
+		std::unique_ptr<Pipeline> m_InstancedStripPipeline;
 		VkPipelineLayout m_PipelineLayout;
+		// roughly a pixel at 1080p
+		float m_LodErrorThreshold{ 0.001f };
+
+		bool m_IsMeshletCullingEnabled{ true };
+		bool m_IsConeCullingEnabled{ false };
+		// host visible VkDrawIndexedIndirectCommand buffer per frame in flight, every call of a frame appends to it
+		std::vector<std::unique_ptr<Buffer>> m_IndirectBuffers;
+		// buffers outgrown during a frame, earlier draws of the frame still read them until its fence signals
+		std::vector<std::vector<std::unique_ptr<Buffer>>> m_RetiredIndirectBuffers;
+		uint32_t m_IndirectCommandCount{};
+		uint32_t m_DrawnMeshletCount{};
+		uint32_t m_CulledMeshletCount{};
+		// host visible copy of the scatter instances per frame in flight, rewritten when the scatter version moves on
+		std::vector<std::unique_ptr<Buffer>> m_InstanceBuffers;
+		std::vector<uint64_t> m_InstanceVersions;
+		uint32_t m_DrawnInstanceCount{};
 	};
 }
@@ -47,7 +47,7 @@ namespace lve {
         {
             vkDestroyImageView(m_Device.GetDevice(), m_DepthImageViews[index], nullptr);
             vkDestroyImage(m_Device.GetDevice(), m_DepthImages[index], nullptr);
-            vkFreeMemory(m_Device.GetDevice(), m_DepthImageMemorys[index], nullptr);
+            m_Device.GetAllocator().Free(m_DepthImageMemorys[index]);
         }
 
         for (auto framebuffer : m_SwapChainFramebuffers) 
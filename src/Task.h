@@ -0,0 +1,169 @@
+#pragma once
+
+// std includes
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace lve
+{
+	// Lazily started coroutine. Awaiting a Task starts it and resumes the awaiter once it finished,
+	// Detach starts it without anyone waiting, the frame then cleans itself up.
+	template<typename T = void>
+	class Task;
+
+	namespace detail
+	{
+		struct TaskPromiseBase
+		{
+			struct FinalAwaiter
+			{
+				bool await_ready() const noexcept { return false; }
+
+				template<typename Promise>
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+				{
+					TaskPromiseBase& promise = handle.promise();
+					if (promise.isDetached)
+					{
+						handle.destroy();
+						return std::noop_coroutine();
+					}
+					return promise.continuation ? promise.continuation : std::noop_coroutine();
+				}
+
+				void await_resume() const noexcept {}
+			};
+
+			std::suspend_always initial_suspend() const noexcept { return {}; }
+			FinalAwaiter final_suspend() const noexcept { return {}; }
+
+			void unhandled_exception()
+			{
+				// nobody could ever observe the exception of a detached task
+				if (isDetached)
+				{
+					std::terminate();
+				}
+				exception = std::current_exception();
+			}
+
+			std::coroutine_handle<> continuation{};
+			std::exception_ptr exception{};
+			bool isDetached{ false };
+		};
+
+		template<typename T>
+		struct TaskPromise final : TaskPromiseBase
+		{
+			Task<T> get_return_object() noexcept;
+
+			template<typename U>
+			void return_value(U&& result) { value.emplace(std::forward<U>(result)); }
+
+			T TakeResult()
+			{
+				if (exception)
+				{
+					std::rethrow_exception(exception);
+				}
+				return std::move(*value);
+			}
+
+			std::optional<T> value{};
+		};
+
+		template<>
+		struct TaskPromise<void> final : TaskPromiseBase
+		{
+			Task<void> get_return_object() noexcept;
+
+			void return_void() const noexcept {}
+
+			void TakeResult() const
+			{
+				if (exception)
+				{
+					std::rethrow_exception(exception);
+				}
+			}
+		};
+	}
+
+	template<typename T>
+	class Task final
+	{
+	public:
+		using promise_type = detail::TaskPromise<T>;
+
+		explicit Task(std::coroutine_handle<promise_type> handle) noexcept : m_Handle{ handle } {}
+		~Task()
+		{
+			if (m_Handle)
+			{
+				m_Handle.destroy();
+			}
+		}
+
+		Task(const Task&) = delete;
+		Task(Task&& other) noexcept : m_Handle{ std::exchange(other.m_Handle, nullptr) } {}
+		Task& operator=(const Task&) = delete;
+		Task& operator=(Task&& other) noexcept
+		{
+			if (this != &other)
+			{
+				if (m_Handle)
+				{
+					m_Handle.destroy();
+				}
+				m_Handle = std::exchange(other.m_Handle, nullptr);
+			}
+			return *this;
+		}
+
+		auto operator co_await() && noexcept
+		{
+			struct Awaiter
+			{
+				std::coroutine_handle<promise_type> handle;
+
+				bool await_ready() const noexcept { return !handle || handle.done(); }
+
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+				{
+					handle.promise().continuation = awaiting;
+					return handle;
+				}
+
+				T await_resume() { return handle.promise().TakeResult(); }
+			};
+			return Awaiter{ m_Handle };
+		}
+
+		// Starts the task and gives up ownership
+		void Detach() &&
+		{
+			std::coroutine_handle<promise_type> handle = std::exchange(m_Handle, nullptr);
+			handle.promise().isDetached = true;
+			handle.resume();
+		}
+
+	private:
+		std::coroutine_handle<promise_type> m_Handle;
+	};
+
+	namespace detail
+	{
+		template<typename T>
+		Task<T> TaskPromise<T>::get_return_object() noexcept
+		{
+			return Task<T>{ std::coroutine_handle<TaskPromise<T>>::from_promise(*this) };
+		}
+
+		inline Task<void> TaskPromise<void>::get_return_object() noexcept
+		{
+			return Task<void>{ std::coroutine_handle<TaskPromise<void>>::from_promise(*this) };
+		}
+	}
+}
@@ -0,0 +1,30 @@
+#include "TaskScheduler.h"
+
+namespace lve
+{
+	TaskScheduler::TaskScheduler(ThreadPool& threadPool)
+		: m_ThreadPool{ threadPool }
+	{
+	}
+
+	void TaskScheduler::RunMainThreadTasks()
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_RunningTasks.swap(m_MainThreadTasks);
+		}
+
+		// tasks posted while these run wait for the next frame
+		for (std::coroutine_handle<> handle : m_RunningTasks)
+		{
+			handle.resume();
+		}
+		m_RunningTasks.clear();
+	}
+
+	void TaskScheduler::PostToMainThread(std::coroutine_handle<> handle)
+	{
+		std::lock_guard lock{ m_Mutex };
+		m_MainThreadTasks.push_back(handle);
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "ThreadPool.h"
+
+// std includes
+#include <coroutine>
+#include <mutex>
+#include <vector>
+
+namespace lve
+{
+	// Moves coroutines between the worker pool and the main thread.
+	// Anything touching Vulkan objects shared with rendering awaits SwitchToMainThread first.
+	class TaskScheduler final
+	{
+	public:
+		explicit TaskScheduler(ThreadPool& threadPool);
+		~TaskScheduler() = default;
+
+		TaskScheduler(const TaskScheduler&) = delete;
+		TaskScheduler(TaskScheduler&&) = delete;
+		TaskScheduler& operator=(const TaskScheduler&) = delete;
+		TaskScheduler& operator=(TaskScheduler&&) = delete;
+
+		struct WorkerAwaiter
+		{
+			ThreadPool& threadPool;
+
+			bool await_ready() const noexcept { return false; }
+			void await_suspend(std::coroutine_handle<> handle) const { threadPool.Enqueue([handle]() { handle.resume(); }); }
+			void await_resume() const noexcept {}
+		};
+
+		struct MainThreadAwaiter
+		{
+			TaskScheduler& scheduler;
+
+			bool await_ready() const noexcept { return false; }
+			void await_suspend(std::coroutine_handle<> handle) const { scheduler.PostToMainThread(handle); }
+			void await_resume() const noexcept {}
+		};
+
+		WorkerAwaiter SwitchToWorker() { return { m_ThreadPool }; }
+		MainThreadAwaiter SwitchToMainThread() { return { *this }; }
+
+		// Resumes every coroutine waiting for the main thread, called once per frame
+		void RunMainThreadTasks();
+
+	private:
+		void PostToMainThread(std::coroutine_handle<> handle);
+
+		ThreadPool& m_ThreadPool;
+		std::mutex m_Mutex;
+		std::vector<std::coroutine_handle<>> m_MainThreadTasks;
+		std::vector<std::coroutine_handle<>> m_RunningTasks;
+	};
+}
@@ -0,0 +1,339 @@
+#include "TerrainQuery.h"
+#include "ThreadPool.h"
+#include "Utils.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace lve
+{
+	namespace
+	{
+		// same operation order as the SIMD path
+		float Lerp(float a, float b, float t)
+		{
+			return a + t * (b - a);
+		}
+
+		// Calls body(first, count) over batches of at most batchSize items on the shared pool
+		template<typename Body>
+		void ForEachBatch(size_t count, uint32_t batchSize, Body body)
+		{
+			const uint32_t batchCount = static_cast<uint32_t>((count + batchSize - 1) / batchSize);
+			if (batchCount <= 1)
+			{
+				body(size_t{}, count);
+				return;
+			}
+
+			ThreadPool::GetShared().ParallelFor(batchCount, [&](uint32_t batch)
+			{
+				const size_t first = static_cast<size_t>(batch) * batchSize;
+				body(first, std::min<size_t>(batchSize, count - first));
+			});
+		}
+
+		// Clips the ray to [low, high) along one axis, false when it misses the slab
+		bool ClipSlab(float origin, float direction, float low, float high, float& t0, float& t1)
+		{
+			if (std::abs(direction) < 1e-12f)
+			{
+				return origin >= low && origin <= high;
+			}
+
+			const float inverse = 1.f / direction;
+			float near = (low - origin) * inverse;
+			float far = (high - origin) * inverse;
+			if (near > far)
+			{
+				std::swap(near, far);
+			}
+
+			t0 = std::max(t0, near);
+			t1 = std::min(t1, far);
+			return t0 <= t1;
+		}
+	}
+
+	TerrainQuery::TerrainQuery(const float* pHeights, int rows, int columns, glm::vec2 spacing, glm::vec3 origin)
+		: m_Rows{ rows }
+		, m_Columns{ columns }
+		, m_Spacing{ spacing }
+		, m_Origin{ origin }
+		, m_Heights(pHeights, pHeights + static_cast<size_t>(rows) * columns)
+		, m_UseSse41{ NoiseGrid::GetBestIsa() >= NoiseGrid::Isa::Sse41 }
+	{
+		assert(rows >= 2 && columns >= 2 && "A terrain query needs at least one quad");
+
+		Level quads{ columns - 1, rows - 1, {} };
+		quads.bounds.resize(static_cast<size_t>(quads.columns) * quads.rows);
+		ThreadPool::GetShared().ParallelFor(static_cast<uint32_t>(quads.rows), [&](uint32_t z)
+		{
+			for (int x{}; x < quads.columns; ++x)
+			{
+				const float h00 = GetSample(x, z);
+				const float h10 = GetSample(x + 1, z);
+				const float h01 = GetSample(x, z + 1);
+				const float h11 = GetSample(x + 1, z + 1);
+				quads.bounds[static_cast<size_t>(z) * quads.columns + x] =
+				{
+					std::min(std::min(h00, h10), std::min(h01, h11)),
+					std::max(std::max(h00, h10), std::max(h01, h11))
+				};
+			}
+		});
+		m_Levels.push_back(std::move(quads));
+
+		while (m_Levels.back().columns > 1 || m_Levels.back().rows > 1)
+		{
+			const Level& child = m_Levels.back();
+			Level parent{ (child.columns + 1) / 2, (child.rows + 1) / 2, {} };
+			parent.bounds.resize(static_cast<size_t>(parent.columns) * parent.rows);
+
+			for (int z{}; z < parent.rows; ++z)
+			{
+				for (int x{}; x < parent.columns; ++x)
+				{
+					glm::vec2 bounds{ std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest() };
+					for (int childZ = z * 2; childZ < std::min(z * 2 + 2, child.rows); ++childZ)
+					{
+						for (int childX = x * 2; childX < std::min(x * 2 + 2, child.columns); ++childX)
+						{
+							const glm::vec2& childBounds = child.bounds[static_cast<size_t>(childZ) * child.columns + childX];
+							bounds.x = std::min(bounds.x, childBounds.x);
+							bounds.y = std::max(bounds.y, childBounds.y);
+						}
+					}
+					parent.bounds[static_cast<size_t>(z) * parent.columns + x] = bounds;
+				}
+			}
+			m_Levels.push_back(std::move(parent));
+		}
+	}
+
+	float TerrainQuery::GetHeight(glm::vec2 position) const
+	{
+		float height{};
+		SampleScalar(&position, 1, &height, nullptr);
+		return height;
+	}
+
+	glm::vec3 TerrainQuery::GetNormal(glm::vec2 position) const
+	{
+		glm::vec3 normal{};
+		SampleScalar(&position, 1, nullptr, &normal);
+		return normal;
+	}
+
+	void TerrainQuery::GetHeights(std::span<const glm::vec2> positions, std::span<float> heights, std::span<glm::vec3> normals) const
+	{
+		assert((heights.empty() || heights.size() >= positions.size()) && (normals.empty() || normals.size() >= positions.size()));
+
+		ForEachBatch(positions.size(), BATCH_SIZE, [&](size_t first, size_t count)
+		{
+			float* pHeights = heights.empty() ? nullptr : heights.data() + first;
+			glm::vec3* pNormals = normals.empty() ? nullptr : normals.data() + first;
+
+			uint32_t sampled{};
+#ifdef LVE_NOISE_X86
+			if (m_UseSse41)
+			{
+				sampled = SampleSse41(positions.data() + first, static_cast<uint32_t>(count), pHeights, pNormals);
+			}
+#endif
+			SampleScalar(positions.data() + first + sampled, static_cast<uint32_t>(count) - sampled,
+				pHeights ? pHeights + sampled : nullptr, pNormals ? pNormals + sampled : nullptr);
+		});
+	}
+
+	void TerrainQuery::IntersectRays(std::span<const Ray> rays, std::span<RayHit> hits) const
+	{
+		assert(hits.size() >= rays.size());
+
+		// every ray walks its own path down the pyramid, so rays only run side by side across threads
+		ForEachBatch(rays.size(), BATCH_SIZE / 16, [&](size_t first, size_t count)
+		{
+			for (size_t index = first; index < first + count; ++index)
+			{
+				hits[index] = IntersectRay(rays[index]);
+			}
+		});
+	}
+
+	uint64_t TerrainQuery::GetRegionHash(glm::vec2 low, glm::vec2 high) const
+	{
+		// the grid placement is part of the ground too, the same samples elsewhere are a different surface
+		const float placement[]{ m_Spacing.x, m_Spacing.y, m_Origin.x, m_Origin.y, m_Origin.z };
+		uint64_t hash = HashBytes(placement, sizeof(placement));
+
+		const glm::vec2 gridOrigin{ m_Origin.x, m_Origin.z };
+		const glm::vec2 gridLow = (low - gridOrigin) / m_Spacing;
+		const glm::vec2 gridHigh = (high - gridOrigin) / m_Spacing;
+		const int firstX = std::clamp(static_cast<int>(std::floor(gridLow.x)), 0, m_Columns - 1);
+		const int firstZ = std::clamp(static_cast<int>(std::floor(gridLow.y)), 0, m_Rows - 1);
+		const int lastX = std::clamp(static_cast<int>(std::ceil(gridHigh.x)), 0, m_Columns - 1);
+		const int lastZ = std::clamp(static_cast<int>(std::ceil(gridHigh.y)), 0, m_Rows - 1);
+
+		for (int z = firstZ; z <= lastZ; ++z)
+		{
+			hash = HashBytes(&m_Heights[static_cast<size_t>(z) * m_Columns + firstX], static_cast<size_t>(lastX - firstX + 1) * sizeof(float), hash);
+		}
+		return hash;
+	}
+
+	void TerrainQuery::SampleScalar(const glm::vec2* pPositions, uint32_t count, float* pHeights, glm::vec3* pNormals) const
+	{
+		const glm::vec2 inverseSpacing = 1.f / m_Spacing;
+		const float maxX = static_cast<float>(m_Columns - 1);
+		const float maxZ = static_cast<float>(m_Rows - 1);
+
+		for (uint32_t index{}; index < count; ++index)
+		{
+			const float x = std::clamp((pPositions[index].x - m_Origin.x) * inverseSpacing.x, 0.f, maxX);
+			const float z = std::clamp((pPositions[index].y - m_Origin.z) * inverseSpacing.y, 0.f, maxZ);
+			const int quadX = std::min(static_cast<int>(x), m_Columns - 2);
+			const int quadZ = std::min(static_cast<int>(z), m_Rows - 2);
+			const float fractionX = x - static_cast<float>(quadX);
+			const float fractionZ = z - static_cast<float>(quadZ);
+
+			const float h00 = GetSample(quadX, quadZ);
+			const float h10 = GetSample(quadX + 1, quadZ);
+			const float h01 = GetSample(quadX, quadZ + 1);
+			const float h11 = GetSample(quadX + 1, quadZ + 1);
+
+			if (pHeights)
+			{
+				pHeights[index] = Lerp(Lerp(h00, h10, fractionX), Lerp(h01, h11, fractionX), fractionZ) + m_Origin.y;
+			}
+
+			if (pNormals)
+			{
+				// derivatives of the bilinear patch, the normal of y = h(x, z) pointing at -y
+				const float slopeX = Lerp(h10 - h00, h11 - h01, fractionZ) * inverseSpacing.x;
+				const float slopeZ = Lerp(h01 - h00, h11 - h10, fractionX) * inverseSpacing.y;
+				pNormals[index] = glm::vec3{ slopeX, -1.f, slopeZ } / std::sqrt(slopeX * slopeX + 1.f + slopeZ * slopeZ);
+			}
+		}
+	}
+
+	TerrainQuery::RayHit TerrainQuery::IntersectRay(const Ray& ray) const
+	{
+		// in grid units x and z count samples, so node and quad bounds are whole numbers
+		const glm::vec3 origin{ (ray.origin.x - m_Origin.x) / m_Spacing.x, ray.origin.y - m_Origin.y, (ray.origin.z - m_Origin.z) / m_Spacing.y };
+		const glm::vec3 direction{ ray.direction.x / m_Spacing.x, ray.direction.y, ray.direction.z / m_Spacing.y };
+
+		// children nearer to the ray origin come first, a ray crosses at most one of the two side children of a node
+		const int nearX = direction.x >= 0.f ? 0 : 1;
+		const int nearZ = direction.z >= 0.f ? 0 : 1;
+		const int childOrder[4][2]{ { nearX, nearZ }, { 1 - nearX, nearZ }, { nearX, 1 - nearZ }, { 1 - nearX, 1 - nearZ } };
+
+		struct Node
+		{
+			int level;
+			int x;
+			int z;
+		};
+
+		// depth first, front to back, so the first quad hit is the nearest
+		Node stack[64 * 3];
+		int stackSize{};
+		stack[stackSize++] = { static_cast<int>(m_Levels.size()) - 1, 0, 0 };
+
+		while (stackSize > 0)
+		{
+			const Node node = stack[--stackSize];
+			const Level& level = m_Levels[node.level];
+
+			const int nodeSize = 1 << node.level;
+			float t0{ 0.f };
+			float t1{ ray.maxDistance };
+			if (!ClipSlab(origin.x, direction.x, static_cast<float>(node.x * nodeSize), static_cast<float>(std::min((node.x + 1) * nodeSize, m_Columns - 1)), t0, t1)
+				|| !ClipSlab(origin.z, direction.z, static_cast<float>(node.z * nodeSize), static_cast<float>(std::min((node.z + 1) * nodeSize, m_Rows - 1)), t0, t1))
+			{
+				continue;
+			}
+
+			// the ray stays above everything under the node while its lowest point is above the highest ground
+			const float lowestPoint = std::max(origin.y + direction.y * t0, origin.y + direction.y * t1);
+			if (lowestPoint < level.bounds[static_cast<size_t>(node.z) * level.columns + node.x].x)
+			{
+				continue;
+			}
+
+			if (node.level == 0)
+			{
+				const float t = IntersectQuad(node.x, node.z, origin, direction, t0, t1);
+				if (t >= 0.f)
+				{
+					return { true, t, ray.origin + ray.direction * t };
+				}
+				continue;
+			}
+
+			const Level& children = m_Levels[node.level - 1];
+			for (int child = 3; child >= 0; --child)
+			{
+				const int childX = node.x * 2 + childOrder[child][0];
+				const int childZ = node.z * 2 + childOrder[child][1];
+				if (childX < children.columns && childZ < children.rows)
+				{
+					stack[stackSize++] = { node.level - 1, childX, childZ };
+				}
+			}
+		}
+
+		return { false, ray.maxDistance, ray.origin + ray.direction * ray.maxDistance };
+	}
+
+	float TerrainQuery::IntersectQuad(int quadX, int quadZ, const glm::vec3& origin, const glm::vec3& direction, float t0, float t1) const
+	{
+		const float h00 = GetSample(quadX, quadZ);
+		const float a1 = GetSample(quadX + 1, quadZ) - h00;
+		const float a2 = GetSample(quadX, quadZ + 1) - h00;
+		const float a3 = GetSample(quadX + 1, quadZ + 1) - h00 - a1 - a2;
+
+		// the fractions inside the quad are linear in t, so ray height minus ground height is a quadratic in t
+		const float fractionX = origin.x - static_cast<float>(quadX);
+		const float fractionZ = origin.z - static_cast<float>(quadZ);
+		const double a = -a3 * direction.x * direction.z;
+		const double b = direction.y - a1 * direction.x - a2 * direction.z - a3 * (fractionX * direction.z + direction.x * fractionZ);
+		const double c = origin.y - h00 - a1 * fractionX - a2 * fractionZ - a3 * fractionX * fractionZ;
+
+		auto getDifference = [&](double t) { return (a * t + b) * t + c; };
+		if (getDifference(t0) >= 0.0)
+		{
+			return t0;
+		}
+
+		// the difference is negative at t0, so the first root after it is where the ray reaches the ground
+		double root{ -1.0 };
+		if (std::abs(a) < 1e-12)
+		{
+			if (b > 0.0)
+			{
+				root = -c / b;
+			}
+		}
+		else
+		{
+			const double discriminant = b * b - 4.0 * a * c;
+			if (discriminant >= 0.0)
+			{
+				// stable form, both roots without cancelling b against the square root
+				const double q = -0.5 * (b + std::copysign(std::sqrt(discriminant), b));
+				double root0 = q / a;
+				double root1 = q != 0.0 ? c / q : root0;
+				if (root0 > root1)
+				{
+					std::swap(root0, root1);
+				}
+				root = root0 >= t0 ? root0 : root1;
+			}
+		}
+
+		return root >= t0 && root <= t1 ? static_cast<float>(root) : -1.f;
+	}
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include "NoiseGrid.h"
+
+//libs
+#include <glm/glm.hpp>
+
+// std includes
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace lve
+{
+	// CPU copy of a terrain height grid for gameplay queries. Heights are bilinear between samples and normals are the
+	// analytic derivative of that surface. Rays descend a min/max pyramid over the grid quads, so they only test the quads
+	// they pass close to. Positions are in world space, the grid starts at origin and +y points down like everywhere else.
+	// Batches run on the shared thread pool, queries are safe from any thread while nothing replaces the terrain.
+	class TerrainQuery final
+	{
+	public:
+		struct Ray
+		{
+			glm::vec3 origin;
+			// does not need to be normalized, distances are in multiples of it
+			glm::vec3 direction;
+			float maxDistance;
+		};
+
+		struct RayHit
+		{
+			bool isHit;
+			float distance;
+			glm::vec3 position;
+		};
+
+		// heights are rows * columns values stored row by row, spacing is the world distance between samples along x and z
+		TerrainQuery(const float* pHeights, int rows, int columns, glm::vec2 spacing, glm::vec3 origin);
+		~TerrainQuery() = default;
+
+		TerrainQuery(const TerrainQuery&) = delete;
+		TerrainQuery(TerrainQuery&&) = delete;
+		TerrainQuery& operator=(const TerrainQuery&) = delete;
+		TerrainQuery& operator=(TerrainQuery&&) = delete;
+
+		// positions are world x and z, outside the grid the edge is extended
+		float GetHeight(glm::vec2 position) const;
+		// points away from the ground, towards -y
+		glm::vec3 GetNormal(glm::vec2 position) const;
+		// Either output may be empty, otherwise it holds one value per position
+		void GetHeights(std::span<const glm::vec2> positions, std::span<float> heights, std::span<glm::vec3> normals = {}) const;
+		// Nearest point where each ray enters the ground within its max distance
+		void IntersectRays(std::span<const Ray> rays, std::span<RayHit> hits) const;
+		// Fingerprint of every sample the surface between low and high depends on, equal hashes mean the ground there is the same
+		uint64_t GetRegionHash(glm::vec2 low, glm::vec2 high) const;
+
+		glm::vec3 GetOrigin() const { return m_Origin; }
+		// world size along x and z
+		glm::vec2 GetSize() const { return glm::vec2{ static_cast<float>(m_Columns - 1), static_cast<float>(m_Rows - 1) } * m_Spacing; }
+
+	private:
+		// x is the lowest and y the highest height under a node
+		struct Level
+		{
+			int columns;
+			int rows;
+			std::vector<glm::vec2> bounds;
+		};
+
+		// Samples count positions, pHeights or pNormals may be null
+		void SampleScalar(const glm::vec2* pPositions, uint32_t count, float* pHeights, glm::vec3* pNormals) const;
+#ifdef LVE_NOISE_X86
+		// handles every full group of four and returns how many positions it sampled
+		uint32_t SampleSse41(const glm::vec2* pPositions, uint32_t count, float* pHeights, glm::vec3* pNormals) const;
+#endif
+		RayHit IntersectRay(const Ray& ray) const;
+		// first t in [t0, t1] where the ray in grid units reaches the bilinear patch of a quad, negative when it stays above
+		float IntersectQuad(int quadX, int quadZ, const glm::vec3& origin, const glm::vec3& direction, float t0, float t1) const;
+		float GetSample(int x, int z) const { return m_Heights[static_cast<size_t>(z) * m_Columns + x]; }
+
+		// queries smaller than this stay on the calling thread
+		static constexpr uint32_t BATCH_SIZE{ 4096 };
+
+		const int m_Rows;
+		const int m_Columns;
+		const glm::vec2 m_Spacing;
+		const glm::vec3 m_Origin;
+		std::vector<float> m_Heights;
+		// level 0 has one node per quad, every level above merges 2x2 nodes until one node covers the grid
+		std::vector<Level> m_Levels;
+		const bool m_UseSse41;
+	};
+}
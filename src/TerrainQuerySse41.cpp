@@ -0,0 +1,87 @@
+#include "TerrainQuery.h"
+
+#ifdef LVE_NOISE_X86
+#include <smmintrin.h>
+
+namespace lve
+{
+	// Same operations as SampleScalar in the same order, four positions at a time. Only the corner loads stay scalar.
+	uint32_t TerrainQuery::SampleSse41(const glm::vec2* pPositions, uint32_t count, float* pHeights, glm::vec3* pNormals) const
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.f);
+		const __m128 originX = _mm_set1_ps(m_Origin.x);
+		const __m128 originY = _mm_set1_ps(m_Origin.y);
+		const __m128 originZ = _mm_set1_ps(m_Origin.z);
+		const __m128 inverseSpacingX = _mm_set1_ps(1.f / m_Spacing.x);
+		const __m128 inverseSpacingZ = _mm_set1_ps(1.f / m_Spacing.y);
+		const __m128 maxX = _mm_set1_ps(static_cast<float>(m_Columns - 1));
+		const __m128 maxZ = _mm_set1_ps(static_cast<float>(m_Rows - 1));
+		const __m128i maxQuadX = _mm_set1_epi32(m_Columns - 2);
+		const __m128i maxQuadZ = _mm_set1_epi32(m_Rows - 2);
+		const __m128i columns = _mm_set1_epi32(m_Columns);
+		const float* pSamples = m_Heights.data();
+
+		auto lerp = [](__m128 a, __m128 b, __m128 t)
+		{
+			return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+		};
+
+		const uint32_t vectorCount = count & ~3u;
+		for (uint32_t index{}; index < vectorCount; index += 4)
+		{
+			// x and z of four positions, deinterleaved
+			const __m128 first = _mm_loadu_ps(&pPositions[index].x);
+			const __m128 second = _mm_loadu_ps(&pPositions[index + 2].x);
+			const __m128 positionX = _mm_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0));
+			const __m128 positionZ = _mm_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1));
+
+			const __m128 x = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(positionX, originX), inverseSpacingX), zero), maxX);
+			const __m128 z = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(positionZ, originZ), inverseSpacingZ), zero), maxZ);
+			// both are positive, so truncating is the floor of the scalar path
+			const __m128i quadX = _mm_min_epi32(_mm_cvttps_epi32(x), maxQuadX);
+			const __m128i quadZ = _mm_min_epi32(_mm_cvttps_epi32(z), maxQuadZ);
+			const __m128 fractionX = _mm_sub_ps(x, _mm_cvtepi32_ps(quadX));
+			const __m128 fractionZ = _mm_sub_ps(z, _mm_cvtepi32_ps(quadZ));
+
+			alignas(16) int corners[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(corners), _mm_add_epi32(_mm_mullo_epi32(quadZ, columns), quadX));
+			const size_t c0 = static_cast<size_t>(corners[0]);
+			const size_t c1 = static_cast<size_t>(corners[1]);
+			const size_t c2 = static_cast<size_t>(corners[2]);
+			const size_t c3 = static_cast<size_t>(corners[3]);
+			const size_t row = static_cast<size_t>(m_Columns);
+			const __m128 h00 = _mm_setr_ps(pSamples[c0], pSamples[c1], pSamples[c2], pSamples[c3]);
+			const __m128 h10 = _mm_setr_ps(pSamples[c0 + 1], pSamples[c1 + 1], pSamples[c2 + 1], pSamples[c3 + 1]);
+			const __m128 h01 = _mm_setr_ps(pSamples[c0 + row], pSamples[c1 + row], pSamples[c2 + row], pSamples[c3 + row]);
+			const __m128 h11 = _mm_setr_ps(pSamples[c0 + row + 1], pSamples[c1 + row + 1], pSamples[c2 + row + 1], pSamples[c3 + row + 1]);
+
+			if (pHeights)
+			{
+				const __m128 height = lerp(lerp(h00, h10, fractionX), lerp(h01, h11, fractionX), fractionZ);
+				_mm_storeu_ps(pHeights + index, _mm_add_ps(height, originY));
+			}
+
+			if (pNormals)
+			{
+				const __m128 slopeX = _mm_mul_ps(lerp(_mm_sub_ps(h10, h00), _mm_sub_ps(h11, h01), fractionZ), inverseSpacingX);
+				const __m128 slopeZ = _mm_mul_ps(lerp(_mm_sub_ps(h01, h00), _mm_sub_ps(h11, h10), fractionX), inverseSpacingZ);
+				const __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(slopeX, slopeX), one), _mm_mul_ps(slopeZ, slopeZ)));
+
+				alignas(16) float normalX[4];
+				alignas(16) float normalY[4];
+				alignas(16) float normalZ[4];
+				_mm_store_ps(normalX, _mm_div_ps(slopeX, length));
+				_mm_store_ps(normalY, _mm_div_ps(_mm_set1_ps(-1.f), length));
+				_mm_store_ps(normalZ, _mm_div_ps(slopeZ, length));
+				for (int lane{}; lane < 4; ++lane)
+				{
+					pNormals[index + lane] = { normalX[lane], normalY[lane], normalZ[lane] };
+				}
+			}
+		}
+
+		return vectorCount;
+	}
+}
+#endif
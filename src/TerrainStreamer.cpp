@@ -0,0 +1,322 @@
+#include "TerrainStreamer.h"
+#include "NoiseGrid.h"
+#include "SwapChain.h"
+#include "Utils.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+namespace lve
+{
+	size_t TerrainStreamer::NodeKeyHash::operator()(const NodeKey& key) const
+	{
+		const uint64_t position = (static_cast<uint64_t>(static_cast<uint32_t>(key.x)) << 32) | static_cast<uint32_t>(key.z);
+		return static_cast<size_t>(MixBits(position ^ (static_cast<uint64_t>(key.level) << 58)));
+	}
+
+	TerrainStreamer::TerrainStreamer(Device& device, GeometryPool& geometryPool, TaskScheduler& scheduler)
+		: TerrainStreamer(device, geometryPool, scheduler, Settings{})
+	{
+	}
+
+	TerrainStreamer::TerrainStreamer(Device& device, GeometryPool& geometryPool, TaskScheduler& scheduler, const Settings& settings)
+		: m_Device{ device }
+		, m_GeometryPool{ geometryPool }
+		, m_Scheduler{ scheduler }
+		, m_Settings{ settings }
+	{
+	}
+
+	TerrainStreamer::~TerrainStreamer()
+	{
+	}
+
+	void TerrainStreamer::Update(const glm::vec3& viewerPosition)
+	{
+		++m_FrameIndex;
+		std::erase_if(m_RetiredMeshes, [this](const RetiredMesh& retired)
+		{
+			return m_FrameIndex >= retired.frame + SwapChain::MAX_FRAMES_IN_FLIGHT;
+		});
+
+		std::vector<GameObject::IdT> selectedNodes{};
+		std::vector<NodeKey> missingNodes{};
+		SelectNodes(viewerPosition, selectedNodes, missingNodes);
+
+		// move the selected nodes to the front, only that part is drawn
+		std::sort(selectedNodes.begin(), selectedNodes.end());
+		auto selectedEnd = std::partition(m_GameObjects.begin(), m_GameObjects.end(), [&selectedNodes](const GameObject& object)
+		{
+			return std::binary_search(selectedNodes.begin(), selectedNodes.end(), object.GetId());
+		});
+		m_SelectedNodeCount = static_cast<size_t>(selectedEnd - m_GameObjects.begin());
+		m_TriangleCount = static_cast<uint32_t>(m_SelectedNodeCount) * GetNodeTriangleCount();
+
+		for (const NodeKey& key : missingNodes)
+		{
+			if (m_PendingNodes.size() >= m_Settings.maxPendingNodes)
+			{
+				break;
+			}
+			LoadNode(key).Detach();
+		}
+
+		EvictNodes();
+	}
+
+	Task<> TerrainStreamer::LoadNode(NodeKey key)
+	{
+		m_PendingNodes.insert(key);
+
+		co_await m_Scheduler.SwitchToWorker();
+		Mesh::Data data = GenerateNode(m_Settings, key);
+		co_await m_Scheduler.SwitchToMainThread();
+
+		m_PendingNodes.erase(key);
+
+		auto node{ GameObject::CreateGameObject() };
+		node.mesh = std::make_shared<Mesh>(m_Device, m_GeometryPool, data, VertexFormat::Packed);
+		const float nodeSize = GetNodeSize(key.level);
+		node.transform.translation = { static_cast<float>(key.x) * nodeSize, m_Settings.elevation, static_cast<float>(key.z) * nodeSize };
+
+		const VkDeviceSize size = node.mesh->GetGeometrySize();
+		m_MemoryUsage += size;
+		m_Nodes.push_front({ key, node.GetId(), size, m_FrameIndex });
+		m_NodeLookup.emplace(key, m_Nodes.begin());
+		// behind the selected nodes, it is drawn once an Update selects it
+		m_GameObjects.push_back(std::move(node));
+	}
+
+	Mesh::Data TerrainStreamer::GenerateNode(const Settings& settings, NodeKey key)
+	{
+		const int resolution = settings.resolution;
+		const int sideCount = resolution + 1;
+		const float scale = static_cast<float>(1 << key.level);
+		// a power of two times the finest spacing, so samples shared with other levels get the same height
+		const float spacing = settings.chunkSize * scale / static_cast<float>(resolution);
+
+		// one extra sample on every side, so normals on the edges match the neighbouring node
+		const int sampleCount = sideCount + 2;
+		const std::vector<NoiseGrid::Octave> octaves{ { 1.f, 1.f }, { 2.f, 0.5f }, { 4.f, 0.25f } };
+		std::vector<float> heights(static_cast<size_t>(sampleCount) * sampleCount);
+		NoiseGrid::GeneratePerlin(settings.seed, settings.frequency * spacing, octaves,
+			key.x * resolution - 1, sampleCount, key.z * resolution - 1, sampleCount, heights.data());
+
+		const float heightScale = settings.amplitude / (1.f + 0.5f + 0.25f);
+		auto sampleHeight = [&](int x, int z)
+		{
+			return heights[static_cast<size_t>(z + 1) * sampleCount + (x + 1)] * heightScale;
+		};
+
+		Mesh::Data data{};
+		data.vertices.resize(static_cast<size_t>(sideCount) * (sideCount + 4));
+		for (int z{}; z < sideCount; ++z)
+		{
+			for (int x{}; x < sideCount; ++x)
+			{
+				Mesh::Vertex& vertex = data.vertices[static_cast<size_t>(z) * sideCount + x];
+				const float height = sampleHeight(x, z);
+
+				vertex.position = { static_cast<float>(x) * spacing, height, static_cast<float>(z) * spacing };
+				// cross of the x and z tangents, pointing at -y like the other terrain
+				vertex.normal = glm::normalize(glm::vec3
+				{
+					(sampleHeight(x + 1, z) - sampleHeight(x - 1, z)) / (2.f * spacing),
+					-1.f,
+					(sampleHeight(x, z + 1) - sampleHeight(x, z - 1)) / (2.f * spacing)
+				});
+
+				const float blend = std::clamp(height / settings.amplitude * 0.5f + 0.5f, 0.f, 1.f);
+				vertex.color = glm::mix(glm::vec3{ 0.3f, 0.5f, 0.2f }, glm::vec3{ 0.4f, 0.3f, 0.2f }, blend);
+				vertex.uv = { static_cast<float>(x) / static_cast<float>(resolution), static_cast<float>(z) / static_cast<float>(resolution) };
+			}
+		}
+
+		Mesh::GenerateGridIndices(sideCount, sideCount, data);
+
+		// Skirts, a copy of every edge hanging below it. A coarser neighbour skips every other edge vertex,
+		// the skirts fill the gap that leaves.
+		const float skirtDepth = settings.skirtDepth * scale;
+		const uint32_t edgeStarts[4]{ 0, static_cast<uint32_t>(resolution * sideCount), 0, static_cast<uint32_t>(resolution) };
+		const uint32_t edgeSteps[4]{ 1, 1, static_cast<uint32_t>(sideCount), static_cast<uint32_t>(sideCount) };
+		for (int edge{}; edge < 4; ++edge)
+		{
+			const uint32_t firstSkirtVertex = static_cast<uint32_t>(sideCount * (sideCount + edge));
+			data.indices.push_back(Mesh::RESTART_INDEX);
+			for (int i{}; i < sideCount; ++i)
+			{
+				const uint32_t edgeVertex = edgeStarts[edge] + edgeSteps[edge] * i;
+				Mesh::Vertex& skirtVertex = data.vertices[firstSkirtVertex + i];
+				skirtVertex = data.vertices[edgeVertex];
+				skirtVertex.position.y += skirtDepth;
+
+				data.indices.push_back(edgeVertex);
+				data.indices.push_back(firstSkirtVertex + i);
+			}
+		}
+
+		return data;
+	}
+
+	void TerrainStreamer::SelectNodes(const glm::vec3& viewerPosition, std::vector<GameObject::IdT>& selectedNodes, std::vector<NodeKey>& missingNodes)
+	{
+		// larger and closer nodes are split first, roughly the order of their error on screen
+		struct Candidate
+		{
+			Node* pNode;
+			float priority;
+
+			bool operator<(const Candidate& other) const { return priority < other.priority; }
+		};
+
+		auto getPriority = [&](const NodeKey& key)
+		{
+			return GetNodeSize(key.level) / std::max(GetDistance(key, viewerPosition), 0.001f);
+		};
+
+		std::priority_queue<Candidate> candidates{};
+		std::vector<std::pair<float, NodeKey>> wantedNodes{};
+		auto requestNode = [&](const NodeKey& key)
+		{
+			if (!m_PendingNodes.contains(key))
+			{
+				wantedNodes.emplace_back(getPriority(key), key);
+			}
+		};
+
+		const int rootLevel = m_Settings.levelCount - 1;
+		const float rootSize = GetNodeSize(rootLevel);
+		const int centerX = static_cast<int>(std::floor(viewerPosition.x / rootSize));
+		const int centerZ = static_cast<int>(std::floor(viewerPosition.z / rootSize));
+		const uint32_t nodeTriangleCount = GetNodeTriangleCount();
+
+		uint32_t triangleCount{};
+		for (int z = centerZ - m_Settings.viewRadius; z <= centerZ + m_Settings.viewRadius; ++z)
+		{
+			for (int x = centerX - m_Settings.viewRadius; x <= centerX + m_Settings.viewRadius; ++x)
+			{
+				const NodeKey key{ rootLevel, x, z };
+				if (Node* pNode = UseNode(key))
+				{
+					candidates.push({ pNode, getPriority(key) });
+					triangleCount += nodeTriangleCount;
+				}
+				else
+				{
+					requestNode(key);
+				}
+			}
+		}
+
+		// Splitting a node trades it for its four children. A node whose children are not loaded yet is drawn
+		// itself meanwhile, once a split no longer fits the budget the remaining nodes are all drawn as they are.
+		bool isOverBudget{ false };
+		while (!candidates.empty())
+		{
+			const Node& node = *candidates.top().pNode;
+			candidates.pop();
+
+			const NodeKey& key = node.key;
+			if (isOverBudget || key.level == 0 || GetDistance(key, viewerPosition) >= m_Settings.lodDistance * GetNodeSize(key.level))
+			{
+				selectedNodes.push_back(node.objectId);
+				continue;
+			}
+
+			Node* pChildren[4]{};
+			bool isLoaded{ true };
+			for (int child{}; child < 4; ++child)
+			{
+				const NodeKey childKey{ key.level - 1, key.x * 2 + (child & 1), key.z * 2 + (child >> 1) };
+				pChildren[child] = UseNode(childKey);
+				if (!pChildren[child])
+				{
+					isLoaded = false;
+					requestNode(childKey);
+				}
+			}
+
+			if (isLoaded && triangleCount + nodeTriangleCount * 3 > m_Settings.triangleBudget)
+			{
+				isOverBudget = true;
+			}
+
+			if (!isLoaded || isOverBudget)
+			{
+				selectedNodes.push_back(node.objectId);
+				continue;
+			}
+
+			triangleCount += nodeTriangleCount * 3;
+			for (Node* pChild : pChildren)
+			{
+				candidates.push({ pChild, getPriority(pChild->key) });
+			}
+		}
+
+		std::sort(wantedNodes.begin(), wantedNodes.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+		missingNodes.reserve(wantedNodes.size());
+		for (const auto& wantedNode : wantedNodes)
+		{
+			missingNodes.push_back(wantedNode.second);
+		}
+	}
+
+	void TerrainStreamer::EvictNodes()
+	{
+		// nodes used this frame are all at the front of the list
+		while (m_MemoryUsage > m_Settings.memoryBudget && !m_Nodes.empty() && m_Nodes.back().lastUsedFrame != m_FrameIndex)
+		{
+			const Node& node = m_Nodes.back();
+
+			// unused nodes are never selected, so swapping with the last object keeps the selected ones in front
+			auto it = std::find_if(m_GameObjects.begin(), m_GameObjects.end(), [&node](const GameObject& object) { return object.GetId() == node.objectId; });
+			m_RetiredMeshes.push_back({ std::move(it->mesh), m_FrameIndex });
+			std::swap(*it, m_GameObjects.back());
+			m_GameObjects.pop_back();
+
+			m_MemoryUsage -= node.size;
+			m_NodeLookup.erase(node.key);
+			m_Nodes.pop_back();
+		}
+	}
+
+	TerrainStreamer::Node* TerrainStreamer::UseNode(const NodeKey& key)
+	{
+		auto it = m_NodeLookup.find(key);
+		if (it == m_NodeLookup.end())
+		{
+			return nullptr;
+		}
+
+		m_Nodes.splice(m_Nodes.begin(), m_Nodes, it->second);
+		it->second->lastUsedFrame = m_FrameIndex;
+		return &*it->second;
+	}
+
+	float TerrainStreamer::GetNodeSize(int level) const
+	{
+		return m_Settings.chunkSize * static_cast<float>(1 << level);
+	}
+
+	float TerrainStreamer::GetDistance(const NodeKey& key, const glm::vec3& viewerPosition) const
+	{
+		const float nodeSize = GetNodeSize(key.level);
+		const float minX = static_cast<float>(key.x) * nodeSize;
+		const float minZ = static_cast<float>(key.z) * nodeSize;
+
+		const float dx = std::max({ minX - viewerPosition.x, 0.f, viewerPosition.x - (minX + nodeSize) });
+		const float dz = std::max({ minZ - viewerPosition.z, 0.f, viewerPosition.z - (minZ + nodeSize) });
+		const float dy = viewerPosition.y - m_Settings.elevation;
+		return std::sqrt(dx * dx + dy * dy + dz * dz);
+	}
+
+	uint32_t TerrainStreamer::GetNodeTriangleCount() const
+	{
+		// the grid plus a strip of two triangles per quad along each of the four skirts
+		const uint32_t resolution = static_cast<uint32_t>(m_Settings.resolution);
+		return resolution * resolution * 2 + resolution * 8;
+	}
+}
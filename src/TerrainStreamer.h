@@ -0,0 +1,135 @@
+#pragma once
+#include "Device.h"
+#include "GameObject.h"
+#include "GeometryPool.h"
+#include "Task.h"
+#include "TaskScheduler.h"
+
+// std includes
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace lve
+{
+	// Endless terrain as a grid of quadtrees. Every node is a mesh of the same resolution covering four times the area of
+	// its children, so distant terrain costs as many triangles as nearby terrain. Each frame the nodes closest to the
+	// viewer are split until the triangle budget is reached, skirts hide the cracks between neighbours of different levels.
+	// Nodes generate on the worker pool and upload on the main thread. Loaded nodes form an LRU cache, and the least
+	// recently used ones are dropped once the geometry exceeds the memory budget.
+	class TerrainStreamer final
+	{
+	public:
+		struct Settings
+		{
+			// quads along each side of a node
+			int resolution{ 32 };
+			// world units along each side of a node of the finest level
+			float chunkSize{ 16.f };
+			// levels below the root nodes, each one halves the node size
+			int levelCount{ 4 };
+			// root nodes kept around the viewer in every direction
+			int viewRadius{ 1 };
+			// a node splits while the viewer is closer than lodDistance times its size
+			float lodDistance{ 2.f };
+			// triangles drawn per frame, splitting stops before the selection exceeds it
+			uint32_t triangleBudget{ 200000 };
+			// geometry of every loaded node, nodes used this frame stay even when they alone exceed it
+			VkDeviceSize memoryBudget{ 32 * 1024 * 1024 };
+			// noise frequency per world unit
+			float frequency{ 0.05f };
+			float amplitude{ 2.f };
+			// height of the terrain plane, +y points down
+			float elevation{ 7.f };
+			// skirt length on the finest level, doubled on every level above
+			float skirtDepth{ 0.25f };
+			int seed{ 1337 };
+			// nodes generating at once, so a fast viewer does not queue nodes it already left behind
+			uint32_t maxPendingNodes{ 8 };
+		};
+
+		TerrainStreamer(Device& device, GeometryPool& geometryPool, TaskScheduler& scheduler);
+		TerrainStreamer(Device& device, GeometryPool& geometryPool, TaskScheduler& scheduler, const Settings& settings);
+		~TerrainStreamer();
+
+		TerrainStreamer(const TerrainStreamer&) = delete;
+		TerrainStreamer(TerrainStreamer&&) = delete;
+		TerrainStreamer& operator=(const TerrainStreamer&) = delete;
+		TerrainStreamer& operator=(TerrainStreamer&&) = delete;
+
+		// Selects the nodes to draw, requests missing ones most wanted first and evicts over budget. Called once per frame on the main thread.
+		void Update(const glm::vec3& viewerPosition);
+
+		// the nodes selected by the last Update
+		std::span<GameObject> GetGameObjects() { return { m_GameObjects.data(), m_SelectedNodeCount }; }
+		uint32_t GetTriangleCount() const { return m_TriangleCount; }
+		uint32_t GetPendingNodeCount() const { return static_cast<uint32_t>(m_PendingNodes.size()); }
+		uint32_t GetLoadedNodeCount() const { return static_cast<uint32_t>(m_Nodes.size()); }
+		VkDeviceSize GetMemoryUsage() const { return m_MemoryUsage; }
+
+	private:
+		// level 0 is the finest, x and z count nodes of that level
+		struct NodeKey
+		{
+			int level;
+			int x;
+			int z;
+
+			bool operator==(const NodeKey& other) const { return level == other.level && x == other.x && z == other.z; }
+		};
+
+		struct NodeKeyHash
+		{
+			size_t operator()(const NodeKey& key) const;
+		};
+
+		struct Node
+		{
+			NodeKey key;
+			GameObject::IdT objectId;
+			VkDeviceSize size;
+			uint64_t lastUsedFrame;
+		};
+
+		// evicted meshes wait until no frame in flight can still draw them
+		struct RetiredMesh
+		{
+			std::shared_ptr<Mesh> mesh;
+			uint64_t frame;
+		};
+
+		Task<> LoadNode(NodeKey key);
+		// CPU side of a node, safe to run on a worker thread
+		static Mesh::Data GenerateNode(const Settings& settings, NodeKey key);
+		// Fills selectedNodes with the nodes to draw and missingNodes with the ones worth loading, most wanted first
+		void SelectNodes(const glm::vec3& viewerPosition, std::vector<GameObject::IdT>& selectedNodes, std::vector<NodeKey>& missingNodes);
+		void EvictNodes();
+
+		// moves a loaded node to the front of the LRU list, nullptr when it is not loaded
+		Node* UseNode(const NodeKey& key);
+		float GetNodeSize(int level) const;
+		float GetDistance(const NodeKey& key, const glm::vec3& viewerPosition) const;
+		uint32_t GetNodeTriangleCount() const;
+
+		Device& m_Device;
+		GeometryPool& m_GeometryPool;
+		TaskScheduler& m_Scheduler;
+		const Settings m_Settings;
+
+		// selected nodes first
+		std::vector<GameObject> m_GameObjects;
+		size_t m_SelectedNodeCount{};
+		uint32_t m_TriangleCount{};
+		// most recently used first
+		std::list<Node> m_Nodes;
+		std::unordered_map<NodeKey, std::list<Node>::iterator, NodeKeyHash> m_NodeLookup;
+		std::unordered_set<NodeKey, NodeKeyHash> m_PendingNodes;
+		std::vector<RetiredMesh> m_RetiredMeshes;
+		VkDeviceSize m_MemoryUsage{};
+		uint64_t m_FrameIndex{};
+	};
+}
@@ -0,0 +1,129 @@
+#include "ThreadPool.h"
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace lve
+{
+	ThreadPool::ThreadPool(uint32_t threadCount)
+	{
+		if (threadCount == 0)
+		{
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		m_Workers.reserve(threadCount);
+		for (uint32_t index{}; index < threadCount; ++index)
+		{
+			m_Workers.emplace_back([this]() { WorkerLoop(); });
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_IsStopping = true;
+		}
+		m_Condition.notify_all();
+
+		for (auto& worker : m_Workers)
+		{
+			worker.join();
+		}
+	}
+
+	ThreadPool& ThreadPool::GetShared()
+	{
+		static ThreadPool threadPool{};
+		return threadPool;
+	}
+
+	void ThreadPool::Enqueue(std::function<void()> task)
+	{
+		{
+			std::lock_guard lock{ m_Mutex };
+			m_Tasks.push(std::move(task));
+		}
+		m_Condition.notify_one();
+	}
+
+	void ThreadPool::ParallelFor(uint32_t count, const std::function<void(uint32_t)>& body)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		if (count == 1 || m_Workers.size() <= 1)
+		{
+			for (uint32_t index{}; index < count; ++index)
+			{
+				body(index);
+			}
+			return;
+		}
+
+		// shared so helpers that only start after everything finished never touch a dead stack frame
+		struct Work
+		{
+			const std::function<void(uint32_t)>* pBody;
+			uint32_t count;
+			std::atomic<uint32_t> next{ 0 };
+			std::atomic<uint32_t> finished{ 0 };
+		};
+
+		auto work = std::make_shared<Work>();
+		work->pBody = &body;
+		work->count = count;
+
+		auto runIndices = [](Work& state)
+		{
+			for (uint32_t index = state.next.fetch_add(1); index < state.count; index = state.next.fetch_add(1))
+			{
+				(*state.pBody)(index);
+				if (state.finished.fetch_add(1) + 1 == state.count)
+				{
+					state.finished.notify_all();
+				}
+			}
+		};
+
+		const uint32_t helperCount = std::min(count - 1, static_cast<uint32_t>(m_Workers.size()));
+		for (uint32_t helper{}; helper < helperCount; ++helper)
+		{
+			Enqueue([work, runIndices]() { runIndices(*work); });
+		}
+
+		runIndices(*work);
+
+		for (uint32_t finished = work->finished.load(); finished < count; finished = work->finished.load())
+		{
+			work->finished.wait(finished);
+		}
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock lock{ m_Mutex };
+				m_Condition.wait(lock, [this]() { return m_IsStopping || !m_Tasks.empty(); });
+
+				if (m_IsStopping && m_Tasks.empty())
+				{
+					return;
+				}
+
+				task = std::move(m_Tasks.front());
+				m_Tasks.pop();
+			}
+
+			task();
+		}
+	}
+}
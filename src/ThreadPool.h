@@ -0,0 +1,46 @@
+#pragma once
+
+// std includes
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace lve
+{
+	class ThreadPool final
+	{
+	public:
+		// threadCount 0 uses every hardware thread
+		explicit ThreadPool(uint32_t threadCount = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		ThreadPool& operator=(ThreadPool&&) = delete;
+
+		// Pool shared by the loaders and generators
+		static ThreadPool& GetShared();
+
+		void Enqueue(std::function<void()> task);
+
+		// Calls body(index) for every index in [0, count) and returns once all of them finished.
+		// The calling thread works along, so nesting inside a pool task cannot deadlock.
+		void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& body);
+
+		uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_Workers.size()); }
+
+	private:
+		void WorkerLoop();
+
+		std::vector<std::thread> m_Workers;
+		std::queue<std::function<void()>> m_Tasks;
+		std::mutex m_Mutex;
+		std::condition_variable m_Condition;
+		bool m_IsStopping{ false };
+	};
+}
@@ -0,0 +1,221 @@
+#include "TlsfAllocator.h"
+
+// std
+#include <bit>
+#include <cassert>
+
+namespace lve
+{
+	TlsfAllocator::TlsfAllocator(uint64_t size)
+		: m_Size{ size }
+	{
+		m_FreeHeads.fill(INVALID_NODE);
+		InsertFree(CreateNode(0, size));
+	}
+
+	uint32_t TlsfAllocator::Allocate(uint64_t size, uint64_t alignment)
+	{
+		assert(std::has_single_bit(alignment) && "Alignment has to be a power of two");
+		size = size > 0 ? size : 1;
+
+		// any free range this large has room for the padding in front of the aligned offset
+		const uint32_t node = FindFree(size + alignment - 1);
+		if (node == INVALID_NODE)
+		{
+			return INVALID_NODE;
+		}
+		RemoveFree(node);
+
+		const uint64_t alignedOffset = (m_Nodes[node].offset + alignment - 1) & ~(alignment - 1);
+		const uint64_t padding = alignedOffset - m_Nodes[node].offset;
+		if (padding > 0)
+		{
+			// the physical neighbour before is in use, free ranges never border each other
+			const uint32_t front = CreateNode(m_Nodes[node].offset, padding);
+			LinkPhysical(m_Nodes[node].previousPhysical, front, node);
+			InsertFree(front);
+			m_Nodes[node].offset = alignedOffset;
+			m_Nodes[node].size -= padding;
+		}
+
+		if (m_Nodes[node].size > size)
+		{
+			const uint32_t back = CreateNode(alignedOffset + size, m_Nodes[node].size - size);
+			LinkPhysical(node, back, m_Nodes[node].nextPhysical);
+			InsertFree(back);
+			m_Nodes[node].size = size;
+		}
+
+		m_Nodes[node].isFree = false;
+		m_UsedSize += size;
+		++m_AllocationCount;
+		return node;
+	}
+
+	void TlsfAllocator::Free(uint32_t node)
+	{
+		assert(!m_Nodes[node].isFree && "Range freed twice");
+		m_UsedSize -= m_Nodes[node].size;
+		--m_AllocationCount;
+
+		const uint32_t previous = m_Nodes[node].previousPhysical;
+		if (previous != INVALID_NODE && m_Nodes[previous].isFree)
+		{
+			RemoveFree(previous);
+			m_Nodes[previous].size += m_Nodes[node].size;
+			m_Nodes[previous].nextPhysical = m_Nodes[node].nextPhysical;
+			if (m_Nodes[node].nextPhysical != INVALID_NODE)
+			{
+				m_Nodes[m_Nodes[node].nextPhysical].previousPhysical = previous;
+			}
+			m_UnusedNodes.push_back(node);
+			node = previous;
+		}
+
+		const uint32_t next = m_Nodes[node].nextPhysical;
+		if (next != INVALID_NODE && m_Nodes[next].isFree)
+		{
+			RemoveFree(next);
+			m_Nodes[node].size += m_Nodes[next].size;
+			m_Nodes[node].nextPhysical = m_Nodes[next].nextPhysical;
+			if (m_Nodes[next].nextPhysical != INVALID_NODE)
+			{
+				m_Nodes[m_Nodes[next].nextPhysical].previousPhysical = node;
+			}
+			m_UnusedNodes.push_back(next);
+		}
+
+		InsertFree(node);
+	}
+
+	void TlsfAllocator::GetListIndex(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel)
+	{
+		if (size < SMALL_SIZE)
+		{
+			firstLevel = 0;
+			secondLevel = static_cast<uint32_t>(size / (SMALL_SIZE / SL_COUNT));
+			return;
+		}
+
+		const uint32_t highestBit = static_cast<uint32_t>(std::bit_width(size)) - 1;
+		firstLevel = highestBit - FL_SHIFT + 1;
+		secondLevel = static_cast<uint32_t>(size >> (highestBit - SL_LOG2)) - SL_COUNT;
+	}
+
+	uint32_t TlsfAllocator::FindFree(uint64_t size) const
+	{
+		// round up to the next list start, so every range in the list found is large enough
+		if (size < SMALL_SIZE)
+		{
+			constexpr uint64_t step{ SMALL_SIZE / SL_COUNT };
+			size = (size + step - 1) & ~(step - 1);
+		}
+		else
+		{
+			size += (1ull << (std::bit_width(size) - 1 - SL_LOG2)) - 1;
+		}
+
+		uint32_t firstLevel{};
+		uint32_t secondLevel{};
+		GetListIndex(size, firstLevel, secondLevel);
+		if (firstLevel >= FL_COUNT)
+		{
+			return INVALID_NODE;
+		}
+
+		uint32_t secondLevelMap = secondLevel < SL_COUNT ? m_SecondLevelBitmaps[firstLevel] & (~0u << secondLevel) : 0;
+		if (secondLevelMap == 0)
+		{
+			const uint64_t firstLevelMap = firstLevel + 1 < 64 ? m_FirstLevelBitmap & (~0ull << (firstLevel + 1)) : 0;
+			if (firstLevelMap == 0)
+			{
+				return INVALID_NODE;
+			}
+			firstLevel = static_cast<uint32_t>(std::countr_zero(firstLevelMap));
+			secondLevelMap = m_SecondLevelBitmaps[firstLevel];
+		}
+
+		secondLevel = static_cast<uint32_t>(std::countr_zero(secondLevelMap));
+		return m_FreeHeads[firstLevel * SL_COUNT + secondLevel];
+	}
+
+	void TlsfAllocator::InsertFree(uint32_t node)
+	{
+		uint32_t firstLevel{};
+		uint32_t secondLevel{};
+		GetListIndex(m_Nodes[node].size, firstLevel, secondLevel);
+
+		uint32_t& head = m_FreeHeads[firstLevel * SL_COUNT + secondLevel];
+		m_Nodes[node].isFree = true;
+		m_Nodes[node].previousFree = INVALID_NODE;
+		m_Nodes[node].nextFree = head;
+		if (head != INVALID_NODE)
+		{
+			m_Nodes[head].previousFree = node;
+		}
+		head = node;
+
+		m_FirstLevelBitmap |= 1ull << firstLevel;
+		m_SecondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+	}
+
+	void TlsfAllocator::RemoveFree(uint32_t node)
+	{
+		uint32_t firstLevel{};
+		uint32_t secondLevel{};
+		GetListIndex(m_Nodes[node].size, firstLevel, secondLevel);
+
+		const Node& removed = m_Nodes[node];
+		if (removed.previousFree != INVALID_NODE)
+		{
+			m_Nodes[removed.previousFree].nextFree = removed.nextFree;
+		}
+		else
+		{
+			m_FreeHeads[firstLevel * SL_COUNT + secondLevel] = removed.nextFree;
+		}
+		if (removed.nextFree != INVALID_NODE)
+		{
+			m_Nodes[removed.nextFree].previousFree = removed.previousFree;
+		}
+		m_Nodes[node].isFree = false;
+
+		if (m_FreeHeads[firstLevel * SL_COUNT + secondLevel] == INVALID_NODE)
+		{
+			m_SecondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+			if (m_SecondLevelBitmaps[firstLevel] == 0)
+			{
+				m_FirstLevelBitmap &= ~(1ull << firstLevel);
+			}
+		}
+	}
+
+	uint32_t TlsfAllocator::CreateNode(uint64_t offset, uint64_t size)
+	{
+		const Node node{ offset, size, INVALID_NODE, INVALID_NODE, INVALID_NODE, INVALID_NODE, false };
+		if (!m_UnusedNodes.empty())
+		{
+			const uint32_t index = m_UnusedNodes.back();
+			m_UnusedNodes.pop_back();
+			m_Nodes[index] = node;
+			return index;
+		}
+
+		m_Nodes.push_back(node);
+		return static_cast<uint32_t>(m_Nodes.size() - 1);
+	}
+
+	void TlsfAllocator::LinkPhysical(uint32_t previous, uint32_t node, uint32_t next)
+	{
+		m_Nodes[node].previousPhysical = previous;
+		m_Nodes[node].nextPhysical = next;
+		if (previous != INVALID_NODE)
+		{
+			m_Nodes[previous].nextPhysical = node;
+		}
+		if (next != INVALID_NODE)
+		{
+			m_Nodes[next].previousPhysical = node;
+		}
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+// std includes
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace lve
+{
+	// Two level segregated fit allocator over a range of offsets, it never touches the memory itself.
+	// Free ranges sit in lists by size class, two bitmaps find a large enough class in constant time and freed ranges
+	// merge with free neighbours right away. Not thread safe.
+	class TlsfAllocator final
+	{
+	public:
+		static constexpr uint32_t INVALID_NODE{ UINT32_MAX };
+
+		explicit TlsfAllocator(uint64_t size);
+		~TlsfAllocator() = default;
+
+		TlsfAllocator(const TlsfAllocator&) = delete;
+		TlsfAllocator(TlsfAllocator&&) = delete;
+		TlsfAllocator& operator=(const TlsfAllocator&) = delete;
+		TlsfAllocator& operator=(TlsfAllocator&&) = delete;
+
+		// Takes size bytes at a multiple of alignment, a power of two. Returns INVALID_NODE when no free range fits.
+		uint32_t Allocate(uint64_t size, uint64_t alignment);
+		void Free(uint32_t node);
+
+		uint64_t GetOffset(uint32_t node) const { return m_Nodes[node].offset; }
+		uint64_t GetSize() const { return m_Size; }
+		uint64_t GetUsedSize() const { return m_UsedSize; }
+		uint32_t GetAllocationCount() const { return m_AllocationCount; }
+		bool IsEmpty() const { return m_AllocationCount == 0; }
+
+	private:
+		// every power of two size class splits into SL_COUNT lists, sizes below SMALL_SIZE share the first class
+		static constexpr uint32_t SL_LOG2{ 5 };
+		static constexpr uint32_t SL_COUNT{ 1u << SL_LOG2 };
+		static constexpr uint32_t FL_SHIFT{ SL_LOG2 + 3 };
+		static constexpr uint64_t SMALL_SIZE{ 1ull << FL_SHIFT };
+		static constexpr uint32_t FL_COUNT{ 64 - FL_SHIFT + 1 };
+
+		// a range of the allocator, neighbours in offset order are linked, free ranges also in their size list
+		struct Node
+		{
+			uint64_t offset;
+			uint64_t size;
+			uint32_t previousPhysical;
+			uint32_t nextPhysical;
+			uint32_t previousFree;
+			uint32_t nextFree;
+			bool isFree;
+		};
+
+		static void GetListIndex(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel);
+		// a free node of at least size bytes, INVALID_NODE when there is none
+		uint32_t FindFree(uint64_t size) const;
+		void InsertFree(uint32_t node);
+		void RemoveFree(uint32_t node);
+		uint32_t CreateNode(uint64_t offset, uint64_t size);
+		// links node in between its neighbours in offset order, either may be INVALID_NODE
+		void LinkPhysical(uint32_t previous, uint32_t node, uint32_t next);
+
+		const uint64_t m_Size;
+		uint64_t m_UsedSize{};
+		uint32_t m_AllocationCount{};
+
+		std::vector<Node> m_Nodes;
+		std::vector<uint32_t> m_UnusedNodes;
+		uint64_t m_FirstLevelBitmap{};
+		std::array<uint32_t, FL_COUNT> m_SecondLevelBitmaps{};
+		std::array<uint32_t, FL_COUNT * SL_COUNT> m_FreeHeads;
+	};
+}
@@ -0,0 +1,508 @@
+#include "Uploader.h"
+
+// std
+#include <cstring>
+#include <stdexcept>
+
+namespace lve
+{
+	static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	Uploader::Uploader(Device& device)
+		: m_Device{ device }
+		, m_IsDedicated{ device.HasDedicatedTransferQueue() }
+		, m_TransferFamily{ device.GetTransferFamily() }
+		, m_GraphicsFamily{ device.FindPhysicalQueueFamilies().graphicsFamily }
+	{
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = m_TransferFamily;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+		if (vkCreateCommandPool(m_Device.GetDevice(), &poolInfo, nullptr, &m_CommandPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create upload command pool!");
+		}
+
+		if (m_IsDedicated)
+		{
+			poolInfo.queueFamilyIndex = m_GraphicsFamily;
+			if (vkCreateCommandPool(m_Device.GetDevice(), &poolInfo, nullptr, &m_AcquireCommandPool) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create upload acquire command pool!");
+			}
+		}
+
+		m_pRing = std::make_unique<Buffer>
+		(
+			m_Device,
+			RING_SIZE,
+			1,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+		);
+		m_pRing->Map();
+
+		m_OpenBatch.ticket = 1;
+	}
+
+	Uploader::~Uploader()
+	{
+		// a batch still open records copies into resources that may already be gone, it is dropped instead of submitted,
+		// its command buffers go with the pools
+		m_OpenBatch.ownStagingBuffers.clear();
+		m_BufferReleases.clear();
+		m_ImageReleases.clear();
+		while (!m_SubmittedBatches.empty())
+		{
+			Retire(true);
+		}
+
+		const VkDevice device = m_Device.GetDevice();
+		for (VkFence fence : m_FreeFences)
+		{
+			vkDestroyFence(device, fence, nullptr);
+		}
+		for (VkSemaphore semaphore : m_FreeSemaphores)
+		{
+			vkDestroySemaphore(device, semaphore, nullptr);
+		}
+		// destroying the pools frees their command buffers
+		vkDestroyCommandPool(device, m_CommandPool, nullptr);
+		if (m_AcquireCommandPool != VK_NULL_HANDLE)
+		{
+			vkDestroyCommandPool(device, m_AcquireCommandPool, nullptr);
+		}
+	}
+
+	Uploader::Ticket Uploader::UploadBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* pData, VkDeviceSize size)
+	{
+		return Upload(pData, size, [this, dstBuffer, dstOffset, size](VkCommandBuffer commandBuffer, VkBuffer stagingBuffer, VkDeviceSize stagingOffset)
+		{
+			VkBufferCopy copyRegion{};
+			copyRegion.srcOffset = stagingOffset;
+			copyRegion.dstOffset = dstOffset;
+			copyRegion.size = size;
+			vkCmdCopyBuffer(commandBuffer, stagingBuffer, dstBuffer, 1, &copyRegion);
+			ReleaseBuffer(dstBuffer, dstOffset, size);
+		});
+	}
+
+	Uploader::Ticket Uploader::Upload(const void* pData, VkDeviceSize size, const RecordFunction& record)
+	{
+		// staging first, it may submit the open batch to make room
+		VkBuffer stagingBuffer{ VK_NULL_HANDLE };
+		VkDeviceSize stagingOffset{};
+		Stage(pData, size, stagingBuffer, stagingOffset);
+
+		record(GetOpenCommandBuffer(), stagingBuffer, stagingOffset);
+		return m_OpenBatch.ticket;
+	}
+
+	Uploader::Ticket Uploader::UploadImage(VkImage image, VkExtent3D extent, const void* pData, VkDeviceSize size)
+	{
+		return Upload(pData, size, [this, image, extent](VkCommandBuffer commandBuffer, VkBuffer stagingBuffer, VkDeviceSize stagingOffset)
+		{
+			// every texel is replaced, so the old contents are discarded once earlier commands on this queue are done
+			VkImageMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = image;
+			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			barrier.subresourceRange.baseMipLevel = 0;
+			barrier.subresourceRange.levelCount = 1;
+			barrier.subresourceRange.baseArrayLayer = 0;
+			barrier.subresourceRange.layerCount = 1;
+			vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+			VkBufferImageCopy region{};
+			region.bufferOffset = stagingOffset;
+			region.bufferRowLength = 0;
+			region.bufferImageHeight = 0;
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.mipLevel = 0;
+			region.imageSubresource.baseArrayLayer = 0;
+			region.imageSubresource.layerCount = 1;
+			region.imageOffset = { 0, 0, 0 };
+			region.imageExtent = extent;
+			vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+			// the move to SHADER_READ_ONLY_OPTIMAL happens with the barrier at the end of the batch
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			m_ImageReleases.push_back(barrier);
+		});
+	}
+
+	Uploader::Ticket Uploader::Record(const std::function<void(VkCommandBuffer commandBuffer)>& record)
+	{
+		record(GetOpenCommandBuffer());
+		return m_OpenBatch.ticket;
+	}
+
+	void Uploader::ReleaseBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size)
+	{
+		// on the graphics queue one memory barrier covers every buffer
+		if (!m_IsDedicated)
+		{
+			return;
+		}
+
+		VkBufferMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.buffer = buffer;
+		barrier.offset = offset;
+		barrier.size = size;
+		m_BufferReleases.push_back(barrier);
+	}
+
+	void Uploader::Submit()
+	{
+		if (m_IsOpenBatchEmpty)
+		{
+			return;
+		}
+
+		if (m_IsDedicated)
+		{
+			RecordOwnershipTransfer();
+		}
+		else
+		{
+			RecordGraphicsBarrier();
+		}
+		m_BufferReleases.clear();
+		m_ImageReleases.clear();
+
+		if (vkEndCommandBuffer(m_OpenBatch.commandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to record upload command buffer!");
+		}
+
+		const VkDevice device = m_Device.GetDevice();
+		if (m_FreeFences.empty())
+		{
+			VkFenceCreateInfo fenceInfo{};
+			fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+			VkFence fence;
+			if (vkCreateFence(device, &fenceInfo, nullptr, &fence) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create upload fence!");
+			}
+			m_FreeFences.push_back(fence);
+		}
+		m_OpenBatch.fence = m_FreeFences.back();
+		m_FreeFences.pop_back();
+		m_OpenBatch.ringEnd = m_Head;
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &m_OpenBatch.commandBuffer;
+		if (!m_IsDedicated)
+		{
+			if (vkQueueSubmit(m_Device.GraphicsQueue(), 1, &submitInfo, m_OpenBatch.fence) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to submit uploads!");
+			}
+		}
+		else
+		{
+			if (m_FreeSemaphores.empty())
+			{
+				VkSemaphoreCreateInfo semaphoreInfo{};
+				semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+				VkSemaphore semaphore;
+				if (vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+				{
+					throw std::runtime_error("failed to create upload semaphore!");
+				}
+				m_FreeSemaphores.push_back(semaphore);
+			}
+			m_OpenBatch.semaphore = m_FreeSemaphores.back();
+			m_FreeSemaphores.pop_back();
+
+			submitInfo.signalSemaphoreCount = 1;
+			submitInfo.pSignalSemaphores = &m_OpenBatch.semaphore;
+			if (vkQueueSubmit(m_Device.TransferQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to submit uploads!");
+			}
+
+			// only the stages reading uploads wait, and the fence covers both submissions
+			const VkPipelineStageFlags waitStage = CONSUMER_STAGES;
+			VkSubmitInfo acquireInfo{};
+			acquireInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			acquireInfo.waitSemaphoreCount = 1;
+			acquireInfo.pWaitSemaphores = &m_OpenBatch.semaphore;
+			acquireInfo.pWaitDstStageMask = &waitStage;
+			acquireInfo.commandBufferCount = 1;
+			acquireInfo.pCommandBuffers = &m_OpenBatch.acquireCommandBuffer;
+			if (vkQueueSubmit(m_Device.GraphicsQueue(), 1, &acquireInfo, m_OpenBatch.fence) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to submit upload acquire!");
+			}
+		}
+		++m_SubmitCount;
+
+		const Ticket nextTicket = m_OpenBatch.ticket + 1;
+		m_SubmittedBatches.push_back(std::move(m_OpenBatch));
+		m_OpenBatch = Batch{};
+		m_OpenBatch.ticket = nextTicket;
+		m_IsOpenBatchEmpty = true;
+	}
+
+	bool Uploader::IsComplete(Ticket ticket)
+	{
+		// nothing else might submit it, polling an open ticket would never finish
+		if (ticket == m_OpenBatch.ticket)
+		{
+			Submit();
+		}
+		Retire(false);
+		return ticket <= m_CompletedTicket;
+	}
+
+	void Uploader::Wait(Ticket ticket)
+	{
+		if (ticket == m_OpenBatch.ticket)
+		{
+			Submit();
+		}
+		while (ticket > m_CompletedTicket && !m_SubmittedBatches.empty())
+		{
+			Retire(true);
+		}
+	}
+
+	void Uploader::WaitIdle()
+	{
+		Submit();
+		while (!m_SubmittedBatches.empty())
+		{
+			Retire(true);
+		}
+	}
+
+	void Uploader::Stage(const void* pData, VkDeviceSize size, VkBuffer& stagingBuffer, VkDeviceSize& stagingOffset)
+	{
+		if (size > RING_SIZE / 4)
+		{
+			// would stall the ring for too long, the buffer goes away with the batch
+			auto pBuffer = std::make_unique<Buffer>
+			(
+				m_Device,
+				size,
+				1,
+				VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+			);
+			pBuffer->Map();
+			pBuffer->WriteToBuffer(const_cast<void*>(pData));
+
+			stagingBuffer = pBuffer->GetBuffer();
+			stagingOffset = 0;
+			m_OpenBatch.ownStagingBuffers.push_back(std::move(pBuffer));
+			return;
+		}
+
+		stagingBuffer = m_pRing->GetBuffer();
+		stagingOffset = AllocateRing(size);
+		std::memcpy(static_cast<char*>(m_pRing->GetMappedMemory()) + stagingOffset, pData, size);
+	}
+
+	VkDeviceSize Uploader::AllocateRing(VkDeviceSize size)
+	{
+		size = AlignUp(size > 0 ? size : 1, STAGING_ALIGNMENT);
+
+		VkDeviceSize offset{};
+		while (!TryAllocateRing(size, offset))
+		{
+			// the open batch holds the rest of the ring, it has to go before its space can come back
+			if (m_SubmittedBatches.empty())
+			{
+				Submit();
+			}
+			Retire(true);
+		}
+		return offset;
+	}
+
+	bool Uploader::TryAllocateRing(VkDeviceSize size, VkDeviceSize& offset)
+	{
+		const VkDeviceSize alignedHead = AlignUp(m_Head, STAGING_ALIGNMENT);
+		if (m_Head >= m_Tail)
+		{
+			if (alignedHead + size <= RING_SIZE)
+			{
+				offset = alignedHead;
+				m_Head = offset + size;
+				return true;
+			}
+
+			// wrap around, head must stay below tail so a full ring never looks empty
+			if (size < m_Tail)
+			{
+				offset = 0;
+				m_Head = size;
+				return true;
+			}
+			return false;
+		}
+
+		if (alignedHead + size < m_Tail)
+		{
+			offset = alignedHead;
+			m_Head = offset + size;
+			return true;
+		}
+		return false;
+	}
+
+	VkCommandBuffer Uploader::GetOpenCommandBuffer()
+	{
+		if (!m_IsOpenBatchEmpty)
+		{
+			return m_OpenBatch.commandBuffer;
+		}
+
+		const VkDevice device = m_Device.GetDevice();
+		m_OpenBatch.commandBuffer = TakeCommandBuffer(device, m_CommandPool, m_FreeCommandBuffers);
+		m_OpenBatch.acquireCommandBuffer = m_IsDedicated ? TakeCommandBuffer(device, m_AcquireCommandPool, m_FreeAcquireCommandBuffers) : VK_NULL_HANDLE;
+
+		m_IsOpenBatchEmpty = false;
+		return m_OpenBatch.commandBuffer;
+	}
+
+	void Uploader::RecordOwnershipTransfer()
+	{
+		// the release half ends the transfer batch, the acquire half with identical barriers runs on the graphics queue
+		for (VkBufferMemoryBarrier& barrier : m_BufferReleases)
+		{
+			barrier.srcQueueFamilyIndex = m_TransferFamily;
+			barrier.dstQueueFamilyIndex = m_GraphicsFamily;
+		}
+		for (VkImageMemoryBarrier& barrier : m_ImageReleases)
+		{
+			barrier.dstAccessMask = 0;
+			barrier.srcQueueFamilyIndex = m_TransferFamily;
+			barrier.dstQueueFamilyIndex = m_GraphicsFamily;
+		}
+		const auto bufferCount = static_cast<uint32_t>(m_BufferReleases.size());
+		const auto imageCount = static_cast<uint32_t>(m_ImageReleases.size());
+		if (bufferCount + imageCount > 0)
+		{
+			vkCmdPipelineBarrier(m_OpenBatch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+				0, 0, nullptr, bufferCount, m_BufferReleases.data(), imageCount, m_ImageReleases.data());
+		}
+
+		for (VkBufferMemoryBarrier& barrier : m_BufferReleases)
+		{
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = CONSUMER_ACCESS;
+		}
+		for (VkImageMemoryBarrier& barrier : m_ImageReleases)
+		{
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		}
+		if (bufferCount + imageCount > 0)
+		{
+			vkCmdPipelineBarrier(m_OpenBatch.acquireCommandBuffer, CONSUMER_STAGES, CONSUMER_STAGES,
+				0, 0, nullptr, bufferCount, m_BufferReleases.data(), imageCount, m_ImageReleases.data());
+		}
+
+		if (vkEndCommandBuffer(m_OpenBatch.acquireCommandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to record upload acquire command buffer!");
+		}
+	}
+
+	void Uploader::RecordGraphicsBarrier()
+	{
+		// one barrier for the whole batch, anything submitted after it reads the uploaded data
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = CONSUMER_ACCESS;
+		for (VkImageMemoryBarrier& imageBarrier : m_ImageReleases)
+		{
+			imageBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		}
+		vkCmdPipelineBarrier(m_OpenBatch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, CONSUMER_STAGES,
+			0, 1, &barrier, 0, nullptr, static_cast<uint32_t>(m_ImageReleases.size()), m_ImageReleases.data());
+	}
+
+	VkCommandBuffer Uploader::TakeCommandBuffer(VkDevice device, VkCommandPool commandPool, std::vector<VkCommandBuffer>& freeCommandBuffers)
+	{
+		if (freeCommandBuffers.empty())
+		{
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandPool = commandPool;
+			allocInfo.commandBufferCount = 1;
+
+			VkCommandBuffer commandBuffer;
+			if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to allocate upload command buffer!");
+			}
+			freeCommandBuffers.push_back(commandBuffer);
+		}
+		const VkCommandBuffer commandBuffer = freeCommandBuffers.back();
+		freeCommandBuffers.pop_back();
+
+		// beginning implicitly resets a buffer from a finished batch
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to begin upload command buffer!");
+		}
+		return commandBuffer;
+	}
+
+	void Uploader::Retire(bool isBlocking)
+	{
+		const VkDevice device = m_Device.GetDevice();
+		if (isBlocking && !m_SubmittedBatches.empty())
+		{
+			vkWaitForFences(device, 1, &m_SubmittedBatches.front().fence, VK_TRUE, UINT64_MAX);
+		}
+
+		// batches finish in submission order, the first one still running ends the search
+		while (!m_SubmittedBatches.empty() && vkGetFenceStatus(device, m_SubmittedBatches.front().fence) == VK_SUCCESS)
+		{
+			Batch& batch = m_SubmittedBatches.front();
+			vkResetFences(device, 1, &batch.fence);
+			m_FreeFences.push_back(batch.fence);
+			m_FreeCommandBuffers.push_back(batch.commandBuffer);
+			if (m_IsDedicated)
+			{
+				m_FreeAcquireCommandBuffers.push_back(batch.acquireCommandBuffer);
+				m_FreeSemaphores.push_back(batch.semaphore);
+			}
+			m_Tail = batch.ringEnd;
+			m_CompletedTicket = batch.ticket;
+			m_SubmittedBatches.pop_front();
+		}
+
+		// an idle ring starts over at the front, so the next uploads do not wrap
+		if (m_SubmittedBatches.empty() && m_IsOpenBatchEmpty)
+		{
+			m_Head = 0;
+			m_Tail = 0;
+		}
+	}
+}
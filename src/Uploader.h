@@ -0,0 +1,128 @@
+#pragma once
+#include "Device.h"
+#include "Buffer.h"
+
+//libs
+#include <vulkan/vulkan.h>
+
+// std includes
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace lve
+{
+	// Moves data into device local buffers and images through one persistently mapped staging ring. Copies collect in
+	// an open batch that goes to the GPU in a single submission, the application submits it once per frame before the
+	// frame itself so draws recorded that frame see the data. Every batch has a fence, ring space is reused once the
+	// fence of the batch that used it signaled. Uploads larger than a quarter of the ring get a staging buffer of their
+	// own that lives as long as their batch. Main thread only.
+	// Batches run on the dedicated transfer queue when the device has one. The written ranges are then released to the
+	// graphics family at the end of the batch and acquired by a small graphics submission that waits for it, so the
+	// copies overlap with frames still rendering. Without one everything runs on the graphics queue.
+	class Uploader final
+	{
+	public:
+		// the batch an upload went into, batches complete in order
+		using Ticket = uint64_t;
+		// records the commands that read the staged data at stagingOffset of stagingBuffer
+		using RecordFunction = std::function<void(VkCommandBuffer commandBuffer, VkBuffer stagingBuffer, VkDeviceSize stagingOffset)>;
+
+		static constexpr VkDeviceSize RING_SIZE{ 32 * 1024 * 1024 };
+
+		explicit Uploader(Device& device);
+		// waits for the submitted batches and drops the open one, call WaitIdle first to keep it
+		~Uploader();
+
+		Uploader(const Uploader&) = delete;
+		Uploader(Uploader&&) = delete;
+		Uploader& operator=(const Uploader&) = delete;
+		Uploader& operator=(Uploader&&) = delete;
+
+		// Stages size bytes of data and records copying them to dstBuffer at dstOffset
+		Ticket UploadBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* pData, VkDeviceSize size);
+		// Stages size bytes of data and lets record add the commands that read them, for images and layout transitions
+		Ticket Upload(const void* pData, VkDeviceSize size, const RecordFunction& record);
+		// Stages the data and copies it into mip 0 and layer 0 of a color image, which ends up in
+		// SHADER_READ_ONLY_OPTIMAL. The old contents are discarded, no frame in flight may still read the image.
+		Ticket UploadImage(VkImage image, VkExtent3D extent, const void* pData, VkDeviceSize size);
+		// Records commands that stage nothing, whatever they read has to live until the ticket completes
+		Ticket Record(const std::function<void(VkCommandBuffer commandBuffer)>& record);
+		// Hands a buffer range written by commands of Upload or Record over to the graphics queue
+		void ReleaseBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size);
+
+		// Submits the open batch when it holds anything
+		void Submit();
+		// Polls the fences, true once every command of the ticket ran, submits the ticket if it is still open
+		bool IsComplete(Ticket ticket);
+		// Blocking mode, submits the ticket if it is still open and waits for it
+		void Wait(Ticket ticket);
+		// Submits the open batch and waits for every batch
+		void WaitIdle();
+
+		uint32_t GetSubmitCount() const { return m_SubmitCount; }
+
+	private:
+		struct Batch
+		{
+			Ticket ticket;
+			VkCommandBuffer commandBuffer;
+			// graphics side of a dedicated transfer queue batch, waits for semaphore and acquires what it released
+			VkCommandBuffer acquireCommandBuffer;
+			VkSemaphore semaphore;
+			VkFence fence;
+			// ring offset right after the last byte this batch staged
+			VkDeviceSize ringEnd;
+			std::vector<std::unique_ptr<Buffer>> ownStagingBuffers;
+		};
+
+		// Copies the data into the ring or an own buffer of the open batch and returns where it ended up
+		void Stage(const void* pData, VkDeviceSize size, VkBuffer& stagingBuffer, VkDeviceSize& stagingOffset);
+		// a ring offset with size free bytes, submits and waits for old batches when the ring is full
+		VkDeviceSize AllocateRing(VkDeviceSize size);
+		bool TryAllocateRing(VkDeviceSize size, VkDeviceSize& offset);
+		VkCommandBuffer GetOpenCommandBuffer();
+		// release and acquire barriers, or one barrier on the graphics queue, for everything the open batch wrote
+		void RecordOwnershipTransfer();
+		void RecordGraphicsBarrier();
+		static VkCommandBuffer TakeCommandBuffer(VkDevice device, VkCommandPool commandPool, std::vector<VkCommandBuffer>& freeCommandBuffers);
+		// frees the ring space and staging buffers of finished batches, waits for the oldest one when isBlocking
+		void Retire(bool isBlocking);
+
+		static constexpr VkDeviceSize STAGING_ALIGNMENT{ 16 };
+		// everything that reads uploaded data on the graphics queue
+		static constexpr VkPipelineStageFlags CONSUMER_STAGES{ VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT
+			| VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT };
+		static constexpr VkAccessFlags CONSUMER_ACCESS{ VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT
+			| VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT
+			| VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT };
+
+		Device& m_Device;
+		const bool m_IsDedicated;
+		uint32_t m_TransferFamily;
+		uint32_t m_GraphicsFamily;
+		VkCommandPool m_CommandPool;
+		// graphics family pool for the acquire command buffers, only with a dedicated transfer queue
+		VkCommandPool m_AcquireCommandPool{ VK_NULL_HANDLE };
+		std::unique_ptr<Buffer> m_pRing;
+		// bytes in use run from tail to head, wrapping at the end of the ring
+		VkDeviceSize m_Head{};
+		VkDeviceSize m_Tail{};
+
+		Batch m_OpenBatch{};
+		bool m_IsOpenBatchEmpty{ true };
+		// ranges the open batch hands to the graphics queue, images also change layout on the way
+		std::vector<VkBufferMemoryBarrier> m_BufferReleases;
+		std::vector<VkImageMemoryBarrier> m_ImageReleases;
+		std::deque<Batch> m_SubmittedBatches;
+		// finished command buffers and fences, reset and used again
+		std::vector<VkCommandBuffer> m_FreeCommandBuffers;
+		std::vector<VkCommandBuffer> m_FreeAcquireCommandBuffers;
+		std::vector<VkSemaphore> m_FreeSemaphores;
+		std::vector<VkFence> m_FreeFences;
+		Ticket m_CompletedTicket{};
+		uint32_t m_SubmitCount{};
+	};
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <cstring>
 #include <functional>
 
 namespace lve
@@ -10,5 +12,41 @@ namespace lve
 		seed ^= std::hash<T>{}(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
 		(HashCombine(seed, rest), ...);
 	};
-}
 
+	// murmur3 finalizer
+	inline uint64_t MixBits(uint64_t value)
+	{
+		value ^= value >> 33;
+		value *= 0xff51afd7ed558ccdull;
+		value ^= value >> 33;
+		value *= 0xc4ceb9fe1a85ec53ull;
+		value ^= value >> 33;
+		return value;
+	}
+
+	// Hashes raw bytes eight at a time, fast enough to fingerprint whole files
+	inline uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 0)
+	{
+		constexpr uint64_t prime{ 0x9e3779b97f4a7c15ull };
+		const auto* bytes = static_cast<const unsigned char*>(data);
+		uint64_t hash = seed ^ (size * prime);
+
+		while (size >= 8)
+		{
+			uint64_t word;
+			std::memcpy(&word, bytes, 8);
+			hash = (hash ^ MixBits(word)) * prime;
+			bytes += 8;
+			size -= 8;
+		}
+
+		if (size > 0)
+		{
+			uint64_t word{};
+			std::memcpy(&word, bytes, size);
+			hash = (hash ^ MixBits(word)) * prime;
+		}
+
+		return MixBits(hash);
+	}
+}
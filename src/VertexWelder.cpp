@@ -0,0 +1,126 @@
+#include "VertexWelder.h"
+#include "Utils.h"
+
+// std
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace lve
+{
+	static_assert(sizeof(Mesh::Vertex) == 11 * sizeof(float), "VertexWelder hashes the vertex as 11 tightly packed floats");
+
+	VertexWelder::VertexWelder(std::vector<Mesh::Vertex>& vertices, size_t expectedCount, float epsilon)
+		: m_Vertices{ vertices }
+		, m_InverseEpsilon{ epsilon > 0.f ? 1.f / epsilon : 0.f }
+	{
+		// keep the load factor at or below one half
+		const size_t capacity = std::bit_ceil(std::max<size_t>(expectedCount * 2, 16));
+		m_Slots.assign(capacity, Slot{ EMPTY_SLOT, 0 });
+		m_Mask = capacity - 1;
+
+		m_Vertices.reserve(m_Vertices.size() + expectedCount);
+	}
+
+	uint32_t VertexWelder::Weld(const Mesh::Vertex& vertex)
+	{
+		const Key key = MakeKey(vertex);
+		const uint64_t hash = HashBytes(&key, sizeof(Key));
+		const uint32_t tag = static_cast<uint32_t>(hash >> 32);
+
+		for (size_t slotIndex = hash & m_Mask; ; slotIndex = (slotIndex + 1) & m_Mask)
+		{
+			Slot& slot = m_Slots[slotIndex];
+
+			if (slot.index == EMPTY_SLOT)
+			{
+				slot.index = static_cast<uint32_t>(m_Vertices.size());
+				slot.tag = tag;
+				m_Vertices.push_back(vertex);
+
+				const uint32_t index = slot.index;
+				if (m_Vertices.size() * 2 > m_Slots.size())
+				{
+					Grow();
+				}
+				return index;
+			}
+
+			if (slot.tag == tag && IsMatch(m_Vertices[slot.index], key))
+			{
+				++m_Stats.reusedCount;
+				if (!(m_Vertices[slot.index] == vertex))
+				{
+					++m_Stats.mergedCount;
+				}
+				return slot.index;
+			}
+		}
+	}
+
+	VertexWelder::Key VertexWelder::MakeKey(const Mesh::Vertex& vertex) const
+	{
+		float components[COMPONENT_COUNT];
+		std::memcpy(components, &vertex, sizeof(Mesh::Vertex));
+
+		Key key;
+		for (size_t index{}; index < COMPONENT_COUNT; ++index)
+		{
+			if (m_InverseEpsilon > 0.f)
+			{
+				const double cell = std::floor(static_cast<double>(components[index]) * m_InverseEpsilon);
+				key.components[index] = static_cast<int32_t>(std::clamp(cell, static_cast<double>(INT32_MIN), static_cast<double>(INT32_MAX)));
+			}
+			else
+			{
+				// adding zero turns -0 into +0, which compare equal and so have to hash equal
+				key.components[index] = std::bit_cast<int32_t>(components[index] + 0.f);
+			}
+		}
+		return key;
+	}
+
+	bool VertexWelder::IsMatch(const Mesh::Vertex& stored, const Key& key) const
+	{
+		if (m_InverseEpsilon > 0.f)
+		{
+			const Key storedKey = MakeKey(stored);
+			return std::memcmp(&storedKey, &key, sizeof(Key)) == 0;
+		}
+
+		// compares as floats, so NaN never welds, exactly like Vertex::operator==
+		float components[COMPONENT_COUNT];
+		std::memcpy(components, &stored, sizeof(Mesh::Vertex));
+		for (size_t index{}; index < COMPONENT_COUNT; ++index)
+		{
+			if (components[index] != std::bit_cast<float>(key.components[index]))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void VertexWelder::Grow()
+	{
+		std::vector<Slot> oldSlots = std::move(m_Slots);
+		m_Slots.assign(oldSlots.size() * 2, Slot{ EMPTY_SLOT, 0 });
+		m_Mask = m_Slots.size() - 1;
+
+		for (const Slot& oldSlot : oldSlots)
+		{
+			if (oldSlot.index == EMPTY_SLOT)
+			{
+				continue;
+			}
+
+			const Key key = MakeKey(m_Vertices[oldSlot.index]);
+			size_t slotIndex = HashBytes(&key, sizeof(Key)) & m_Mask;
+			while (m_Slots[slotIndex].index != EMPTY_SLOT)
+			{
+				slotIndex = (slotIndex + 1) & m_Mask;
+			}
+			m_Slots[slotIndex] = oldSlot;
+		}
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "Mesh.h"
+
+// std includes
+#include <cstdint>
+#include <vector>
+
+namespace lve
+{
+	// Deduplicates vertices while a mesh is built. Vertices are hashed as raw bytes into a flat open addressing table,
+	// so every corner costs a single probe sequence instead of the count + insert + lookup of an unordered_map.
+	// With an epsilon above zero, vertices whose attributes fall in the same epsilon sized cell are welded as well.
+	class VertexWelder final
+	{
+	public:
+		struct Stats
+		{
+			// corners that reused an existing vertex
+			uint32_t reusedCount;
+			// reused corners that only matched within epsilon, these are the near identical vertices that got merged
+			uint32_t mergedCount;
+		};
+
+		// expectedCount is an upper bound on the unique vertices, the index count of the mesh is always enough
+		VertexWelder(std::vector<Mesh::Vertex>& vertices, size_t expectedCount, float epsilon = 0.f);
+		~VertexWelder() = default;
+
+		VertexWelder(const VertexWelder&) = delete;
+		VertexWelder(VertexWelder&&) = delete;
+		VertexWelder& operator=(const VertexWelder&) = delete;
+		VertexWelder& operator=(VertexWelder&&) = delete;
+
+		// Returns the index of an equal vertex, appending this one when there is none yet
+		uint32_t Weld(const Mesh::Vertex& vertex);
+
+		const Stats& GetStats() const { return m_Stats; }
+
+	private:
+		static constexpr uint32_t EMPTY_SLOT{ UINT32_MAX };
+		static constexpr size_t COMPONENT_COUNT{ sizeof(Mesh::Vertex) / sizeof(float) };
+
+		struct Slot
+		{
+			uint32_t index;
+			// upper hash bits, rejects most mismatches without touching the vertex array
+			uint32_t tag;
+		};
+
+		struct Key
+		{
+			int32_t components[COMPONENT_COUNT];
+		};
+
+		Key MakeKey(const Mesh::Vertex& vertex) const;
+		bool IsMatch(const Mesh::Vertex& stored, const Key& key) const;
+		void Grow();
+
+		std::vector<Mesh::Vertex>& m_Vertices;
+		std::vector<Slot> m_Slots;
+		size_t m_Mask;
+		float m_InverseEpsilon;
+		Stats m_Stats{};
+	};
+}
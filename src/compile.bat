@@ -1,3 +1,6 @@
 C:\VulkanSDK\1.3.275.0\Bin\glslc.exe Shaders\SimpleShader.vert -o Shaders\SimpleShader.vert.spv
 C:\VulkanSDK\1.3.275.0\Bin\glslc.exe Shaders\SimpleShader.frag -o Shaders\SimpleShader.frag.spv
+C:\VulkanSDK\1.3.275.0\Bin\glslc.exe Shaders\PackedShader.vert -o Shaders\PackedShader.vert.spv
+C:\VulkanSDK\1.3.275.0\Bin\glslc.exe Shaders\HeightfieldShader.vert -o Shaders\HeightfieldShader.vert.spv
+C:\VulkanSDK\1.3.275.0\Bin\glslc.exe Shaders\InstancedShader.vert -o Shaders\InstancedShader.vert.spv
 pause
\ No newline at end of file